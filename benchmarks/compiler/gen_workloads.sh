@@ -0,0 +1,130 @@
+#!/bin/bash
+
+# Synthetic Zen C workloads for the compiler benchmark (make bench-compiler).
+# Usage: gen_workloads.sh <out-dir> [scale]
+# Every workload grows linearly with the scale (default 1).
+
+OUT_DIR="${1:?usage: gen_workloads.sh <out-dir> [scale]}"
+SCALE="${2:-1}"
+
+mkdir -p "$OUT_DIR"
+
+# N structs, each with an impl of a few methods.
+gen_structs() {
+    local n=$((500 * SCALE))
+    {
+        for ((i = 0; i < n; i++)); do
+            printf 'struct S%d {\n    a: int;\n    b: float;\n    name: char*;\n}\n\n' $i
+            printf 'impl S%d {\n' $i
+            printf '    fn new(a: int) -> S%d {\n        return S%d { a: a, b: 1.5, name: "s%d" };\n    }\n' $i $i $i
+            printf '    fn sum(self) -> int {\n        return self.a * %d + (self.a / 3);\n    }\n' $i
+            printf '    fn scale(self, k: int) -> S%d {\n        return S%d { a: self.a * k, b: self.b * 2.0, name: self.name };\n    }\n' $i $i
+            printf '}\n\n'
+        done
+        printf 'fn main() {\n    let total = 0;\n'
+        for ((i = 0; i < n; i++)); do
+            printf '    total = total + S%d::new(%d).scale(2).sum();\n' $i $i
+        done
+        printf '    println "{total}";\n}\n'
+    } > "$OUT_DIR/structs.zc"
+}
+
+# Generic containers nested several levels deep over std/vec.zc and std/map.zc.
+gen_generics() {
+    local n=$((150 * SCALE))
+    {
+        printf 'import "std/vec.zc"\nimport "std/map.zc"\nimport "std/option.zc"\n\n'
+        for ((i = 0; i < n; i++)); do
+            printf 'struct G%d {\n    id: int;\n    w: int;\n}\n\n' $i
+            printf 'fn g%d(m: Map<Vec<G%d>>*) -> int {\n' $i $i
+            # Locals get unique names: the move checker tracks moved names
+            # across functions.
+            printf '    let v%d = Vec<G%d>::new();\n' $i $i
+            printf '    v%d.push(G%d { id: %d, w: 2 });\n' $i $i $i
+            printf '    let vv%d = Vec<Vec<G%d>>::new();\n' $i $i
+            printf '    vv%d.push(v%d);\n' $i $i
+            printf '    let o%d: Option<Vec<Vec<G%d>>> = Option<Vec<Vec<G%d>>>::Some(vv%d);\n' $i $i $i $i
+            printf '    let inner%d = o%d.unwrap();\n' $i $i
+            printf '    m.put("k%d", inner%d.get(0));\n' $i $i
+            printf '    return inner%d.get(0).get(0).id + inner%d.get(0).get(0).w;\n}\n\n' $i $i
+        done
+        printf 'fn main() {\n    let total = 0;\n'
+        for ((i = 0; i < n; i++)); do
+            printf '    let m%d = Map<Vec<G%d>>::new();\n    total = total + g%d(&m%d);\n' $i $i $i $i
+        done
+        printf '    println "{total}";\n}\n'
+    } > "$OUT_DIR/generics.zc"
+}
+
+# Many lambdas, both arrow and block form, some capturing.
+gen_lambdas() {
+    local n=$((200 * SCALE))
+    {
+        printf 'fn apply(f: fn(int) -> int, x: int) -> int {\n    return f(x);\n}\n\n'
+        for ((i = 0; i < n; i++)); do
+            printf 'fn l%d(k: int) -> int {\n' $i
+            printf '    let a = x -> x + %d;\n' $i
+            printf '    let b = (x, y) -> x * y + k;\n'
+            printf '    let c = fn(x: int) -> int { return x - %d; };\n' $i
+            printf '    let d = apply(x -> x * 2, a(k));\n'
+            printf '    return apply(fn(x: int) -> int { return x + 1; }, b(c(d), 3));\n}\n\n'
+        done
+        printf 'fn main() {\n    let total = 0;\n'
+        for ((i = 0; i < n; i++)); do
+            printf '    total = total + l%d(%d);\n' $i $i
+        done
+        printf '    println "{total}";\n}\n'
+    } > "$OUT_DIR/lambdas.zc"
+}
+
+# Large match statements over integers and strings.
+gen_match() {
+    local fns=$((20 * SCALE))
+    local arms=200
+    {
+        for ((f = 0; f < fns; f++)); do
+            printf 'fn mi%d(n: int) -> int {\n    match n {\n' $f
+            for ((a = 0; a < arms; a++)); do
+                printf '        %d => { return %d; },\n' $a $((a * 7 + f))
+            done
+            printf '        _ => { return -1; }\n    }\n    return -1;\n}\n\n'
+            printf 'fn ms%d(s: string) -> int {\n    match s {\n' $f
+            for ((a = 0; a < arms; a++)); do
+                printf '        "key_%d_%d" => { return %d; },\n' $f $a $a
+            done
+            printf '        _ => { return -1; }\n    }\n    return -1;\n}\n\n'
+        done
+        printf 'fn main() {\n    let total = 0;\n'
+        for ((f = 0; f < fns; f++)); do
+            printf '    total = total + mi%d(%d) + ms%d("key_%d_%d");\n' $f $f $f $f $f
+        done
+        printf '    println "{total}";\n}\n'
+    } > "$OUT_DIR/match.zc"
+}
+
+# Long functions full of f-strings.
+gen_fstrings() {
+    local fns=$((100 * SCALE))
+    local lines=30
+    {
+        printf 'include <stdio.h>\n\n'
+        for ((f = 0; f < fns; f++)); do
+            printf 'fn report%d(a: int, b: int, name: string) {\n' $f
+            for ((k = 0; k < lines; k++)); do
+                printf '    println "[%d:%d] {name}: a={a} b={b} sum={a + b} prod={a * b} k={%d}";\n' $f $k $k
+            done
+            printf '    let s = f"{name}-{a}-{b}-%d";\n    println "{s}";\n}\n\n' $f
+        done
+        printf 'fn main() {\n'
+        for ((f = 0; f < fns; f++)); do
+            printf '    report%d(%d, %d, "r%d");\n' $f $f $((f * 2)) $f
+        done
+        printf '}\n'
+    } > "$OUT_DIR/fstrings.zc"
+}
+
+gen_structs
+gen_generics
+gen_lambdas
+gen_match
+gen_fstrings
@@ -0,0 +1,84 @@
+#!/bin/bash
+
+# Compiler benchmark: transpiles the synthetic workloads from gen_workloads.sh
+# and records throughput, peak memory and per-phase times as JSON.
+#
+# Environment:
+#   ZC     compiler to measure (default: ./zc)
+#   OUT    results file (default: bench-compiler.json)
+#   SCALE  workload size multiplier (default: 1)
+#   RUNS   runs per workload; the fastest is kept (default: 3)
+
+cd "$(dirname "$0")/../.." || exit 1
+
+ZC="${ZC:-./zc}"
+OUT="${OUT:-bench-compiler.json}"
+SCALE="${SCALE:-1}"
+RUNS="${RUNS:-3}"
+
+if [ ! -x "$ZC" ]; then
+    echo "Error: zc binary not found at $ZC."
+    exit 1
+fi
+
+WORK_DIR=$(mktemp -d)
+trap 'rm -rf "$WORK_DIR"' EXIT
+
+./benchmarks/compiler/gen_workloads.sh "$WORK_DIR" "$SCALE" || exit 1
+
+# Value of a numeric field in a one-line JSON object.
+json_num() {
+    local v
+    v=$(sed -n "s/.*\"$1\":\([-0-9.eE+]*\).*/\1/p" <<< "$2")
+    echo "${v:-0}"
+}
+
+echo "** Compiler benchmark (scale $SCALE, best of $RUNS) **"
+printf '%-10s %8s %10s %14s %14s %12s\n' "workload" "lines" "seconds" "tokens/s" "nodes/s" "peak RSS"
+
+FAILED=0
+RESULTS=""
+for name in structs generics lambdas match fstrings; do
+    src="$WORK_DIR/$name.zc"
+    best=""
+    best_time=""
+    for ((r = 0; r < RUNS; r++)); do
+        stats=$("$ZC" transpile --no-zen --json --time-passes --stats -q "$src" -o "$WORK_DIR/out.c" \
+                2>&1 >/dev/null | grep '"level":"stats"')
+        if [ $? -ne 0 ] || [ ! -s "$WORK_DIR/out.c" ]; then
+            echo "$name: transpile failed"
+            ((FAILED++))
+            best=""
+            break
+        fi
+        t=$(json_num total_seconds "$stats")
+        if [ -z "$best" ] || awk "BEGIN { exit !($t < $best_time) }"; then
+            best="$stats"
+            best_time="$t"
+        fi
+        rm -f "$WORK_DIR/out.c"
+    done
+    [ -z "$best" ] && continue
+
+    lines=$(wc -l < "$src")
+    tokens=$(json_num tokens_scanned "$best")
+    nodes=$(json_num ast_nodes_created "$best")
+    rss=$(json_num peak_rss_bytes "$best")
+    tps=$(awk "BEGIN { printf \"%.0f\", ($best_time > 0 ? $tokens / $best_time : 0) }")
+    nps=$(awk "BEGIN { printf \"%.0f\", ($best_time > 0 ? $nodes / $best_time : 0) }")
+
+    printf '%-10s %8d %10.4f %14d %14d %12d\n' "$name" "$lines" "$best_time" "$tps" "$nps" "$rss"
+
+    entry=$(printf '"%s":{"lines":%d,"seconds":%s,"tokens_per_sec":%s,"nodes_per_sec":%s,"peak_rss":%s,"report":%s}' \
+            "$name" "$lines" "$best_time" "$tps" "$nps" "$rss" "$best")
+    RESULTS="${RESULTS:+$RESULTS,}$entry"
+done
+
+VERSION=$("$ZC" --version 2>/dev/null | head -n 1 | sed 's/\x1b\[[0-9;]*m//g; s/"/\\"/g')
+printf '{"compiler":"%s","date":"%s","scale":%d,"runs":%d,"workloads":{%s}}\n' \
+    "$VERSION" "$(date -u +%Y-%m-%dT%H:%M:%SZ)" "$SCALE" "$RUNS" "$RESULTS" > "$OUT"
+echo "=> Results written to $OUT"
+
+if [ $FAILED -ne 0 ]; then
+    exit 1
+fi
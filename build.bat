@@ -24,14 +24,20 @@ set SRCS=src\main.c ^
  src\parser\parser_utils.c ^
  src\parser\parser_decl.c ^
  src\parser\parser_struct.c ^
+ src\parser\parser_prefetch.c ^
  src\ast\ast.c ^
  src\codegen\codegen.c ^
  src\codegen\codegen_stmt.c ^
  src\codegen\codegen_decl.c ^
  src\codegen\codegen_main.c ^
+ src\codegen\codegen_split.c ^
  src\codegen\codegen_utils.c ^
  src\utils\utils.c ^
  src/utils/cmd.c ^
+ src\utils\threadpool.c ^
+ src\utils\stats.c ^
+ src\utils\build_cache.c ^
+ src\utils\watch.c ^
  src\platform\os.c ^
  src\platform\console.c ^
  src\platform\dylib.c ^
@@ -41,6 +47,7 @@ set SRCS=src\main.c ^
  src\analysis\typecheck.c ^
  src\analysis\move_check.c ^
  src\analysis\const_fold.c ^
+ src\analysis\escape.c ^
  src\lsp\json_rpc.c ^
  src\lsp\lsp_main.c ^
  src\lsp\lsp_analysis.c ^
@@ -67,7 +74,7 @@ set SRCS=src\main.c ^
 
 rem Build
 echo Building Zen C (%ZEN_VERSION%)...
-%CC% %CFLAGS% %SRCS% -o zc.exe -lws2_32
+%CC% %CFLAGS% %SRCS% -o zc.exe -lws2_32 -lpthread -lpsapi
 if %ERRORLEVEL% NEQ 0 (
     echo Build failed!
     exit /b %ERRORLEVEL%
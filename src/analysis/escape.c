@@ -0,0 +1,528 @@
+#include "analysis/escape.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Per-parameter verdicts, computed on demand.
+enum
+{
+    PARAM_UNKNOWN,
+    PARAM_VISITING,
+    PARAM_LOCAL,
+    PARAM_ESCAPES
+};
+
+typedef struct
+{
+    InternMap funcs;  // Function name -> NODE_FUNCTION.
+    InternMap params; // Function name -> int verdict per parameter.
+} EscapeState;
+
+static int list_escapes(EscapeState *st, ASTNode *list, const char *name);
+
+static int is_ident_char(char c)
+{
+    return isalnum((unsigned char)c) || c == '_';
+}
+
+// Whether a code string (raw C, plugin input, repeat counts) may mention `name`.
+static int text_mentions(const char *text, const char *name)
+{
+    size_t len = strlen(name);
+    for (const char *p = text ? strstr(text, name) : NULL; p; p = strstr(p + 1, name))
+    {
+        if ((p == text || !is_ident_char(p[-1])) && !is_ident_char(p[len]))
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Function a call resolves to at compile time, or NULL. `*offset` is the parameter
+// index of the first argument (1 for methods, whose self comes first).
+static ASTNode *callee_function(EscapeState *st, ASTNode *call, int *offset)
+{
+    ASTNode *callee = call->call.callee;
+    *offset = 0;
+    if (call->call.arg_names)
+    {
+        return NULL; // Named arguments are reordered by codegen.
+    }
+    if (callee->type == NODE_EXPR_VAR)
+    {
+        // Closure and function pointer variables carry a type; named functions do not.
+        if (callee->type_info)
+        {
+            return NULL;
+        }
+        return intern_map_get(&st->funcs, callee->var_ref.name);
+    }
+    if (callee->type == NODE_EXPR_MEMBER)
+    {
+        Type *t = callee->member.target->type_info;
+        if (t && t->kind == TYPE_POINTER)
+        {
+            t = t->inner;
+        }
+        if (!t || t->kind != TYPE_STRUCT || !t->name)
+        {
+            return NULL;
+        }
+        char mangled[512];
+        snprintf(mangled, sizeof(mangled), "%s__%s", t->name, callee->member.field);
+        *offset = 1;
+        return intern_map_get(&st->funcs, mangled);
+    }
+    return NULL;
+}
+
+// Whether parameter `index` of `fn` is only ever called in its body. Parameters whose
+// verdict is still being computed (recursion) are treated as escaping.
+static int param_is_local(EscapeState *st, ASTNode *fn, int index)
+{
+    if (!fn || fn->func.is_async || !fn->func.body || !fn->func.param_names ||
+        index < 0 || index >= fn->func.arg_count)
+    {
+        return 0;
+    }
+    InternedStr key = intern(fn->func.name);
+    void **slot = intern_map_slot(&st->params, key);
+    if (!*slot)
+    {
+        *slot = xcalloc(fn->func.arg_count, sizeof(int));
+    }
+    int *verdicts = *slot;
+    if (verdicts[index] == PARAM_UNKNOWN)
+    {
+        verdicts[index] = PARAM_VISITING;
+        int escapes = list_escapes(st, fn->func.body, fn->func.param_names[index]);
+        verdicts[index] = escapes ? PARAM_ESCAPES : PARAM_LOCAL;
+    }
+    return verdicts[index] == PARAM_LOCAL;
+}
+
+// Whether the closure variable `name` may outlive its block through `node`: any use
+// other than calling it or passing it to a local parameter.
+static int node_escapes(EscapeState *st, ASTNode *node, const char *name)
+{
+    if (!node)
+    {
+        return 0;
+    }
+    switch (node->type)
+    {
+    case NODE_EXPR_VAR:
+        return strcmp(node->var_ref.name, name) == 0;
+    case NODE_EXPR_CALL:
+    {
+        ASTNode *callee = node->call.callee;
+        if (!(callee->type == NODE_EXPR_VAR && strcmp(callee->var_ref.name, name) == 0) &&
+            node_escapes(st, callee, name))
+        {
+            return 1;
+        }
+        int offset;
+        ASTNode *fn = NULL;
+        int resolved = 0;
+        int i = 0;
+        for (ASTNode *arg = node->call.args; arg; arg = arg->next, i++)
+        {
+            if (arg->type == NODE_EXPR_VAR && strcmp(arg->var_ref.name, name) == 0)
+            {
+                if (!resolved)
+                {
+                    fn = callee_function(st, node, &offset);
+                    resolved = 1;
+                }
+                if (!param_is_local(st, fn, i + offset))
+                {
+                    return 1;
+                }
+            }
+            else if (node_escapes(st, arg, name))
+            {
+                return 1;
+            }
+        }
+        return 0;
+    }
+    case NODE_LAMBDA:
+        // A lambda that captures the closure may itself escape.
+        for (int i = 0; i < node->lambda.num_captures; i++)
+        {
+            if (strcmp(node->lambda.captured_vars[i], name) == 0)
+            {
+                return 1;
+            }
+        }
+        return 0;
+    case NODE_ROOT:
+        return list_escapes(st, node->root.children, name);
+    case NODE_FUNCTION:
+        return list_escapes(st, node->func.body, name);
+    case NODE_BLOCK:
+        return list_escapes(st, node->block.statements, name);
+    case NODE_RETURN:
+        return node_escapes(st, node->ret.value, name);
+    case NODE_VAR_DECL:
+    case NODE_CONST:
+        return node_escapes(st, node->var_decl.init_expr, name);
+    case NODE_IF:
+        return node_escapes(st, node->if_stmt.condition, name) ||
+               node_escapes(st, node->if_stmt.then_body, name) ||
+               node_escapes(st, node->if_stmt.else_body, name);
+    case NODE_WHILE:
+        return node_escapes(st, node->while_stmt.condition, name) ||
+               node_escapes(st, node->while_stmt.body, name);
+    case NODE_DO_WHILE:
+        return node_escapes(st, node->do_while_stmt.condition, name) ||
+               node_escapes(st, node->do_while_stmt.body, name);
+    case NODE_FOR:
+        return list_escapes(st, node->for_stmt.init, name) ||
+               node_escapes(st, node->for_stmt.condition, name) ||
+               node_escapes(st, node->for_stmt.step, name) ||
+               node_escapes(st, node->for_stmt.body, name);
+    case NODE_FOR_RANGE:
+        return text_mentions(node->for_range.step, name) ||
+               node_escapes(st, node->for_range.start, name) ||
+               node_escapes(st, node->for_range.end, name) ||
+               node_escapes(st, node->for_range.body, name);
+    case NODE_LOOP:
+        return node_escapes(st, node->loop_stmt.body, name);
+    case NODE_REPEAT:
+        return text_mentions(node->repeat_stmt.count, name) ||
+               node_escapes(st, node->repeat_stmt.body, name);
+    case NODE_UNLESS:
+        return node_escapes(st, node->unless_stmt.condition, name) ||
+               node_escapes(st, node->unless_stmt.body, name);
+    case NODE_GUARD:
+        return node_escapes(st, node->guard_stmt.condition, name) ||
+               node_escapes(st, node->guard_stmt.body, name);
+    case NODE_MATCH:
+        return node_escapes(st, node->match_stmt.expr, name) ||
+               list_escapes(st, node->match_stmt.cases, name);
+    case NODE_MATCH_CASE:
+        return node_escapes(st, node->match_case.guard, name) ||
+               node_escapes(st, node->match_case.body, name);
+    case NODE_EXPR_BINARY:
+        return node_escapes(st, node->binary.left, name) ||
+               node_escapes(st, node->binary.right, name);
+    case NODE_EXPR_UNARY:
+    case NODE_AWAIT:
+        return node_escapes(st, node->unary.operand, name);
+    case NODE_EXPR_MEMBER:
+        return node_escapes(st, node->member.target, name);
+    case NODE_EXPR_INDEX:
+        return node_escapes(st, node->index.array, name) ||
+               node_escapes(st, node->index.index, name);
+    case NODE_EXPR_SLICE:
+        return node_escapes(st, node->slice.array, name) ||
+               node_escapes(st, node->slice.start, name) ||
+               node_escapes(st, node->slice.end, name);
+    case NODE_EXPR_CAST:
+        return node_escapes(st, node->cast.expr, name);
+    case NODE_EXPR_SIZEOF:
+    case NODE_TYPEOF:
+        return node_escapes(st, node->size_of.expr, name);
+    case NODE_EXPR_STRUCT_INIT:
+        return list_escapes(st, node->struct_init.fields, name);
+    case NODE_EXPR_ARRAY_LITERAL:
+        return list_escapes(st, node->array_literal.elements, name);
+    case NODE_TERNARY:
+        return node_escapes(st, node->ternary.cond, name) ||
+               node_escapes(st, node->ternary.true_expr, name) ||
+               node_escapes(st, node->ternary.false_expr, name);
+    case NODE_TEST:
+        return node_escapes(st, node->test_stmt.body, name);
+    case NODE_ASSERT:
+        return node_escapes(st, node->assert_stmt.condition, name);
+    case NODE_DEFER:
+        return node_escapes(st, node->defer_stmt.stmt, name);
+    case NODE_DESTRUCT_VAR:
+        return node_escapes(st, node->destruct.init_expr, name) ||
+               node_escapes(st, node->destruct.else_block, name);
+    case NODE_GOTO:
+        return node_escapes(st, node->goto_stmt.goto_expr, name);
+    case NODE_TRY:
+        return node_escapes(st, node->try_stmt.expr, name);
+    case NODE_REPL_PRINT:
+        return node_escapes(st, node->repl_print.expr, name);
+    case NODE_RAW_STMT:
+        return text_mentions(node->raw_stmt.content, name);
+    case NODE_PLUGIN:
+        return text_mentions(node->plugin_stmt.body, name);
+    case NODE_EXPR_LITERAL:
+    case NODE_BREAK:
+    case NODE_CONTINUE:
+    case NODE_LABEL:
+    case NODE_REFLECTION:
+    case NODE_TYPE_ALIAS:
+    case NODE_AST_COMMENT:
+        return 0;
+    default:
+        // Inline asm, CUDA launches, va_* intrinsics and anything new: assume the worst.
+        return 1;
+    }
+}
+
+static int list_escapes(EscapeState *st, ASTNode *list, const char *name)
+{
+    for (ASTNode *n = list; n; n = n->next)
+    {
+        if (node_escapes(st, n, name))
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void mark_node(EscapeState *st, ASTNode *node);
+
+static void mark_list(EscapeState *st, ASTNode *list)
+{
+    for (ASTNode *n = list; n; n = n->next)
+    {
+        mark_node(st, n);
+    }
+}
+
+// Walk a block's statements. `let f = <lambda>;` is local if nothing after it in the
+// block lets `f` escape.
+static void mark_statements(EscapeState *st, ASTNode *list)
+{
+    for (ASTNode *n = list; n; n = n->next)
+    {
+        if (n->type == NODE_VAR_DECL && !n->var_decl.is_static && !n->var_decl.is_autofree &&
+            n->var_decl.init_expr && n->var_decl.init_expr->type == NODE_LAMBDA &&
+            !list_escapes(st, n->next, n->var_decl.name))
+        {
+            n->var_decl.init_expr->lambda.is_local = 1;
+        }
+        mark_node(st, n);
+    }
+}
+
+// Mark lambdas that are called in place or passed to local parameters, and walk into
+// every child that holds code.
+static void mark_node(EscapeState *st, ASTNode *node)
+{
+    if (!node)
+    {
+        return;
+    }
+    switch (node->type)
+    {
+    case NODE_EXPR_CALL:
+    {
+        ASTNode *callee = node->call.callee;
+        if (callee->type == NODE_LAMBDA)
+        {
+            callee->lambda.is_local = 1;
+        }
+        mark_node(st, callee);
+        int offset;
+        ASTNode *fn = NULL;
+        int resolved = 0;
+        int i = 0;
+        for (ASTNode *arg = node->call.args; arg; arg = arg->next, i++)
+        {
+            if (arg->type == NODE_LAMBDA)
+            {
+                if (!resolved)
+                {
+                    fn = callee_function(st, node, &offset);
+                    resolved = 1;
+                }
+                if (param_is_local(st, fn, i + offset))
+                {
+                    arg->lambda.is_local = 1;
+                }
+            }
+            mark_node(st, arg);
+        }
+        break;
+    }
+    case NODE_LAMBDA:
+        mark_node(st, node->lambda.body);
+        break;
+    case NODE_ROOT:
+        mark_list(st, node->root.children);
+        break;
+    case NODE_FUNCTION:
+        mark_node(st, node->func.body);
+        break;
+    case NODE_IMPL:
+        mark_list(st, node->impl.methods);
+        break;
+    case NODE_IMPL_TRAIT:
+        mark_list(st, node->impl_trait.methods);
+        break;
+    case NODE_BLOCK:
+        mark_statements(st, node->block.statements);
+        break;
+    case NODE_RETURN:
+        mark_node(st, node->ret.value);
+        break;
+    case NODE_VAR_DECL:
+    case NODE_CONST:
+        mark_node(st, node->var_decl.init_expr);
+        break;
+    case NODE_IF:
+        mark_node(st, node->if_stmt.condition);
+        mark_node(st, node->if_stmt.then_body);
+        mark_node(st, node->if_stmt.else_body);
+        break;
+    case NODE_WHILE:
+        mark_node(st, node->while_stmt.condition);
+        mark_node(st, node->while_stmt.body);
+        break;
+    case NODE_DO_WHILE:
+        mark_node(st, node->do_while_stmt.condition);
+        mark_node(st, node->do_while_stmt.body);
+        break;
+    case NODE_FOR:
+        mark_list(st, node->for_stmt.init);
+        mark_node(st, node->for_stmt.condition);
+        mark_node(st, node->for_stmt.step);
+        mark_node(st, node->for_stmt.body);
+        break;
+    case NODE_FOR_RANGE:
+        mark_node(st, node->for_range.start);
+        mark_node(st, node->for_range.end);
+        mark_node(st, node->for_range.body);
+        break;
+    case NODE_LOOP:
+        mark_node(st, node->loop_stmt.body);
+        break;
+    case NODE_REPEAT:
+        mark_node(st, node->repeat_stmt.body);
+        break;
+    case NODE_UNLESS:
+        mark_node(st, node->unless_stmt.condition);
+        mark_node(st, node->unless_stmt.body);
+        break;
+    case NODE_GUARD:
+        mark_node(st, node->guard_stmt.condition);
+        mark_node(st, node->guard_stmt.body);
+        break;
+    case NODE_MATCH:
+        mark_node(st, node->match_stmt.expr);
+        mark_list(st, node->match_stmt.cases);
+        break;
+    case NODE_MATCH_CASE:
+        mark_node(st, node->match_case.guard);
+        mark_node(st, node->match_case.body);
+        break;
+    case NODE_EXPR_BINARY:
+        mark_node(st, node->binary.left);
+        mark_node(st, node->binary.right);
+        break;
+    case NODE_EXPR_UNARY:
+    case NODE_AWAIT:
+        mark_node(st, node->unary.operand);
+        break;
+    case NODE_EXPR_MEMBER:
+        mark_node(st, node->member.target);
+        break;
+    case NODE_EXPR_INDEX:
+        mark_node(st, node->index.array);
+        mark_node(st, node->index.index);
+        break;
+    case NODE_EXPR_CAST:
+        mark_node(st, node->cast.expr);
+        break;
+    case NODE_EXPR_STRUCT_INIT:
+        mark_list(st, node->struct_init.fields);
+        break;
+    case NODE_EXPR_ARRAY_LITERAL:
+        mark_list(st, node->array_literal.elements);
+        break;
+    case NODE_TERNARY:
+        mark_node(st, node->ternary.cond);
+        mark_node(st, node->ternary.true_expr);
+        mark_node(st, node->ternary.false_expr);
+        break;
+    case NODE_TEST:
+        mark_node(st, node->test_stmt.body);
+        break;
+    case NODE_DEFER:
+        mark_node(st, node->defer_stmt.stmt);
+        break;
+    case NODE_DESTRUCT_VAR:
+        mark_node(st, node->destruct.init_expr);
+        mark_node(st, node->destruct.else_block);
+        break;
+    case NODE_TRY:
+        mark_node(st, node->try_stmt.expr);
+        break;
+    default:
+        break;
+    }
+}
+
+// Index functions and methods by their C name.
+static void index_function(EscapeState *st, ASTNode *node)
+{
+    if (!node)
+    {
+        return;
+    }
+    if (node->type == NODE_FUNCTION && node->func.name)
+    {
+        intern_map_put(&st->funcs, intern(node->func.name), node);
+    }
+    else if (node->type == NODE_IMPL)
+    {
+        for (ASTNode *m = node->impl.methods; m; m = m->next)
+        {
+            index_function(st, m);
+        }
+    }
+    else if (node->type == NODE_IMPL_TRAIT)
+    {
+        for (ASTNode *m = node->impl_trait.methods; m; m = m->next)
+        {
+            index_function(st, m);
+        }
+    }
+}
+
+void mark_local_lambdas(ParserContext *ctx, ASTNode *root)
+{
+    EscapeState st;
+    memset(&st, 0, sizeof(st));
+
+    for (ASTNode *n = root; n; n = n->next)
+    {
+        index_function(&st, n);
+    }
+    for (StructRef *r = ctx->parsed_funcs_list; r; r = r->next)
+    {
+        index_function(&st, r->node);
+    }
+    for (StructRef *r = ctx->parsed_impls_list; r; r = r->next)
+    {
+        index_function(&st, r->node);
+    }
+    for (ASTNode *n = ctx->instantiated_funcs; n; n = n->next)
+    {
+        index_function(&st, n);
+    }
+
+    mark_list(&st, root);
+    for (StructRef *r = ctx->parsed_funcs_list; r; r = r->next)
+    {
+        mark_node(&st, r->node);
+    }
+    for (StructRef *r = ctx->parsed_impls_list; r; r = r->next)
+    {
+        mark_node(&st, r->node);
+    }
+    for (ASTNode *n = ctx->instantiated_funcs; n; n = n->next)
+    {
+        mark_node(&st, n);
+    }
+}
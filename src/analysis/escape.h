@@ -0,0 +1,20 @@
+#ifndef ESCAPE_H
+#define ESCAPE_H
+
+#include "ast/ast.h"
+#include "parser/parser.h"
+
+/**
+ * @brief Mark capturing lambdas whose closure cannot outlive the enclosing block.
+ *
+ * A lambda is local when it is called directly, passed to a function parameter
+ * that is only ever called, or bound to a variable that is only used that way.
+ * Codegen gives local lambdas a stack context instead of a heap one. Anything
+ * the analysis does not understand counts as an escape.
+ *
+ * @param ctx Parser context holding the parsed functions and impls.
+ * @param root First top-level node of the program.
+ */
+void mark_local_lambdas(ParserContext *ctx, ASTNode *root);
+
+#endif
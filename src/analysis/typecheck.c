@@ -69,7 +69,7 @@ static void tc_add_symbol(TypeChecker *tc, const char *name, Type *type, Token t
 
     ZenSymbol *s = malloc(sizeof(ZenSymbol));
     memset(s, 0, sizeof(ZenSymbol));
-    s->name = strdup(name);
+    s->name = intern(name);
     s->type_info = type;
     s->decl_token = t;
     s->next = tc->current_scope->symbols;
@@ -78,13 +78,14 @@ static void tc_add_symbol(TypeChecker *tc, const char *name, Type *type, Token t
 
 static ZenSymbol *tc_lookup(TypeChecker *tc, const char *name)
 {
-    Scope *s = tc->current_scope;
+    InternedStr key = intern_find(name);
+    Scope *s = key ? tc->current_scope : NULL;
     while (s)
     {
         ZenSymbol *curr = s->symbols;
         while (curr)
         {
-            if (0 == strcmp(curr->name, name))
+            if (curr->name == key)
             {
                 return curr;
             }
@@ -578,8 +579,8 @@ static int check_type_compatibility(TypeChecker *tc, Type *target, Type *value,
         const char *alias = find_type_alias(tc->pctx, target->name);
         if (alias)
         {
-            // Check if resolved names match
-            if (value->name && strcmp(alias, value->name) == 0)
+            // Check if resolved names match (type names are interned)
+            if (value->name && value->name == intern_find(alias))
             {
                 return 1;
             }
@@ -590,7 +591,7 @@ static int check_type_compatibility(TypeChecker *tc, Type *target, Type *value,
         const char *alias = find_type_alias(tc->pctx, value->name);
         if (alias)
         {
-            if (target->name && strcmp(alias, target->name) == 0)
+            if (target->name && target->name == intern_find(alias))
             {
                 return 1;
             }
@@ -2,6 +2,7 @@
 #include "ast.h"
 #include "../parser/parser.h"
 #include "zprep.h"
+#include "../utils/arena.h"
 #include <stdlib.h>
 #include <string.h>
 
@@ -15,10 +16,17 @@ static TraitReg *registered_traits = NULL;
 
 void register_trait(const char *name)
 {
+    if (is_trait(name))
+    {
+        return; // Parsed again (REPL, LSP): the name is already known.
+    }
+    // The trait list outlives any single parse, so keep it out of scratch regions.
+    ZArena *prev = arena_use(arena_global());
     TraitReg *r = xmalloc(sizeof(TraitReg));
     r->name = xstrdup(name);
     r->next = registered_traits;
     registered_traits = r;
+    arena_use(prev);
 }
 
 int is_trait(const char *name)
@@ -40,6 +48,7 @@ ASTNode *ast_create(NodeType type)
     ASTNode *node = xmalloc(sizeof(ASTNode));
     memset(node, 0, sizeof(ASTNode));
     node->type = type;
+    g_stats.ast_nodes++;
     return node;
 }
 
@@ -183,9 +192,10 @@ int type_eq(Type *a, Type *b)
         return 0;
     }
 
+    // Type names are interned, so equal names are the same pointer.
     if (a->kind == TYPE_STRUCT || a->kind == TYPE_GENERIC)
     {
-        return 0 == strcmp(a->name, b->name);
+        return a->name == b->name;
     }
     if (a->kind == TYPE_ALIAS)
     {
@@ -195,7 +205,7 @@ int type_eq(Type *a, Type *b)
             {
                 return 0;
             }
-            return 0 == strcmp(a->name, b->name);
+            return a->name == b->name;
         }
         return type_eq(a->inner, b);
     }
@@ -207,6 +217,164 @@ int type_eq(Type *a, Type *b)
     return 1;
 }
 
+// Hash-cons table: open addressing, at most half full, canonical types and
+// the table itself live in the global region for the whole compilation.
+static Type **canon_slots = NULL;
+static int canon_cap = 0;
+static int canon_count = 0;
+
+// The part of the union that belongs to a type's identity.
+static int type_union_key(Type *t)
+{
+    switch (t->kind)
+    {
+    case TYPE_FUNCTION:
+        return t->is_varargs;
+    case TYPE_POINTER:
+        return t->is_restrict;
+    case TYPE_ALIAS:
+        return t->alias.is_opaque_alias;
+    default:
+        return 0;
+    }
+}
+
+static uint32_t hash_mix(uint32_t h, uint32_t v)
+{
+    return (h ^ v) * 16777619u;
+}
+
+// `key` has canonical children, so they hash and compare by pointer.
+static uint32_t type_hash_shallow(Type *key)
+{
+    uint32_t h = 2166136261u;
+    h = hash_mix(h, key->kind);
+    h = hash_mix(h, key->name ? intern_hash(key->name) : 0);
+    h = hash_mix(h, key->inner ? key->inner->id : 0);
+    for (int i = 0; i < key->arg_count; i++)
+    {
+        h = hash_mix(h, key->args[i] ? key->args[i]->id : 0);
+    }
+    h = hash_mix(h, key->arg_count);
+    h = hash_mix(h, key->array_size);
+    return hash_mix(h, key->is_const | key->is_explicit_struct << 1 | key->is_raw << 2 |
+                           type_union_key(key) << 3);
+}
+
+static int type_match_shallow(Type *c, Type *key)
+{
+    if (c->kind != key->kind || c->name != key->name || c->inner != key->inner ||
+        c->arg_count != key->arg_count || c->array_size != key->array_size ||
+        c->is_const != key->is_const || c->is_explicit_struct != key->is_explicit_struct ||
+        c->is_raw != key->is_raw || type_union_key(c) != type_union_key(key))
+    {
+        return 0;
+    }
+    if (key->kind == TYPE_ALIAS && c->alias.alias_defined_in_file != key->alias.alias_defined_in_file)
+    {
+        return 0;
+    }
+    for (int i = 0; i < key->arg_count; i++)
+    {
+        if (c->args[i] != key->args[i])
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void canon_grow(void)
+{
+    int cap = canon_cap ? canon_cap * 2 : 1024;
+    Type **slots = xcalloc(cap, sizeof(Type *));
+    for (int i = 0; i < canon_cap; i++)
+    {
+        Type *c = canon_slots[i];
+        if (c)
+        {
+            int j = type_hash_shallow(c) & (cap - 1);
+            while (slots[j])
+            {
+                j = (j + 1) & (cap - 1);
+            }
+            slots[j] = c;
+        }
+    }
+    canon_slots = slots;
+    canon_cap = cap;
+}
+
+Type *type_intern(Type *t)
+{
+    if (!t || t->id)
+    {
+        return t;
+    }
+
+    // The lookup key is `t` with interned strings and canonical children.
+    Type key = *t;
+    Type *small[8];
+    key.name = intern(t->name);
+    key.inner = type_intern(t->inner);
+    key.args = t->arg_count <= 8 ? small : xmalloc(sizeof(Type *) * t->arg_count);
+    for (int i = 0; i < t->arg_count; i++)
+    {
+        key.args[i] = type_intern(t->args[i]);
+    }
+    if (t->kind == TYPE_ALIAS)
+    {
+        key.alias.alias_defined_in_file = intern(t->alias.alias_defined_in_file);
+    }
+
+    ZArena *prev = arena_use(arena_global());
+    if ((canon_count + 1) * 2 > canon_cap)
+    {
+        canon_grow();
+    }
+
+    int mask = canon_cap - 1;
+    int i = type_hash_shallow(&key) & mask;
+    while (canon_slots[i])
+    {
+        if (type_match_shallow(canon_slots[i], &key))
+        {
+            arena_use(prev);
+            return canon_slots[i];
+        }
+        i = (i + 1) & mask;
+    }
+
+    Type *c = type_new(key.kind);
+    *c = key;
+    // Only the identity part of the union is kept (see type_union_key).
+    memset(&c->alias, 0, sizeof(c->alias));
+    if (key.kind == TYPE_ALIAS)
+    {
+        c->alias = key.alias;
+    }
+    else
+    {
+        c->is_varargs = type_union_key(&key);
+    }
+    c->args = NULL;
+    if (key.arg_count > 0)
+    {
+        c->args = xmalloc(sizeof(Type *) * key.arg_count);
+        memcpy(c->args, key.args, sizeof(Type *) * key.arg_count);
+    }
+    c->id = ++canon_count;
+    canon_slots[i] = c;
+
+    arena_use(prev);
+    return c;
+}
+
+int type_intern_count(void)
+{
+    return canon_count;
+}
+
 static char *type_to_string_impl(Type *t);
 
 char *type_to_string(Type *t)
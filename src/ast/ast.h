@@ -82,7 +82,7 @@ typedef enum
 typedef struct Type
 {
     TypeKind kind;          ///< The kind of type.
-    char *name;             ///< Name of the type (for STRUCT, GENERIC, ENUM).
+    InternedStr name;       ///< Name of the type (for STRUCT, GENERIC, ENUM), interned.
     struct Type *inner;     ///< Inner type (for POINTER, ARRAY).
     struct Type **args;     ///< Generic arguments (for GENERIC instantiations).
     int arg_count;          ///< Count of generic arguments.
@@ -90,6 +90,7 @@ typedef struct Type
     int is_explicit_struct; ///< 1 if defined with "struct" keyword explicitly.
     int is_raw;             // Raw function pointer (fn*)
     int array_size;         ///< Size for fixed-size arrays. For TYPE_BITINT, this is the bit width.
+    int id;                 ///< Canonical type ID (see type_intern); 0 for ordinary mutable types.
     union
     {
         int is_varargs;  ///< 1 if function type is variadic.
@@ -579,6 +580,7 @@ struct ASTNode
             int num_captures;
             int *capture_modes;
             int default_capture_mode;
+            int is_local; // Closure cannot escape its block: context goes on the stack.
         } lambda;
 
         struct
@@ -671,6 +673,25 @@ Type *type_new(TypeKind kind);
 Type *type_new_ptr(Type *inner);
 Type *type_new_array(Type *inner, int size);
 int type_eq(Type *a, Type *b);
+
+/**
+ * @brief Canonical (hash-consed) copy of a type.
+ *
+ * Structurally equal types intern to the same pointer and the same nonzero
+ * `id`, so exact type identity is a pointer or integer compare. Canonical
+ * types are shared and must never be modified. Trait flags are properties of
+ * the struct definition, not of the type, and are not carried over.
+ *
+ * @return The canonical type, or NULL if `t` is NULL. A canonical type
+ *         interns to itself.
+ */
+Type *type_intern(Type *t);
+
+/**
+ * @brief Number of distinct canonical types created so far.
+ */
+int type_intern_count(void);
+
 int is_integer_type(Type *t);
 int is_float_type(Type *t);
 char *type_to_string(Type *t);
@@ -142,73 +142,80 @@ static void codegen_var_expr(ParserContext *ctx, ASTNode *node, FILE *out)
     fprintf(out, "%s", node->var_ref.name);
 }
 
-// Emit lambda expression
-static void codegen_lambda_expr(ParserContext *ctx, ASTNode *node, FILE *out)
+// Emit the value stored in the context for capture `i` of a lambda.
+static void emit_capture_value(ParserContext *ctx, ASTNode *node, int i, FILE *out)
 {
-    if (node->lambda.num_captures > 0)
+    const char *name = node->lambda.captured_vars[i];
+    if (node->lambda.capture_modes && node->lambda.capture_modes[i] == 1)
     {
-        fprintf(out,
-                "({ struct Lambda_%d_Ctx *ctx = malloc(sizeof(struct "
-                "Lambda_%d_Ctx));\n",
-                node->lambda.lambda_id, node->lambda.lambda_id);
-        for (int i = 0; i < node->lambda.num_captures; i++)
+        if (g_current_lambda)
         {
-            if (node->lambda.capture_modes && node->lambda.capture_modes[i] == 1)
+            for (int k = 0; k < g_current_lambda->lambda.num_captures; k++)
             {
-                int found = 0;
-                if (g_current_lambda)
+                if (strcmp(name, g_current_lambda->lambda.captured_vars[k]) == 0)
                 {
-                    for (int k = 0; k < g_current_lambda->lambda.num_captures; k++)
+                    if (g_current_lambda->lambda.capture_modes &&
+                        g_current_lambda->lambda.capture_modes[k] == 1)
                     {
-                        if (strcmp(node->lambda.captured_vars[i],
-                                   g_current_lambda->lambda.captured_vars[k]) == 0)
-                        {
-                            if (g_current_lambda->lambda.capture_modes &&
-                                g_current_lambda->lambda.capture_modes[k] == 1)
-                            {
-                                fprintf(out, "ctx->%s = ctx->%s;\n", node->lambda.captured_vars[i],
-                                        node->lambda.captured_vars[i]);
-                            }
-                            else
-                            {
-                                fprintf(out, "ctx->%s = &ctx->%s;\n", node->lambda.captured_vars[i],
-                                        node->lambda.captured_vars[i]);
-                            }
-                            found = 1;
-                            break;
-                        }
+                        fprintf(out, "ctx->%s", name);
                     }
-                }
-                if (!found)
-                {
-                    fprintf(out, "ctx->%s = &%s;\n", node->lambda.captured_vars[i],
-                            node->lambda.captured_vars[i]);
+                    else
+                    {
+                        fprintf(out, "&ctx->%s", name);
+                    }
+                    return;
                 }
             }
-            else
-            {
-                fprintf(out, "ctx->%s = ", node->lambda.captured_vars[i]);
+        }
+        fprintf(out, "&%s", name);
+        return;
+    }
 
-                ASTNode *var_node = ast_create(NODE_EXPR_VAR);
-                var_node->var_ref.name = xstrdup(node->lambda.captured_vars[i]);
-                var_node->token = node->token;
+    ASTNode *var_node = ast_create(NODE_EXPR_VAR);
+    var_node->var_ref.name = xstrdup(name);
+    var_node->token = node->token;
 
-                if (node->lambda.captured_types && node->lambda.captured_types[i])
-                {
-                    var_node->resolved_type = xstrdup(node->lambda.captured_types[i]);
-                }
-                else
-                {
-                    // Should rely on analysis, but fallback just in case.
-                    var_node->resolved_type = xstrdup("int");
-                }
+    if (node->lambda.captured_types && node->lambda.captured_types[i])
+    {
+        var_node->resolved_type = xstrdup(node->lambda.captured_types[i]);
+    }
+    else
+    {
+        // Should rely on analysis, but fallback just in case.
+        var_node->resolved_type = xstrdup("int");
+    }
 
-                codegen_expression_with_move(ctx, var_node, out);
+    codegen_expression_with_move(ctx, var_node, out);
 
-                ast_free(var_node);
+    ast_free(var_node);
+}
 
-                fprintf(out, ";\n");
-            }
+// Emit lambda expression. A local lambda (see mark_local_lambdas) gets its context as a
+// compound literal, which lives as long as the enclosing block; others allocate it.
+static void codegen_lambda_expr(ParserContext *ctx, ASTNode *node, FILE *out)
+{
+    if (node->lambda.num_captures > 0 && node->lambda.is_local)
+    {
+        fprintf(out, "((z_closure_T){.func = _lambda_%d, .ctx = &(struct Lambda_%d_Ctx){",
+                node->lambda.lambda_id, node->lambda.lambda_id);
+        for (int i = 0; i < node->lambda.num_captures; i++)
+        {
+            fprintf(out, "%s.%s = ", i ? ", " : "", node->lambda.captured_vars[i]);
+            emit_capture_value(ctx, node, i, out);
+        }
+        fprintf(out, "}})");
+    }
+    else if (node->lambda.num_captures > 0)
+    {
+        fprintf(out,
+                "({ struct Lambda_%d_Ctx *ctx = malloc(sizeof(struct "
+                "Lambda_%d_Ctx));\n",
+                node->lambda.lambda_id, node->lambda.lambda_id);
+        for (int i = 0; i < node->lambda.num_captures; i++)
+        {
+            fprintf(out, "ctx->%s = ", node->lambda.captured_vars[i]);
+            emit_capture_value(ctx, node, i, out);
+            fprintf(out, ";\n");
         }
         fprintf(out, "(z_closure_T){.func = _lambda_%d, .ctx = ctx}; })", node->lambda.lambda_id);
     }
@@ -259,7 +266,7 @@ void codegen_expression(ParserContext *ctx, ASTNode *node, FILE *out)
             int is_ptr = 0;
             if (t1)
             {
-                char *check = t1;
+                const char *check = t1;
                 int depth = 0;
                 while (depth++ < 10)
                 {
@@ -268,23 +275,12 @@ void codegen_expression(ParserContext *ctx, ASTNode *node, FILE *out)
                         is_ptr = 1;
                         break;
                     }
-                    int resolved = 0;
-                    ASTNode *alias = global_user_structs;
-                    while (alias)
-                    {
-                        if (alias->type == NODE_TYPE_ALIAS &&
-                            strcmp(check, alias->type_alias.alias) == 0)
-                        {
-                            check = alias->type_alias.original_type;
-                            resolved = 1;
-                            break;
-                        }
-                        alias = alias->next;
-                    }
-                    if (!resolved)
+                    const char *original = find_global_alias(check);
+                    if (!original)
                     {
                         break;
                     }
+                    check = original;
                 }
             }
 
@@ -49,6 +49,8 @@ void codegen_match_internal(ParserContext *ctx, ASTNode *node, FILE *out, int us
 // Utility functions (codegen_utils.c).
 char *infer_type(ParserContext *ctx, ASTNode *node);
 ASTNode *find_struct_def_codegen(ParserContext *ctx, const char *name);
+void index_global_user_structs(void);
+const char *find_global_alias(const char *name);
 char *get_field_type_str(ParserContext *ctx, const char *struct_name, const char *field_name);
 char *extract_call_args(const char *args);
 void emit_var_decl_type(ParserContext *ctx, FILE *out, const char *type_str, const char *var_name);
@@ -67,6 +69,27 @@ int is_struct_return_type(const char *ret_type);
  * @brief Emits the standard preamble (includes, macros) to the output file.
  */
 void emit_preamble(ParserContext *ctx, FILE *out);
+
+/**
+ * @brief Parts of the preamble, for emit_preamble_parts.
+ */
+typedef enum
+{
+    PREAMBLE_DECLS = 1, ///< System headers, macros, typedefs and static inline helpers.
+    PREAMBLE_DEFS = 2   ///< Runtime helpers with external linkage (z_panic, readln, ...).
+} PreamblePart;
+
+/**
+ * @brief Emits the preamble parts selected by the PreamblePart mask `parts`.
+ */
+void emit_preamble_parts(ParserContext *ctx, FILE *out, int parts);
+
+/**
+ * @brief Emits the head of the output that rarely changes between builds: the
+ * preamble declarations and the system headers included before any local one.
+ * It is compiled once into a precompiled header kept in the build cache.
+ */
+void emit_preamble_header(ParserContext *ctx, ASTNode *root, FILE *out);
 void emit_includes_and_aliases(ASTNode *node, FILE *out);
 void emit_type_aliases(ASTNode *node, FILE *out);
 void emit_global_aliases(ParserContext *ctx, FILE *out);
@@ -77,6 +100,7 @@ void emit_globals(ParserContext *ctx, ASTNode *node, FILE *out);
 void emit_lambda_defs(ParserContext *ctx, FILE *out);
 void emit_protos(ParserContext *ctx, ASTNode *node, FILE *out);
 void emit_impl_vtables(ParserContext *ctx, FILE *out);
+void emit_trait_wrappers(ParserContext *ctx, ASTNode *node, FILE *out);
 
 /**
  * @brief Emits test runner and test cases if testing is enabled.
@@ -84,6 +108,21 @@ void emit_impl_vtables(ParserContext *ctx, FILE *out);
 int emit_tests_and_runner(ParserContext *ctx, ASTNode *node, FILE *out);
 void print_type_defs(ParserContext *ctx, FILE *out, ASTNode *nodes);
 
+// Translation unit splitting (codegen_split.c).
+/**
+ * @brief Split generated C into `<stem>.h` and `<stem>_0.c` ... `<stem>_<n-1>.c`.
+ *
+ * Function definitions are spread over the units in contiguous runs of about
+ * equal size, objects are defined in unit 0, and everything else (types,
+ * prototypes, macros, static helpers) goes to the header each unit includes.
+ *
+ * @param c_file The generated C file.
+ * @param units Number of units wanted.
+ * @return Number of units written (at most `units`), or 0 if the code cannot
+ *         be split and must be compiled as one file.
+ */
+int codegen_split_units(const char *c_file, const char *stem, int units);
+
 // Global state (shared across modules).
 extern ASTNode *global_user_structs;  ///< List of user defined structs.
 extern char *g_current_impl_type;     ///< Type currently being implemented (in impl block).
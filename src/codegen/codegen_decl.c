@@ -40,13 +40,107 @@ static void emit_freestanding_preamble(FILE *out)
     // Most primitives (integers, pointers) work without them.
 }
 
+// Runtime helpers with external linkage (PREAMBLE_DEFS). They are kept out
+// of the declarations part so it can be precompiled and shared.
+static void emit_panic_def(FILE *out)
+{
+    fputs("void z_panic(const char* msg) { fprintf(stderr, \"Panic: %s\\n\", "
+          "msg); exit(1); }\n",
+          out);
+}
+
+static void emit_autofree_def(FILE *out)
+{
+    fputs("void _z_autofree_impl(void *p) { void **pp = (void**)p; if(*pp) { "
+          "z_free(*pp); *pp "
+          "= NULL; } }\n",
+          out);
+}
+
+static void emit_runtime_defs(FILE *out)
+{
+    // C++ compatible readln helper
+    if (g_config.use_cpp)
+    {
+        fputs(
+            "string _z_readln_raw() { "
+            "size_t cap = 64; size_t len = 0; "
+            "char *line = static_cast<char*>(malloc(cap)); "
+            "if(!line) return NULL; "
+            "int c; "
+            "while((c = fgetc(stdin)) != EOF) { "
+            "if(c == '\\n') break; "
+            "if(len + 1 >= cap) { cap *= 2; char *n = static_cast<char*>(realloc(line, cap)); "
+            "if(!n) { free(line); return NULL; } line = n; } "
+            "line[len++] = c; } "
+            "if(len == 0 && c == EOF) { free(line); return NULL; } "
+            "line[len] = 0; return line; }\n",
+            out);
+    }
+    else
+    {
+        fputs("string _z_readln_raw() { "
+              "size_t cap = 64; size_t len = 0; "
+              "char *line = z_malloc(cap); "
+              "if(!line) return NULL; "
+              "int c; "
+              "while((c = fgetc(stdin)) != EOF) { "
+              "if(c == '\\n') break; "
+              "if(len + 1 >= cap) { cap *= 2; char *n = z_realloc(line, cap); "
+              "if(!n) { z_free(line); return NULL; } line = n; } "
+              "line[len++] = c; } "
+              "if(len == 0 && c == EOF) { z_free(line); return NULL; } "
+              "line[len] = 0; return line; }\n",
+              out);
+    }
+    fputs("int _z_scan_helper(const char *fmt, ...) { char *l = "
+          "_z_readln_raw(); if(!l) return "
+          "0; va_list ap; va_start(ap, fmt); int r = vsscanf(l, fmt, ap); "
+          "va_end(ap); "
+          "z_free(l); return r; }\n",
+          out);
+
+    // REPL helpers: suppress/restore stdout.
+    fputs("int _z_orig_stdout = -1;\n", out);
+    fputs("void _z_suppress_stdout() {\n", out);
+    fputs("    fflush(stdout);\n", out);
+    fputs("    if (_z_orig_stdout == -1) _z_orig_stdout = dup(STDOUT_FILENO);\n", out);
+    fputs("    int nullfd = open(\"/dev/null\", O_WRONLY);\n", out);
+    fputs("    dup2(nullfd, STDOUT_FILENO);\n", out);
+    fputs("    close(nullfd);\n", out);
+    fputs("}\n", out);
+    fputs("void _z_restore_stdout() {\n", out);
+    fputs("    fflush(stdout);\n", out);
+    fputs("    if (_z_orig_stdout != -1) {\n", out);
+    fputs("        dup2(_z_orig_stdout, STDOUT_FILENO);\n", out);
+    fputs("        close(_z_orig_stdout);\n", out);
+    fputs("        _z_orig_stdout = -1;\n", out);
+    fputs("    }\n", out);
+    fputs("}\n", out);
+}
+
 void emit_preamble(ParserContext *ctx, FILE *out)
+{
+    emit_preamble_parts(ctx, out, PREAMBLE_DECLS | PREAMBLE_DEFS);
+}
+
+void emit_preamble_parts(ParserContext *ctx, FILE *out, int parts)
 {
     if (g_config.is_freestanding)
     {
-        emit_freestanding_preamble(out);
+        if (parts & PREAMBLE_DECLS)
+        {
+            emit_freestanding_preamble(out);
+        }
         return;
     }
+    else if (!(parts & PREAMBLE_DECLS))
+    {
+        // Definitions only: the declarations come from a separate header.
+        emit_panic_def(out);
+        emit_autofree_def(out);
+        emit_runtime_defs(out);
+    }
     else
     {
         // Standard hosted preamble.
@@ -130,9 +224,10 @@ void emit_preamble(ParserContext *ctx, FILE *out)
             fputs("#define z_malloc malloc\n#define z_realloc realloc\n", out);
         }
         fputs("#define z_free free\n#define z_print printf\n", out);
-        fputs("void z_panic(const char* msg) { fprintf(stderr, \"Panic: %s\\n\", "
-              "msg); exit(1); }\n",
-              out);
+        if (parts & PREAMBLE_DEFS)
+        {
+            emit_panic_def(out);
+        }
         fputs("#if defined(__APPLE__)\n"
               "#define _ZC_SEC __attribute__((used,section(\"__DATA,__zarch\")))\n"
               "#elif defined(_WIN32)\n"
@@ -148,73 +243,43 @@ void emit_preamble(ParserContext *ctx, FILE *out)
               "0x73,0x71};\n",
               out);
 
-        fputs("void _z_autofree_impl(void *p) { void **pp = (void**)p; if(*pp) { "
-              "z_free(*pp); *pp "
-              "= NULL; } }\n",
-              out);
+        if (parts & PREAMBLE_DEFS)
+        {
+            emit_autofree_def(out);
+        }
         fputs("#define assert(cond, ...) if (!(cond)) { fprintf(stderr, "
               "\"Assertion failed: \" "
               "__VA_ARGS__); exit(1); }\n",
               out);
 
-        // C++ compatible readln helper
-        if (g_config.use_cpp)
+        if (parts & PREAMBLE_DEFS)
         {
-            fputs(
-                "string _z_readln_raw() { "
-                "size_t cap = 64; size_t len = 0; "
-                "char *line = static_cast<char*>(malloc(cap)); "
-                "if(!line) return NULL; "
-                "int c; "
-                "while((c = fgetc(stdin)) != EOF) { "
-                "if(c == '\\n') break; "
-                "if(len + 1 >= cap) { cap *= 2; char *n = static_cast<char*>(realloc(line, cap)); "
-                "if(!n) { free(line); return NULL; } line = n; } "
-                "line[len++] = c; } "
-                "if(len == 0 && c == EOF) { free(line); return NULL; } "
-                "line[len] = 0; return line; }\n",
-                out);
+            emit_runtime_defs(out);
         }
-        else
+    }
+}
+
+void emit_preamble_header(ParserContext *ctx, ASTNode *root, FILE *out)
+{
+    emit_preamble_parts(ctx, out, PREAMBLE_DECLS);
+
+    ASTNode *node = root;
+    while (node && node->type == NODE_ROOT)
+    {
+        node = node->root.children;
+    }
+    // System headers up to the first local one, which could change how the
+    // rest are read. The generated source still includes them (a no-op then).
+    for (; node; node = node->next)
+    {
+        if (node->type == NODE_INCLUDE)
         {
-            fputs("string _z_readln_raw() { "
-                  "size_t cap = 64; size_t len = 0; "
-                  "char *line = z_malloc(cap); "
-                  "if(!line) return NULL; "
-                  "int c; "
-                  "while((c = fgetc(stdin)) != EOF) { "
-                  "if(c == '\\n') break; "
-                  "if(len + 1 >= cap) { cap *= 2; char *n = z_realloc(line, cap); "
-                  "if(!n) { z_free(line); return NULL; } line = n; } "
-                  "line[len++] = c; } "
-                  "if(len == 0 && c == EOF) { z_free(line); return NULL; } "
-                  "line[len] = 0; return line; }\n",
-                  out);
+            if (!node->include.is_system)
+            {
+                break;
+            }
+            fprintf(out, "#include <%s>\n", node->include.path);
         }
-        fputs("int _z_scan_helper(const char *fmt, ...) { char *l = "
-              "_z_readln_raw(); if(!l) return "
-              "0; va_list ap; va_start(ap, fmt); int r = vsscanf(l, fmt, ap); "
-              "va_end(ap); "
-              "z_free(l); return r; }\n",
-              out);
-
-        // REPL helpers: suppress/restore stdout.
-        fputs("int _z_orig_stdout = -1;\n", out);
-        fputs("void _z_suppress_stdout() {\n", out);
-        fputs("    fflush(stdout);\n", out);
-        fputs("    if (_z_orig_stdout == -1) _z_orig_stdout = dup(STDOUT_FILENO);\n", out);
-        fputs("    int nullfd = open(\"/dev/null\", O_WRONLY);\n", out);
-        fputs("    dup2(nullfd, STDOUT_FILENO);\n", out);
-        fputs("    close(nullfd);\n", out);
-        fputs("}\n", out);
-        fputs("void _z_restore_stdout() {\n", out);
-        fputs("    fflush(stdout);\n", out);
-        fputs("    if (_z_orig_stdout != -1) {\n", out);
-        fputs("        dup2(_z_orig_stdout, STDOUT_FILENO);\n", out);
-        fputs("        close(_z_orig_stdout);\n", out);
-        fputs("        _z_orig_stdout = -1;\n", out);
-        fputs("    }\n", out);
-        fputs("}\n", out);
     }
 }
 
@@ -521,7 +586,35 @@ static char *substitute_proto_self(const char *type_str, const char *replacement
     return xstrdup(type_str);
 }
 
-// Emit trait definitions.
+// Emit the signature of the dispatch wrapper Trait__method for trait method `m`.
+static void emit_trait_wrapper_sig(ASTNode *node, ASTNode *m, FILE *out)
+{
+    const char *orig = parse_original_method_name(m->func.name);
+    char *ret_sub = substitute_proto_self(m->func.ret_type, node->trait.name);
+
+    fprintf(out, "static inline %s %s__%s(%s* self", ret_sub, node->trait.name, orig,
+            node->trait.name);
+    free(ret_sub);
+
+    // parse_trait rejects Self in arguments, so they are emitted as written.
+    int has_self = (m->func.args && strstr(m->func.args, "self"));
+    if (m->func.args)
+    {
+        // The wrapper's own first parameter replaces the receiver.
+        const char *comma = has_self ? strchr(m->func.args, ',') : NULL;
+        if (!has_self)
+        {
+            fprintf(out, ", %s", m->func.args);
+        }
+        else if (comma)
+        {
+            fprintf(out, ", %s", comma + 1);
+        }
+    }
+    fprintf(out, ")");
+}
+
+// Emit trait definitions and prototypes of their dispatch wrappers.
 void emit_trait_defs(ASTNode *node, FILE *out)
 {
     while (node)
@@ -553,131 +646,181 @@ void emit_trait_defs(ASTNode *node, FILE *out)
                     {
                         fprintf(out, ", ");
                     }
-                    char *args_safe = xstrdup(m->func.args);
-                    // TODO: better replace, but for now this works.
-                    char *p = strstr(args_safe, "Self");
-                    while (p)
-                    {
-                        // Check word boundary
-                        if ((p == args_safe || !isalnum(p[-1])) && !isalnum(p[4]))
-                        {
-                            int off = p - args_safe;
-                            char *new_s = xmalloc(strlen(args_safe) + 10);
-                            strncpy(new_s, args_safe, off);
-                            new_s[off] = 0;
-                            strcat(new_s, "void*");
-                            strcat(new_s, p + 4);
-                            free(args_safe);
-                            args_safe = new_s;
-                            p = strstr(args_safe + off + 5, "Self");
-                        }
-                        else
-                        {
-                            p = strstr(p + 1, "Self");
-                        }
-                    }
-
-                    fprintf(out, "%s", args_safe);
-                    free(args_safe);
+                    fprintf(out, "%s", m->func.args);
                 }
                 fprintf(out, ");\n");
                 m = m->next;
             }
             fprintf(out, "} %s_VTable;\n", node->trait.name);
-            fprintf(out, "typedef struct %s { void *self; %s_VTable *vtable; } %s;\n",
+            fprintf(out, "typedef struct %s { void *self; const %s_VTable *vtable; } %s;\n",
                     node->trait.name, node->trait.name, node->trait.name);
 
             m = node->trait.methods;
             while (m)
             {
-                const char *orig = parse_original_method_name(m->func.name);
-                char *ret_sub = substitute_proto_self(m->func.ret_type, node->trait.name);
+                emit_trait_wrapper_sig(node, m, out);
+                fprintf(out, ";\n");
+                m = m->next;
+            }
+            fprintf(out, "\n");
+        }
+        node = node->next;
+    }
+}
 
-                fprintf(out, "%s %s__%s(%s* self", ret_sub, node->trait.name, orig,
-                        node->trait.name);
+// Whether a VTable instance is emitted for trait impl `node`: generic traits and impls on
+// templates get none.
+static int impl_has_vtable(ParserContext *ctx, ASTNode *node)
+{
+    if (!node || node->type != NODE_IMPL_TRAIT)
+    {
+        return 0;
+    }
+    char *trait = node->impl_trait.trait_name;
+    StructRef *search = ctx->parsed_globals_list;
+    while (search)
+    {
+        if (search->node && search->node->type == NODE_TRAIT &&
+            strcmp(search->node->trait.name, trait) == 0)
+        {
+            if (search->node->trait.generic_param_count > 0)
+            {
+                return 0;
+            }
+            break;
+        }
+        search = search->next;
+    }
 
-                int has_self = (m->func.args && strstr(m->func.args, "self"));
-                if (m->func.args)
-                {
-                    if (has_self)
-                    {
-                        char *comma = strchr(m->func.args, ',');
-                        if (comma)
-                        {
-                            // Substitute Self -> TraitName in wrapper args
-                            char *args_sub = xstrdup(comma + 1);
-                            char *p = strstr(args_sub, "Self");
-                            while (p)
-                            {
-                                int off = p - args_sub;
-                                char *new_s =
-                                    xmalloc(strlen(args_sub) + strlen(node->trait.name) + 5);
-                                strncpy(new_s, args_sub, off);
-                                new_s[off] = 0;
-                                strcat(new_s, node->trait.name);
-                                strcat(new_s, p + 4);
-                                free(args_sub);
-                                args_sub = new_s;
-                                p = strstr(args_sub + off + strlen(node->trait.name), "Self");
-                            }
+    char *strct = node->impl_trait.target_type;
+    char *mangled = replace_string_type(strct);
+    ASTNode *def = find_struct_def_codegen(ctx, mangled);
+    int skip = 0;
+    if (def)
+    {
+        if (def->type == NODE_STRUCT && def->strct.is_template)
+        {
+            skip = 1;
+        }
+        else if (def->type == NODE_ENUM && def->enm.is_template)
+        {
+            skip = 1;
+        }
+    }
+    else
+    {
+        char *buf = strip_template_suffix(strct);
+        if (buf)
+        {
+            def = find_struct_def_codegen(ctx, buf);
+            if (def && def->strct.is_template)
+            {
+                skip = 1;
+            }
+            free(buf);
+        }
+    }
+    if (mangled)
+    {
+        free(mangled);
+    }
+    return !skip;
+}
 
-                            fprintf(out, ", %s", args_sub);
-                            free(args_sub);
-                        }
-                    }
-                    else
-                    {
-                        fprintf(out, ", %s", m->func.args); // TODO: recursive subst
-                    }
-                }
-                fprintf(out, ") {\n");
+// The only type with a VTable for `trait`, or NULL if there are none or several. Every trait
+// object is built from one of these VTables, so with a single one its target is known.
+static const char *sole_trait_impl(ParserContext *ctx, const char *trait)
+{
+    const char *sole = NULL;
+    StructRef *ref = ctx->parsed_impls_list;
+    while (ref)
+    {
+        ASTNode *node = ref->node;
+        if (impl_has_vtable(ctx, node) && strcmp(node->impl_trait.trait_name, trait) == 0)
+        {
+            if (sole && strcmp(sole, node->impl_trait.target_type) != 0)
+            {
+                return NULL;
+            }
+            sole = node->impl_trait.target_type;
+        }
+        ref = ref->next;
+    }
+    return sole;
+}
+
+// Emit the bodies of the dispatch wrappers, after the VTable instances. A trait with a single
+// implementation dispatches through that VTable directly; its initializer is constant, so the
+// C compiler resolves the call to the method itself and can inline it.
+void emit_trait_wrappers(ParserContext *ctx, ASTNode *node, FILE *out)
+{
+    while (node)
+    {
+        if (node->type != NODE_TRAIT || node->trait.generic_param_count > 0)
+        {
+            node = node->next;
+            continue;
+        }
+        char table[512];
+        const char *sole = sole_trait_impl(ctx, node->trait.name);
+        if (sole)
+        {
+            snprintf(table, sizeof(table), "%s_%s_VTable.", sole, node->trait.name);
+        }
+        else
+        {
+            strcpy(table, "self->vtable->");
+        }
 
-                int ret_is_self = (strcmp(m->func.ret_type, "Self") == 0);
+        ASTNode *m = node->trait.methods;
+        while (m)
+        {
+            emit_trait_wrapper_sig(node, m, out);
+            fprintf(out, " {\n");
 
-                if (ret_is_self)
-                {
-                    // Special handling: return (Trait){.self = call(), .vtable = self->vtable}
-                    fprintf(out, "    void* ret = self->vtable->%s(self->self", orig);
-                }
-                else
-                {
-                    fprintf(out, "    return self->vtable->%s(self->self", orig);
-                }
+            const char *orig = parse_original_method_name(m->func.name);
+            int has_self = (m->func.args && strstr(m->func.args, "self"));
+            int ret_is_self = (strcmp(m->func.ret_type, "Self") == 0);
 
-                if (m->func.args)
+            if (ret_is_self)
+            {
+                // Special handling: return (Trait){.self = call(), .vtable = self->vtable}
+                fprintf(out, "    void* ret = %s%s(self->self", table, orig);
+            }
+            else
+            {
+                fprintf(out, "    return %s%s(self->self", table, orig);
+            }
+
+            if (m->func.args)
+            {
+                char *call_args = extract_call_args(m->func.args);
+                if (has_self)
                 {
-                    char *call_args = extract_call_args(m->func.args);
-                    if (has_self)
+                    char *comma = strchr(call_args, ',');
+                    if (comma)
                     {
-                        char *comma = strchr(call_args, ',');
-                        if (comma)
-                        {
-                            fprintf(out, ", %s", comma + 1);
-                        }
+                        fprintf(out, ", %s", comma + 1);
                     }
-                    else
-                    {
-                        if (strlen(call_args) > 0)
-                        {
-                            fprintf(out, ", %s", call_args);
-                        }
-                    }
-                    free(call_args);
                 }
-                fprintf(out, ");\n");
-
-                if (ret_is_self)
+                else
                 {
-                    fprintf(out, "    return (%s){.self = ret, .vtable = self->vtable};\n",
-                            node->trait.name);
+                    if (strlen(call_args) > 0)
+                    {
+                        fprintf(out, ", %s", call_args);
+                    }
                 }
+                free(call_args);
+            }
+            fprintf(out, ");\n");
 
-                fprintf(out, "}\n\n");
-                free(ret_sub);
-
-                m = m->next;
+            if (ret_is_self)
+            {
+                fprintf(out, "    return (%s){.self = ret, .vtable = self->vtable};\n",
+                        node->trait.name);
             }
-            fprintf(out, "\n");
+            fprintf(out, "}\n\n");
+            m = m->next;
         }
         node = node->next;
     }
@@ -928,72 +1071,11 @@ void emit_impl_vtables(ParserContext *ctx, FILE *out)
     while (ref)
     {
         ASTNode *node = ref->node;
-        if (node && node->type == NODE_IMPL_TRAIT)
+        if (impl_has_vtable(ctx, node))
         {
             char *trait = node->impl_trait.trait_name;
-
-            // Filter generic traits (VTables for them are not emitted)
-            int is_generic_trait = 0;
-            StructRef *search = ctx->parsed_globals_list;
-            while (search)
-            {
-                if (search->node && search->node->type == NODE_TRAIT &&
-                    strcmp(search->node->trait.name, trait) == 0)
-                {
-                    if (search->node->trait.generic_param_count > 0)
-                    {
-                        is_generic_trait = 1;
-                    }
-                    break;
-                }
-                search = search->next;
-            }
-            if (is_generic_trait)
-            {
-                ref = ref->next;
-                continue;
-            }
-
             char *strct = node->impl_trait.target_type;
 
-            // Filter templates
-            char *mangled = replace_string_type(strct);
-            ASTNode *def = find_struct_def_codegen(ctx, mangled);
-            int skip = 0;
-            if (def)
-            {
-                if (def->type == NODE_STRUCT && def->strct.is_template)
-                {
-                    skip = 1;
-                }
-                else if (def->type == NODE_ENUM && def->enm.is_template)
-                {
-                    skip = 1;
-                }
-            }
-            else
-            {
-                char *buf = strip_template_suffix(strct);
-                if (buf)
-                {
-                    def = find_struct_def_codegen(ctx, buf);
-                    if (def && def->strct.is_template)
-                    {
-                        skip = 1;
-                    }
-                    free(buf);
-                }
-            }
-            if (mangled)
-            {
-                free(mangled);
-            }
-            if (skip)
-            {
-                ref = ref->next;
-                continue;
-            }
-
             // Check duplication
             int dup = 0;
             for (int i = 0; i < count; i++)
@@ -1021,7 +1103,7 @@ void emit_impl_vtables(ParserContext *ctx, FILE *out)
                 continue;
             }
 
-            fprintf(out, "%s_VTable %s_%s_VTable = {", trait, strct, trait);
+            fprintf(out, "static const %s_VTable %s_%s_VTable = {", trait, strct, trait);
 
             ASTNode *m = node->impl_trait.methods;
             while (m)
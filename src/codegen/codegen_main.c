@@ -1,115 +1,75 @@
 
 #include "../ast/ast.h"
 #include "../zprep.h"
+#include "analysis/escape.h"
 #include "codegen.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-// Helper: Check if a struct depends on another struct/enum by-value.
-static int struct_depends_on(ASTNode *s1, const char *target_name)
+// Name a field or payload of this type depends on by value: the type without
+// any struct/enum/union keyword or array suffix. Pointers don't create an
+// ordering dependency, so they have none.
+static InternedStr by_value_dep(const char *type_str)
 {
-    if (!s1)
+    if (strchr(type_str, '*'))
     {
-        return 0;
+        return NULL;
     }
 
-    // Check structs
-    if (s1->type == NODE_STRUCT)
+    const char *clean = type_str;
+    if (strncmp(clean, "struct ", 7) == 0)
     {
-        ASTNode *field = s1->strct.fields;
-        while (field)
-        {
-            if (field->type == NODE_FIELD && field->field.type)
-            {
-                char *type_str = field->field.type;
-
-                // Skip pointers - they don't create ordering dependency.
-                if (strchr(type_str, '*'))
-                {
-                    field = field->next;
-                    continue;
-                }
-
-                // Clean type string (remove struct/enum prefixes)
-                const char *clean = type_str;
-                if (strncmp(clean, "struct ", 7) == 0)
-                {
-                    clean += 7;
-                }
-                else if (strncmp(clean, "enum ", 5) == 0)
-                {
-                    clean += 5;
-                }
-                else if (strncmp(clean, "union ", 6) == 0)
-                {
-                    clean += 6;
-                }
+        clean += 7;
+    }
+    else if (strncmp(clean, "enum ", 5) == 0)
+    {
+        clean += 5;
+    }
+    else if (strncmp(clean, "union ", 6) == 0)
+    {
+        clean += 6;
+    }
+    return intern_n(clean, strcspn(clean, "[ \t\n\v\f\r"));
+}
 
-                // Check for match
-                size_t len = strlen(target_name);
-                if (strncmp(clean, target_name, len) == 0)
-                {
-                    char next = clean[len];
-                    if (next == 0 || next == '[' || isspace(next))
-                    {
-                        return 1;
-                    }
-                }
-            }
-            field = field->next;
-        }
+// Append the by-value dependencies of a struct's fields or an enum's payloads.
+static void collect_by_value_deps(ASTNode *s1, InternedStr **deps, int *count, int *cap)
+{
+    ASTNode *member = NULL;
+    if (s1->type == NODE_STRUCT)
+    {
+        member = s1->strct.fields;
     }
-    // Check enums (ADTs)
     else if (s1->type == NODE_ENUM)
     {
-        ASTNode *variant = s1->enm.variants;
-        while (variant)
-        {
-            if (variant->type == NODE_ENUM_VARIANT && variant->variant.payload)
-            {
-                char *type_str = type_to_string(variant->variant.payload);
-                if (type_str)
-                {
-                    if (strchr(type_str, '*'))
-                    {
-                        free(type_str);
-                        variant = variant->next;
-                        continue;
-                    }
+        member = s1->enm.variants;
+    }
 
-                    const char *clean = type_str;
-                    if (strncmp(clean, "struct ", 7) == 0)
-                    {
-                        clean += 7;
-                    }
-                    else if (strncmp(clean, "enum ", 5) == 0)
-                    {
-                        clean += 5;
-                    }
-                    else if (strncmp(clean, "union ", 6) == 0)
-                    {
-                        clean += 6;
-                    }
+    for (; member; member = member->next)
+    {
+        InternedStr dep = NULL;
+        if (member->type == NODE_FIELD && member->field.type)
+        {
+            dep = by_value_dep(member->field.type);
+        }
+        else if (member->type == NODE_ENUM_VARIANT && member->variant.payload)
+        {
+            char *type_str = type_to_string(member->variant.payload);
+            dep = by_value_dep(type_str);
+            free(type_str);
+        }
 
-                    size_t len = strlen(target_name);
-                    if (strncmp(clean, target_name, len) == 0)
-                    {
-                        char next = clean[len];
-                        if (next == 0 || next == '[' || isspace(next))
-                        {
-                            free(type_str);
-                            return 1;
-                        }
-                    }
-                    free(type_str);
-                }
+        if (dep)
+        {
+            if (*count == *cap)
+            {
+                *cap = *cap ? *cap * 2 : 64;
+                *deps = realloc(*deps, sizeof(InternedStr) * *cap);
             }
-            variant = variant->next;
+            (*deps)[(*count)++] = dep;
         }
     }
-
-    return 0;
 }
 
 // Topologically sort a list of struct/enum nodes.
@@ -150,6 +110,65 @@ static ASTNode *topo_sort_structs(ASTNode *head)
         n = n->next;
     }
 
+    // Resolve each node's by-value dependencies to the nodes of that name
+    // once, so a pass below only looks at real edges.
+    InternMap by_name = {0}; // Name -> first node of that name.
+    int *same_name = malloc(count * sizeof(int));
+    for (int i = count - 1; i >= 0; i--)
+    {
+        const char *name = NULL;
+        if (nodes[i]->type == NODE_STRUCT)
+        {
+            name = nodes[i]->strct.name;
+        }
+        else if (nodes[i]->type == NODE_ENUM)
+        {
+            name = nodes[i]->enm.name;
+        }
+
+        same_name[i] = -1;
+        if (name)
+        {
+            ASTNode ***slot = (ASTNode ***)intern_map_slot(&by_name, intern(name));
+            if (*slot)
+            {
+                same_name[i] = *slot - nodes;
+            }
+            *slot = &nodes[i];
+        }
+    }
+
+    int *dep_start = malloc((count + 1) * sizeof(int));
+    int *dep_nodes = NULL;
+    int dep_count = 0;
+    int dep_cap = 0;
+    InternedStr *names = NULL;
+    int names_cap = 0;
+    for (int i = 0; i < count; i++)
+    {
+        dep_start[i] = dep_count;
+        int name_count = 0;
+        collect_by_value_deps(nodes[i], &names, &name_count, &names_cap);
+        for (int k = 0; k < name_count; k++)
+        {
+            ASTNode **first = intern_map_get(&by_name, names[k]);
+            for (int j = first ? (int)(first - nodes) : -1; j >= 0; j = same_name[j])
+            {
+                if (j == i)
+                {
+                    continue;
+                }
+                if (dep_count == dep_cap)
+                {
+                    dep_cap = dep_cap ? dep_cap * 2 : 256;
+                    dep_nodes = realloc(dep_nodes, dep_cap * sizeof(int));
+                }
+                dep_nodes[dep_count++] = j;
+            }
+        }
+    }
+    dep_start[count] = dep_count;
+
     // Build order array (indices in emission order).
     int *order = malloc(count * sizeof(int));
     int order_idx = 0;
@@ -181,25 +200,9 @@ static ASTNode *topo_sort_structs(ASTNode *head)
 
             // For structs/enums, check if all dependencies are emitted.
             int can_emit = 1;
-            for (int j = 0; j < count; j++)
+            for (int d = dep_start[i]; d < dep_start[i + 1]; d++)
             {
-                if (i == j || emitted[j])
-                {
-                    continue;
-                }
-
-                // Get the name of the potential dependency.
-                const char *dep_name = NULL;
-                if (nodes[j]->type == NODE_STRUCT)
-                {
-                    dep_name = nodes[j]->strct.name;
-                }
-                else if (nodes[j]->type == NODE_ENUM)
-                {
-                    dep_name = nodes[j]->enm.name;
-                }
-
-                if (dep_name && struct_depends_on(nodes[i], dep_name))
+                if (!emitted[dep_nodes[d]])
                 {
                     can_emit = 0;
                     break;
@@ -250,6 +253,10 @@ static ASTNode *topo_sort_structs(ASTNode *head)
     free(nodes);
     free(emitted);
     free(order);
+    free(same_name);
+    free(dep_start);
+    free(dep_nodes);
+    free(names);
     return result;
 }
 
@@ -309,10 +316,14 @@ void codegen_node(ParserContext *ctx, ASTNode *node, FILE *out)
         }
 
         global_user_structs = kids;
+        index_global_user_structs();
+        mark_local_lambdas(ctx, kids);
 
         if (!ctx->skip_preamble)
         {
-            emit_preamble(ctx, out);
+            emit_preamble_parts(ctx, out,
+                                ctx->preamble_pch ? PREAMBLE_DEFS
+                                                  : PREAMBLE_DECLS | PREAMBLE_DEFS);
             fflush(out);
         }
         emit_includes_and_aliases(kids, out);
@@ -451,6 +462,8 @@ void codegen_node(ParserContext *ctx, ASTNode *node, FILE *out)
 
         // Also emit traits from parsed_globals_list (from auto-imported files like std/mem.zc)
         // but only if they weren't already emitted from kids
+        ASTNode *imported_traits = NULL;
+        ASTNode *imported_traits_tail = NULL;
         StructRef *trait_ref = ctx->parsed_globals_list;
         while (trait_ref)
         {
@@ -472,15 +485,23 @@ void codegen_node(ParserContext *ctx, ASTNode *node, FILE *out)
 
                 if (!already_in_kids)
                 {
-                    // Create a temporary single-node list for emit_trait_defs
-                    ASTNode *saved_next = trait_ref->node->next;
-                    trait_ref->node->next = NULL;
-                    emit_trait_defs(trait_ref->node, out);
-                    trait_ref->node->next = saved_next;
+                    ASTNode *copy = xmalloc(sizeof(ASTNode));
+                    *copy = *trait_ref->node;
+                    copy->next = NULL;
+                    if (!imported_traits)
+                    {
+                        imported_traits = copy;
+                    }
+                    else
+                    {
+                        imported_traits_tail->next = copy;
+                    }
+                    imported_traits_tail = copy;
                 }
             }
             trait_ref = trait_ref->next;
         }
+        emit_trait_defs(imported_traits, out);
 
         // Track emitted raw statements to prevent duplicates
         EmittedContent *emitted_raw = NULL;
@@ -652,6 +673,8 @@ void codegen_node(ParserContext *ctx, ASTNode *node, FILE *out)
         emit_protos(ctx, merged_funcs, out);
 
         emit_impl_vtables(ctx, out);
+        emit_trait_wrappers(ctx, kids, out);
+        emit_trait_wrappers(ctx, imported_traits, out);
 
         emit_lambda_defs(ctx, out);
 
@@ -0,0 +1,737 @@
+#include "../zprep.h"
+#include "codegen.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Splits the generated C program into a header shared by every translation
+// unit and function bodies spread over several units.
+//
+// The split works on the C text at file scope, not on the AST, so code that
+// never went through codegen (raw blocks, plugin output, the preamble) is
+// split by the same rules:
+//   - preprocessor lines, types, prototypes, extern declarations and static
+//     definitions go to the header (static functions get one copy per unit);
+//   - function definitions move to a unit, leaving a prototype behind;
+//   - object definitions move to unit 0, leaving an extern declaration;
+//   - included C sources (#include "x.c") move to unit 0; local headers that
+//     define functions or objects themselves prevent the split.
+// Conditional directives around a moved definition are repeated around it.
+
+typedef enum
+{
+    ITEM_HEADER, ///< Copied to the header as is.
+    ITEM_FUNC,   ///< Function definition: prototype in the header, body in a unit.
+    ITEM_OBJECT, ///< Object definition: extern declaration in the header, definition in unit 0.
+    ITEM_SOURCE  ///< #include of a C source file: unit 0 only.
+} SplitItemKind;
+
+typedef struct
+{
+    SplitItemKind kind;
+    size_t start;      ///< Offset of the item in the source.
+    size_t end;        ///< Offset one past the item.
+    size_t decl_end;   ///< End of the declaration part (before '{' or '=').
+    char *cond_open;   ///< Enclosing conditional directives, or NULL.
+    int cond_depth;    ///< Number of enclosing conditionals.
+    int unit;          ///< Unit a moved item goes to.
+} SplitItem;
+
+typedef struct
+{
+    const char *src;
+    size_t len;
+    SplitItem *items;
+    int count;
+    int cap;
+    char *cond[64]; ///< Directive lines of each open conditional.
+    int cond_depth;
+    const char *error; ///< Why the code cannot be split.
+    const char *dir;   ///< Directory of the scanned file, for quoted includes.
+    int include_depth; ///< Nesting of scanned local headers.
+} Splitter;
+
+static int scan_items(Splitter *s);
+
+static char *read_all(const char *path, size_t *len)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f)
+    {
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    long n = ftell(f);
+    rewind(f);
+    char *buf = xmalloc(n + 1);
+    *len = fread(buf, 1, n, f);
+    buf[*len] = 0;
+    fclose(f);
+    return buf;
+}
+
+static void add_item(Splitter *s, SplitItem item)
+{
+    if (s->count == s->cap)
+    {
+        s->cap = s->cap ? s->cap * 2 : 256;
+        s->items = xrealloc(s->items, sizeof(SplitItem) * s->cap);
+    }
+    s->items[s->count++] = item;
+}
+
+// Skip a comment, string or character literal starting at `i`.
+static size_t skip_literal(const char *src, size_t len, size_t i)
+{
+    if (src[i] == '/' && i + 1 < len && src[i + 1] == '/')
+    {
+        while (i < len && src[i] != '\n')
+        {
+            i++;
+        }
+        return i;
+    }
+    if (src[i] == '/' && i + 1 < len && src[i + 1] == '*')
+    {
+        i += 2;
+        while (i + 1 < len && !(src[i] == '*' && src[i + 1] == '/'))
+        {
+            i++;
+        }
+        return i + 2 <= len ? i + 2 : len;
+    }
+    if (src[i] == '"' || src[i] == '\'')
+    {
+        char q = src[i++];
+        while (i < len && src[i] != q)
+        {
+            if (src[i] == '\\')
+            {
+                i++;
+            }
+            i++;
+        }
+        return i < len ? i + 1 : len;
+    }
+    return i;
+}
+
+// 1 if `word` appears as an identifier in src[start, end).
+static int has_word(const char *src, size_t start, size_t end, const char *word)
+{
+    size_t n = strlen(word);
+    for (size_t i = start; i + n <= end; i++)
+    {
+        if (strncmp(src + i, word, n) == 0 &&
+            (i == start || !(isalnum((unsigned char)src[i - 1]) || src[i - 1] == '_')) &&
+            (i + n == end || !(isalnum((unsigned char)src[i + n]) || src[i + n] == '_')))
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int starts_with_word(const char *src, size_t start, size_t end, const char *word)
+{
+    size_t n = strlen(word);
+    return start + n <= end && strncmp(src + start, word, n) == 0 &&
+           (start + n == end || !(isalnum((unsigned char)src[start + n]) || src[start + n] == '_'));
+}
+
+static char *cond_open(Splitter *s);
+
+// A local header must only declare: its definitions would be compiled into
+// every unit that includes it.
+static void check_local_include(Splitter *s, const char *name)
+{
+    size_t n = strlen(name);
+    if (n > 2 && strcmp(name + n - 2, ".c") == 0)
+    {
+        SplitItem *it = &s->items[s->count - 1];
+        it->kind = ITEM_SOURCE;
+        it->cond_open = cond_open(s);
+        it->cond_depth = s->cond_depth;
+        return;
+    }
+    if (s->include_depth >= 8)
+    {
+        return;
+    }
+
+    char path[1024];
+    Splitter inc = {0};
+    snprintf(path, sizeof(path), "%s/%s", s->dir, name);
+    inc.src = read_all(path, &inc.len);
+    if (!inc.src)
+    {
+        snprintf(path, sizeof(path), "%s", name);
+        inc.src = read_all(path, &inc.len);
+    }
+    if (!inc.src)
+    {
+        return; // Found on the include path: a library header.
+    }
+
+    char dir[1024];
+    snprintf(dir, sizeof(dir), "%s", path);
+    char *sep = z_path_last_sep(dir);
+    if (sep)
+    {
+        *sep = 0;
+    }
+    else
+    {
+        strcpy(dir, ".");
+    }
+    inc.dir = dir;
+    inc.include_depth = s->include_depth + 1;
+
+    int defines = !scan_items(&inc);
+    for (int i = 0; i < inc.count && !defines; i++)
+    {
+        defines = inc.items[i].kind != ITEM_HEADER;
+    }
+    if (defines)
+    {
+        static char error[1100];
+        snprintf(error, sizeof(error), "%s defines functions or objects", path);
+        s->error = error;
+    }
+}
+
+// Track #if/#elif/#else/#endif so moved items keep their conditions, and
+// check local #includes.
+static void directive(Splitter *s, size_t start, size_t end)
+{
+    size_t i = start + 1;
+    while (i < end && (s->src[i] == ' ' || s->src[i] == '\t'))
+    {
+        i++;
+    }
+    char *line = xmalloc(end - start + 2);
+    memcpy(line, s->src + start, end - start);
+    line[end - start] = '\n';
+    line[end - start + 1] = 0;
+
+    if (starts_with_word(s->src, i, end, "if") || starts_with_word(s->src, i, end, "ifdef") ||
+        starts_with_word(s->src, i, end, "ifndef"))
+    {
+        if (s->cond_depth == 64)
+        {
+            s->error = "conditionals nested too deeply";
+            return;
+        }
+        s->cond[s->cond_depth++] = line;
+    }
+    else if (starts_with_word(s->src, i, end, "elif") || starts_with_word(s->src, i, end, "else"))
+    {
+        if (s->cond_depth > 0)
+        {
+            char *top = s->cond[s->cond_depth - 1];
+            char *joined = xmalloc(strlen(top) + strlen(line) + 1);
+            strcpy(joined, top);
+            strcat(joined, line);
+            s->cond[s->cond_depth - 1] = joined;
+        }
+    }
+    else if (starts_with_word(s->src, i, end, "endif"))
+    {
+        if (s->cond_depth > 0)
+        {
+            s->cond_depth--;
+        }
+    }
+    else if (starts_with_word(s->src, i, end, "include"))
+    {
+        const char *open = memchr(s->src + i, '"', end - i);
+        const char *close = open ? memchr(open + 1, '"', s->src + end - open - 1) : NULL;
+        if (close && close - open < 1000)
+        {
+            char name[1024];
+            memcpy(name, open + 1, close - open - 1);
+            name[close - open - 1] = 0;
+            check_local_include(s, name);
+        }
+    }
+}
+
+// The directives that reproduce the current conditional branch.
+static char *cond_open(Splitter *s)
+{
+    if (s->cond_depth == 0)
+    {
+        return NULL;
+    }
+    size_t n = 1;
+    for (int i = 0; i < s->cond_depth; i++)
+    {
+        n += strlen(s->cond[i]);
+    }
+    char *open = xmalloc(n);
+    open[0] = 0;
+    for (int i = 0; i < s->cond_depth; i++)
+    {
+        strcat(open, s->cond[i]);
+    }
+    return open;
+}
+
+// A declaration that defines an object (as opposed to a type, a prototype or
+// an extern declaration).
+static int is_object_decl(const char *src, size_t start, size_t end, size_t eq)
+{
+    if (starts_with_word(src, start, end, "typedef") ||
+        starts_with_word(src, start, end, "extern") ||
+        starts_with_word(src, start, end, "_Static_assert") ||
+        starts_with_word(src, start, end, "static_assert"))
+    {
+        return 0;
+    }
+    if (eq != (size_t)-1)
+    {
+        return 1;
+    }
+
+    // Prototype: the first top-level '(' opens a parameter list, not "(*name)".
+    int depth = 0;
+    for (size_t i = start; i < end; i++)
+    {
+        i = skip_literal(src, end, i);
+        if (i >= end)
+        {
+            break;
+        }
+        char c = src[i];
+        if (c == '{')
+        {
+            depth++;
+        }
+        else if (c == '}')
+        {
+            depth--;
+        }
+        else if (c == '(' && depth == 0)
+        {
+            size_t j = i + 1;
+            while (j < end && isspace((unsigned char)src[j]))
+            {
+                j++;
+            }
+            return j < end && src[j] == '*';
+        }
+    }
+
+    // struct/union/enum definitions and forward declarations declare no object
+    // unless a declarator follows the tag or the closing brace.
+    size_t i = start;
+    if (starts_with_word(src, i, end, "struct") || starts_with_word(src, i, end, "union") ||
+        starts_with_word(src, i, end, "enum"))
+    {
+        const char *close = NULL;
+        for (size_t k = end; k > start; k--)
+        {
+            if (src[k - 1] == '}')
+            {
+                close = src + k;
+                break;
+            }
+        }
+        if (!close)
+        {
+            // "struct X;" has exactly two words.
+            int words = 0;
+            for (size_t k = start; k < end; k++)
+            {
+                if ((isalnum((unsigned char)src[k]) || src[k] == '_') &&
+                    (k == start || !(isalnum((unsigned char)src[k - 1]) || src[k - 1] == '_')))
+                {
+                    words++;
+                }
+            }
+            return words > 2;
+        }
+        while (close < src + end && isspace((unsigned char)*close))
+        {
+            close++;
+        }
+        return *close != ';';
+    }
+    return 1;
+}
+
+// A static object is safe to duplicate in every unit only if it is const.
+static int is_const_object(const char *src, size_t start, size_t decl_end)
+{
+    size_t from = start;
+    for (size_t i = start; i < decl_end; i++)
+    {
+        if (src[i] == '*')
+        {
+            from = i + 1;
+        }
+    }
+    return has_word(src, from, decl_end, "const");
+}
+
+static void classify_decl(Splitter *s, size_t start, size_t end, size_t eq)
+{
+    SplitItem item = {ITEM_HEADER, start, end, end, NULL, 0, 0};
+    if (is_object_decl(s->src, start, end, eq))
+    {
+        size_t decl_end = eq != (size_t)-1 ? eq : end - 1; // before '=' or ';'
+        if (has_word(s->src, start, decl_end, "static"))
+        {
+            if (!is_const_object(s->src, start, decl_end))
+            {
+                s->error = "mutable static object at file scope";
+            }
+        }
+        else
+        {
+            // Several declarators, or an unsized array, have no simple extern form.
+            int depth = 0;
+            for (size_t i = start; i < decl_end; i++)
+            {
+                i = skip_literal(s->src, decl_end, i);
+                if (i >= decl_end)
+                {
+                    break;
+                }
+                char c = s->src[i];
+                depth += (c == '(' || c == '[' || c == '{') - (c == ')' || c == ']' || c == '}');
+                if (c == ',' && depth == 0)
+                {
+                    s->error = "object definition with several declarators";
+                }
+            }
+            size_t k = decl_end;
+            while (k > start && isspace((unsigned char)s->src[k - 1]))
+            {
+                k--;
+            }
+            if (k >= start + 2 && s->src[k - 1] == ']' && s->src[k - 2] == '[')
+            {
+                s->error = "object definition of an unsized array";
+            }
+            item.kind = ITEM_OBJECT;
+            item.decl_end = decl_end;
+            item.cond_open = cond_open(s);
+            item.cond_depth = s->cond_depth;
+        }
+    }
+    add_item(s, item);
+}
+
+static void classify_func(Splitter *s, size_t start, size_t end, size_t brace)
+{
+    SplitItem item = {ITEM_HEADER, start, end, brace, NULL, 0, 0};
+    if (!has_word(s->src, start, brace, "static"))
+    {
+        item.kind = ITEM_FUNC;
+        item.cond_open = cond_open(s);
+        item.cond_depth = s->cond_depth;
+    }
+    add_item(s, item);
+}
+
+// Split `src` into file-scope items. Returns 0 on code it cannot follow.
+static int scan_items(Splitter *s)
+{
+    const char *src = s->src;
+    size_t len = s->len;
+    size_t i = 0;
+
+    while (i < len && !s->error)
+    {
+        if (isspace((unsigned char)src[i]))
+        {
+            i++;
+            continue;
+        }
+
+        size_t start = i;
+        if (src[i] == '#')
+        {
+            while (i < len && !(src[i] == '\n' && src[i - 1] != '\\'))
+            {
+                i++;
+            }
+            add_item(s, (SplitItem){ITEM_HEADER, start, i, i, NULL, 0, 0});
+            directive(s, start, i);
+            continue;
+        }
+        if (src[i] == '/' && i + 1 < len && (src[i + 1] == '/' || src[i + 1] == '*'))
+        {
+            i = skip_literal(src, len, i);
+            add_item(s, (SplitItem){ITEM_HEADER, start, i, i, NULL, 0, 0});
+            continue;
+        }
+        // Linkage blocks (extern "C" { ... }) do not nest their contents.
+        if (starts_with_word(src, i, len, "extern"))
+        {
+            size_t k = i + 6;
+            while (k < len && isspace((unsigned char)src[k]))
+            {
+                k++;
+            }
+            if (k + 3 <= len && strncmp(src + k, "\"C\"", 3) == 0)
+            {
+                k += 3;
+                while (k < len && isspace((unsigned char)src[k]))
+                {
+                    k++;
+                }
+                if (k < len && src[k] == '{')
+                {
+                    i = k + 1;
+                    add_item(s, (SplitItem){ITEM_HEADER, start, i, i, NULL, 0, 0});
+                    continue;
+                }
+            }
+        }
+        if (src[i] == '}')
+        {
+            i++;
+            add_item(s, (SplitItem){ITEM_HEADER, start, i, i, NULL, 0, 0});
+            continue;
+        }
+
+        int paren = 0;
+        int brace = 0;
+        size_t eq = (size_t)-1;
+        size_t body = (size_t)-1;
+        int is_func = 0;
+        int done = 0;
+        while (i < len && !done)
+        {
+            size_t next = skip_literal(src, len, i);
+            if (next != i)
+            {
+                i = next;
+                continue;
+            }
+            char c = src[i];
+            if (c == '(' || c == '[')
+            {
+                paren++;
+            }
+            else if (c == ')' || c == ']')
+            {
+                paren--;
+            }
+            else if (c == '=' && paren == 0 && brace == 0 && eq == (size_t)-1 &&
+                     body == (size_t)-1)
+            {
+                eq = i;
+            }
+            else if (c == '{')
+            {
+                if (brace == 0 && paren == 0 && body == (size_t)-1)
+                {
+                    body = i;
+                    size_t k = i;
+                    while (k > start && isspace((unsigned char)src[k - 1]))
+                    {
+                        k--;
+                    }
+                    is_func = eq == (size_t)-1 && k > start && src[k - 1] == ')';
+                }
+                brace++;
+            }
+            else if (c == '}')
+            {
+                brace--;
+                if (brace == 0 && is_func)
+                {
+                    done = 1;
+                }
+            }
+            else if (c == ';' && brace == 0 && paren == 0)
+            {
+                done = 1;
+            }
+            i++;
+        }
+        if (!done)
+        {
+            s->error = "unterminated declaration";
+            break;
+        }
+
+        if (is_func)
+        {
+            classify_func(s, start, i, body);
+        }
+        else
+        {
+            classify_decl(s, start, i, eq);
+        }
+    }
+    return s->error == NULL;
+}
+
+static void write_trimmed(FILE *out, const char *src, size_t start, size_t end)
+{
+    while (end > start && isspace((unsigned char)src[end - 1]))
+    {
+        end--;
+    }
+    fwrite(src + start, 1, end - start, out);
+}
+
+// Prototype of a moved function: its signature without "inline", so other
+// units see an ordinary external declaration.
+static void write_proto(FILE *out, const char *src, const SplitItem *it)
+{
+    size_t end = it->decl_end;
+    while (end > it->start && isspace((unsigned char)src[end - 1]))
+    {
+        end--;
+    }
+    for (size_t i = it->start; i < end; i++)
+    {
+        if ((i == it->start || !(isalnum((unsigned char)src[i - 1]) || src[i - 1] == '_')) &&
+            starts_with_word(src, i, end, "inline"))
+        {
+            i += 6;
+            while (i < end && isspace((unsigned char)src[i]))
+            {
+                i++;
+            }
+            i--;
+            continue;
+        }
+        fputc(src[i], out);
+    }
+    fputs(";\n", out);
+}
+
+static void write_moved(FILE *out, const char *src, const SplitItem *it)
+{
+    if (it->cond_open)
+    {
+        fputs(it->cond_open, out);
+    }
+    fwrite(src + it->start, 1, it->end - it->start, out);
+    fputc('\n', out);
+    for (int d = 0; d < it->cond_depth; d++)
+    {
+        fputs("#endif\n", out);
+    }
+}
+
+// Give each unit a contiguous run of functions of about the same size, so a
+// module's functions (and each batch of instantiations) stay together.
+static int assign_units(Splitter *s, int units)
+{
+    size_t total = 0;
+    int funcs = 0;
+    for (int i = 0; i < s->count; i++)
+    {
+        if (s->items[i].kind == ITEM_FUNC)
+        {
+            total += s->items[i].end - s->items[i].start;
+            funcs++;
+        }
+    }
+    if (units > funcs)
+    {
+        units = funcs;
+    }
+    if (units < 1)
+    {
+        units = 1;
+    }
+
+    int unit = 0;
+    size_t done = 0;
+    for (int i = 0; i < s->count; i++)
+    {
+        SplitItem *it = &s->items[i];
+        if (it->kind != ITEM_FUNC)
+        {
+            continue;
+        }
+        while (unit + 1 < units && done >= total * (unit + 1) / units)
+        {
+            unit++;
+        }
+        it->unit = unit;
+        done += it->end - it->start;
+    }
+    return units;
+}
+
+int codegen_split_units(const char *c_file, const char *stem, int units)
+{
+    Splitter s = {0};
+    s.dir = ".";
+    s.src = read_all(c_file, &s.len);
+    if (!s.src)
+    {
+        return 0;
+    }
+    if (!scan_items(&s))
+    {
+        if (g_config.verbose)
+        {
+            printf(COLOR_BOLD COLOR_BLUE "       Split" COLOR_RESET " skipped: %s\n", s.error);
+        }
+        return 0;
+    }
+    units = assign_units(&s, units);
+
+    char path[1024];
+    snprintf(path, sizeof(path), "%s.h", stem);
+    FILE *header = fopen(path, "w");
+    if (!header)
+    {
+        return 0;
+    }
+    for (int i = 0; i < s.count; i++)
+    {
+        SplitItem *it = &s.items[i];
+        switch (it->kind)
+        {
+        case ITEM_HEADER:
+            fwrite(s.src + it->start, 1, it->end - it->start, header);
+            fputc('\n', header);
+            break;
+        case ITEM_FUNC:
+            write_proto(header, s.src, it);
+            break;
+        case ITEM_OBJECT:
+            fputs("extern ", header);
+            write_trimmed(header, s.src, it->start, it->decl_end);
+            fputs(";\n", header);
+            break;
+        case ITEM_SOURCE:
+            break;
+        }
+    }
+    fclose(header);
+
+    for (int u = 0; u < units; u++)
+    {
+        snprintf(path, sizeof(path), "%s_%d.c", stem, u);
+        FILE *out = fopen(path, "w");
+        if (!out)
+        {
+            return 0;
+        }
+        fprintf(out, "#include \"%s.h\"\n", stem);
+        for (int i = 0; i < s.count; i++)
+        {
+            SplitItem *it = &s.items[i];
+            if (((it->kind == ITEM_OBJECT || it->kind == ITEM_SOURCE) && u == 0) ||
+                (it->kind == ITEM_FUNC && it->unit == u))
+            {
+                write_moved(out, s.src, it);
+            }
+        }
+        fclose(out);
+    }
+    return units;
+}
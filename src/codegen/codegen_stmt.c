@@ -3,6 +3,7 @@
 #include "zprep.h"
 #include "../constants.h"
 #include <ctype.h>
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -149,6 +150,497 @@ static void emit_pattern_condition(ParserContext *ctx, const char *pattern, int
     }
 }
 
+#define STRING_DISPATCH_MIN 4 ///< String patterns from which a match dispatches on length.
+
+/**
+ * @brief A string literal pattern of a match on a string.
+ */
+typedef struct
+{
+    const char *literal; ///< Pattern as written (a C string literal).
+    char *bytes;         ///< Its contents.
+    int len;             ///< Length of `bytes`.
+    int arm;             ///< Index of the first arm it matches.
+} StringArm;
+
+static int hex_digit(char c)
+{
+    if (c >= '0' && c <= '9')
+    {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f')
+    {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F')
+    {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+// Value of the escape sequence after the backslash at `*p` (advanced past it),
+// or -1 if it is not a plain C escape.
+static int decode_escape(const char **p, const char *end)
+{
+    const char *s = *p;
+    int c;
+    switch (*s)
+    {
+    case 'n':
+        c = '\n';
+        break;
+    case 't':
+        c = '\t';
+        break;
+    case 'r':
+        c = '\r';
+        break;
+    case 'a':
+        c = '\a';
+        break;
+    case 'b':
+        c = '\b';
+        break;
+    case 'f':
+        c = '\f';
+        break;
+    case 'v':
+        c = '\v';
+        break;
+    case '\\':
+    case '"':
+    case '\'':
+    case '?':
+        c = *s;
+        break;
+    case 'x':
+        c = 0;
+        if (s + 1 >= end || hex_digit(s[1]) < 0)
+        {
+            return -1;
+        }
+        while (s + 1 < end && hex_digit(s[1]) >= 0 && c <= 255)
+        {
+            c = c * 16 + hex_digit(*++s);
+        }
+        break;
+    default:
+        if (*s < '0' || *s > '7')
+        {
+            return -1;
+        }
+        c = *s - '0';
+        for (int k = 0; k < 2 && s + 1 < end && s[1] >= '0' && s[1] <= '7'; k++)
+        {
+            c = c * 8 + (*++s - '0');
+        }
+        break;
+    }
+    *p = s + 1;
+    return c <= 255 ? c : -1;
+}
+
+// Contents of the string literal `lit`, or NULL if it is not a plain literal
+// or holds a NUL byte (strcmp would stop there).
+static char *decode_string_pattern(const char *lit, int *len)
+{
+    size_t n = strlen(lit);
+    if (n < 2 || lit[0] != '"' || lit[n - 1] != '"')
+    {
+        return NULL;
+    }
+    const char *end = lit + n - 1;
+    char *buf = xmalloc(n);
+    int out = 0;
+    for (const char *p = lit + 1; p < end;)
+    {
+        int c = (unsigned char)*p++;
+        if (c == '"')
+        {
+            return NULL;
+        }
+        if (c == '\\')
+        {
+            c = p < end ? decode_escape(&p, end) : -1;
+        }
+        if (c <= 0)
+        {
+            return NULL;
+        }
+        buf[out++] = (char)c;
+    }
+    *len = out;
+    return buf;
+}
+
+// Next alternative of a pattern (alternatives are joined with '|', which may
+// also appear in a string or char literal), advancing `*p` past it.
+static char *next_alternative(const char **p)
+{
+    const char *start = *p;
+    const char *end = start;
+    char quote = 0;
+    for (; *end && (quote || *end != '|'); end++)
+    {
+        if (*end == '\\' && quote && end[1])
+        {
+            end++;
+        }
+        else if (*end == '"' || *end == '\'')
+        {
+            quote = quote == *end ? 0 : (quote ? quote : *end);
+        }
+    }
+    char *alt = xmalloc(end - start + 1);
+    memcpy(alt, start, end - start);
+    alt[end - start] = 0;
+    *p = *end ? end + 1 : end;
+    return alt;
+}
+
+// Collect the string patterns of a match. Returns their count, or 0 if an arm
+// has another kind of pattern, a guard or bindings.
+static int collect_string_arms(ASTNode *cases, StringArm **arms_out)
+{
+    StringArm *arms = NULL;
+    int count = 0;
+    int arm = 0;
+    for (ASTNode *c = cases; c; c = c->next, arm++)
+    {
+        const char *p = c->match_case.pattern;
+        if (strcmp(p, "_") == 0)
+        {
+            continue;
+        }
+        if (c->match_case.guard || c->match_case.binding_count > 0)
+        {
+            return 0;
+        }
+        while (*p)
+        {
+            char *lit = next_alternative(&p);
+            int len;
+            char *bytes = decode_string_pattern(lit, &len);
+            if (!bytes)
+            {
+                return 0;
+            }
+            int seen = 0;
+            for (int i = 0; i < count && !seen; i++)
+            {
+                seen = arms[i].len == len && memcmp(arms[i].bytes, bytes, len) == 0;
+            }
+            if (!seen)
+            {
+                arms = xrealloc(arms, sizeof(StringArm) * (count + 1));
+                arms[count++] = (StringArm){lit, bytes, len, arm};
+            }
+        }
+    }
+    *arms_out = arms;
+    return count;
+}
+
+// Set _k_<id> to the arm of the one pattern in `arms` (all of one length) that
+// _m_<id> can still equal: switch on the byte that tells most of them apart,
+// down to a single candidate, then compare the whole string.
+static void emit_string_dispatch_group(StringArm **arms, int n, int id, FILE *out)
+{
+    if (n == 1)
+    {
+        if (arms[0]->len == 0)
+        {
+            fprintf(out, "_k_%d = %d; ", id, arms[0]->arm);
+        }
+        else
+        {
+            fprintf(out, "if (memcmp(_m_%d, %s, %d) == 0) { _k_%d = %d; } ", id,
+                    arms[0]->literal, arms[0]->len, id, arms[0]->arm);
+        }
+        return;
+    }
+
+    int best = 0;
+    int best_distinct = 0;
+    for (int pos = 0; pos < arms[0]->len; pos++)
+    {
+        char seen[256] = {0};
+        int distinct = 0;
+        for (int i = 0; i < n; i++)
+        {
+            unsigned char b = (unsigned char)arms[i]->bytes[pos];
+            distinct += !seen[b];
+            seen[b] = 1;
+        }
+        if (distinct > best_distinct)
+        {
+            best = pos;
+            best_distinct = distinct;
+        }
+    }
+
+    StringArm **group = xmalloc(sizeof(StringArm *) * n);
+    char done[256] = {0};
+    fprintf(out, "switch ((unsigned char)_m_%d[%d]) { ", id, best);
+    for (int i = 0; i < n; i++)
+    {
+        unsigned char b = (unsigned char)arms[i]->bytes[best];
+        if (done[b])
+        {
+            continue;
+        }
+        done[b] = 1;
+        int g = 0;
+        for (int j = i; j < n; j++)
+        {
+            if ((unsigned char)arms[j]->bytes[best] == b)
+            {
+                group[g++] = arms[j];
+            }
+        }
+        fprintf(out, "case %d: ", b);
+        emit_string_dispatch_group(group, g, id, out);
+        fprintf(out, "break; ");
+    }
+    fprintf(out, "} ");
+    free(group);
+}
+
+// Emit `int _k_<id>`: the arm whose string pattern _m_<id> equals, or -1.
+static void emit_string_dispatch(StringArm *arms, int count, int id, FILE *out)
+{
+    StringArm **group = xmalloc(sizeof(StringArm *) * count);
+    char *done = xcalloc(count, 1);
+    fprintf(out, "int _k_%d = -1; switch (strlen(_m_%d)) { ", id, id);
+    for (int i = 0; i < count; i++)
+    {
+        if (done[i])
+        {
+            continue;
+        }
+        int g = 0;
+        for (int j = i; j < count; j++)
+        {
+            if (arms[j].len == arms[i].len)
+            {
+                group[g++] = &arms[j];
+                done[j] = 1;
+            }
+        }
+        fprintf(out, "case %d: ", arms[i].len);
+        emit_string_dispatch_group(group, g, id, out);
+        fprintf(out, "break; ");
+    }
+    fprintf(out, "} ");
+    free(done);
+    free(group);
+}
+
+#define SWITCH_DISPATCH_MIN 3 ///< Case labels from which a match becomes a C switch.
+
+/**
+ * @brief Values `lo` to `hi` of a match on an integer or enum tag, taken by `arm`.
+ */
+typedef struct
+{
+    long long lo;
+    long long hi;
+    int arm;
+} CaseRange;
+
+// Parse a non-negative integer or ASCII char literal at `*p`, advancing past
+// it. Char literals above 127 are left to the comparison chain, as their
+// value depends on the signedness of char.
+static int parse_case_value(const char **p, long long *value)
+{
+    const char *s = *p;
+    if (*s == '\'')
+    {
+        const char *end = strchr(s + 1, '\'');
+        if (!end)
+        {
+            return 0;
+        }
+        if (s[1] == '\\')
+        {
+            s += 2;
+            int c = decode_escape(&s, s + strlen(s));
+            if (c < 0 || c > 127 || *s != '\'')
+            {
+                return 0;
+            }
+            *value = c;
+        }
+        else if (end == s + 2 && (unsigned char)s[1] < 0x80)
+        {
+            *value = s[1];
+            s = end;
+        }
+        else
+        {
+            return 0; // Multi-byte rune or malformed.
+        }
+        *p = s + 1;
+        return 1;
+    }
+
+    if (!isdigit((unsigned char)*s))
+    {
+        return 0;
+    }
+    int base = 10;
+    if (s[0] == '0' && (s[1] == 'x' || s[1] == 'X'))
+    {
+        base = 16;
+        s += 2;
+    }
+    else if (s[0] == '0' && (s[1] == 'b' || s[1] == 'B'))
+    {
+        base = 2;
+        s += 2;
+    }
+    else if (s[0] == '0' && (s[1] == 'o' || s[1] == 'O'))
+    {
+        base = 8;
+        s += 2;
+    }
+    else if (s[0] == '0')
+    {
+        base = 8; // As in C, which the comparison chain emits the literal to.
+    }
+    unsigned long long v = 0;
+    int digits = 0;
+    for (;; s++)
+    {
+        int d = hex_digit(*s);
+        if (*s == '_' && digits)
+        {
+            continue;
+        }
+        if (d < 0 || d >= base)
+        {
+            break;
+        }
+        if (v > (unsigned long long)(LLONG_MAX - d) / base)
+        {
+            return 0;
+        }
+        v = v * base + d;
+        digits++;
+    }
+    if (!digits || isalnum((unsigned char)*s) || *s == '_' || (*s == '.' && s[1] != '.'))
+    {
+        return 0; // Suffix, float, or a digit of another base.
+    }
+    *value = (long long)v;
+    *p = s;
+    return 1;
+}
+
+// Parse one alternative of an integer pattern: a value or a range.
+static int parse_case_range(const char *alt, long long *lo, long long *hi)
+{
+    const char *p = alt;
+    if (!parse_case_value(&p, lo))
+    {
+        return 0;
+    }
+    if (*p == 0)
+    {
+        *hi = *lo;
+        return 1;
+    }
+    int inclusive = strncmp(p, "..=", 3) == 0;
+    if (strncmp(p, "..", 2) != 0)
+    {
+        return 0;
+    }
+    p += inclusive ? 3 : 2;
+    if (!parse_case_value(&p, hi) || *p != 0)
+    {
+        return 0;
+    }
+    if (!inclusive)
+    {
+        (*hi)--; // Values are not negative, so this cannot overflow.
+    }
+    return 1;
+}
+
+// Collect the case ranges of a match on enum tags (`enum_tags`) or integers.
+// Returns their count, or -1 if an arm has another kind of pattern, a guard,
+// or a range that overlaps an earlier one in part. `*default_arm` is the
+// first wildcard arm, or -1.
+static int collect_case_ranges(ParserContext *ctx, ASTNode *cases, int enum_tags,
+                               CaseRange **ranges_out, int *default_arm)
+{
+    CaseRange *ranges = NULL;
+    int count = 0;
+    int arm = 0;
+    *default_arm = -1;
+    for (ASTNode *c = cases; c; c = c->next, arm++)
+    {
+        const char *p = c->match_case.pattern;
+        if (strcmp(p, "_") == 0)
+        {
+            *default_arm = arm;
+            break; // Later arms are never taken.
+        }
+        if (c->match_case.guard)
+        {
+            return -1;
+        }
+        while (*p)
+        {
+            char *alt = next_alternative(&p);
+            long long lo;
+            long long hi;
+            if (enum_tags)
+            {
+                EnumVariantReg *reg = find_enum_variant(ctx, alt);
+                if (!reg)
+                {
+                    return -1;
+                }
+                lo = hi = reg->tag_id;
+            }
+            else if (!parse_case_range(alt, &lo, &hi))
+            {
+                return -1;
+            }
+            free(alt);
+            if (hi < lo)
+            {
+                continue; // Empty range.
+            }
+
+            // The first arm wins; C rejects duplicate case values.
+            int covered = 0;
+            for (int i = 0; i < count && !covered; i++)
+            {
+                if (lo > ranges[i].hi || hi < ranges[i].lo)
+                {
+                    continue;
+                }
+                if (lo < ranges[i].lo || hi > ranges[i].hi)
+                {
+                    return -1;
+                }
+                covered = 1;
+            }
+            if (!covered)
+            {
+                ranges = xrealloc(ranges, sizeof(CaseRange) * (count + 1));
+                ranges[count++] = (CaseRange){lo, hi, arm};
+            }
+        }
+    }
+    *ranges_out = ranges;
+    return count;
+}
+
 // Helper
 static bool is_int_type(TypeKind k)
 {
@@ -190,6 +682,239 @@ static bool is_int_type(TypeKind k)
     }
 }
 
+// Emit the bindings and body of match arm `c` (the scrutinee is _m_<id>).
+static void emit_match_arm(ParserContext *ctx, ASTNode *c, int id, int is_option, int is_result,
+                           int has_ref_binding, int is_expr, FILE *out)
+{
+    if (c->match_case.binding_count > 0)
+    {
+        for (int i = 0; i < c->match_case.binding_count; i++)
+        {
+            char *bname = c->match_case.binding_names[i];
+            int is_r = c->match_case.binding_refs ? c->match_case.binding_refs[i] : 0;
+
+            if (is_option)
+            {
+                if (is_r)
+                {
+                    fprintf(out, "ZC_AUTO_INIT(%s, &_m_%d->val); ", bname, id);
+                }
+                else if (has_ref_binding)
+                {
+                    fprintf(out, "ZC_AUTO_INIT(%s, _m_%d->val); ", bname, id);
+                }
+                else
+                {
+                    fprintf(out, "ZC_AUTO_INIT(%s, _m_%d.val); ", bname, id);
+                }
+            }
+            else if (is_result)
+            {
+                char *field = "val";
+                if (strcmp(c->match_case.pattern, "Err") == 0)
+                {
+                    field = "err";
+                }
+
+                if (is_r)
+                {
+                    fprintf(out, "ZC_AUTO_INIT(%s, &_m_%d->%s); ", bname, id, field);
+                }
+                else if (has_ref_binding)
+                {
+                    fprintf(out, "ZC_AUTO_INIT(%s, _m_%d->%s); ", bname, id, field);
+                }
+                else
+                {
+                    fprintf(out, "ZC_AUTO_INIT(%s, _m_%d.%s); ", bname, id, field);
+                }
+            }
+            else
+            {
+                char *v = strrchr(c->match_case.pattern, '_');
+                if (v)
+                {
+                    v++;
+                }
+                else
+                {
+                    v = c->match_case.pattern;
+                }
+
+                if (c->match_case.binding_count > 1)
+                {
+                    // Tuple destructuring: data.Variant.vI
+                    if (is_r)
+                    {
+                        fprintf(out, "ZC_AUTO_INIT(%s, &_m_%d->data.%s.v%d); ", bname, id, v, i);
+                    }
+                    else if (has_ref_binding)
+                    {
+                        fprintf(out, "ZC_AUTO_INIT(%s, _m_%d->data.%s.v%d); ", bname, id, v, i);
+                    }
+                    else
+                    {
+                        fprintf(out, "ZC_AUTO_INIT(%s, _m_%d.data.%s.v%d); ", bname, id, v, i);
+                    }
+                }
+                else
+                {
+                    // Single destructuring: data.Variant
+                    if (is_r)
+                    {
+                        fprintf(out, "ZC_AUTO_INIT(%s, &_m_%d->data.%s); ", bname, id, v);
+                    }
+                    else if (has_ref_binding)
+                    {
+                        fprintf(out, "ZC_AUTO_INIT(%s, _m_%d->data.%s); ", bname, id, v);
+                    }
+                    else
+                    {
+                        fprintf(out, "ZC_AUTO_INIT(%s, _m_%d.data.%s); ", bname, id, v);
+                    }
+                }
+            }
+        }
+    }
+
+    // Check if body is a string literal (should auto-print).
+    ASTNode *body = c->match_case.body;
+    int is_string_literal =
+        (body->type == NODE_EXPR_LITERAL && body->literal.type_kind == LITERAL_STRING);
+
+    if (is_expr)
+    {
+        fprintf(out, "_r_%d = ", id);
+        if (is_string_literal)
+        {
+            codegen_node_single(ctx, body, out);
+        }
+        else
+        {
+            if (body->type == NODE_BLOCK)
+            {
+                int saved = defer_count;
+                fprintf(out, "({ ");
+                ASTNode *stmt = body->block.statements;
+                while (stmt)
+                {
+                    codegen_node_single(ctx, stmt, out);
+                    stmt = stmt->next;
+                }
+                for (int i = defer_count - 1; i >= saved; i--)
+                {
+                    codegen_node_single(ctx, defer_stack[i], out);
+                }
+                defer_count = saved;
+                fprintf(out, " })");
+            }
+            else
+            {
+                codegen_node_single(ctx, body, out);
+            }
+        }
+        fprintf(out, ";");
+    }
+    else
+    {
+        if (is_string_literal)
+        {
+            char *inner = body->literal.string_val;
+            char *code = process_printf_sugar(ctx, inner, 1, "stdout", NULL, NULL, 0);
+            fprintf(out, "%s;", code);
+            free(code);
+        }
+        else
+        {
+            codegen_node_single(ctx, body, out);
+        }
+    }
+}
+
+// 1 if the scrutinee of a match is known to be an integer (a valid C switch operand).
+static int is_int_scrutinee(ParserContext *ctx, ASTNode *expr)
+{
+    Type *t = expr->type_info;
+    if (!t && expr->type == NODE_EXPR_VAR)
+    {
+        t = find_symbol_type_info(ctx, expr->var_ref.name);
+    }
+    return is_integer_type(t);
+}
+
+// 1 if some case of the switch (or its default) jumps to `arm`.
+static int switch_arm_taken(CaseRange *ranges, int count, int default_arm, int arm)
+{
+    if (arm == default_arm)
+    {
+        return 1;
+    }
+    for (int i = 0; i < count; i++)
+    {
+        if (ranges[i].arm == arm)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Emit a match as `switch (subject)` jumping to the arms, which follow as
+// labelled blocks: a break inside an arm still leaves the enclosing loop.
+// Ranges are GNU case ranges, like the statement expressions around them.
+// The labels are GNU local labels, so the block can be emitted more than
+// once in a function (the f-string macros expand their arguments twice).
+static void emit_match_switch(ParserContext *ctx, ASTNode *node, const char *subject,
+                              CaseRange *ranges, int count, int default_arm, int id,
+                              int is_option, int is_result, int has_ref_binding, int is_expr,
+                              FILE *out)
+{
+    fprintf(out, "{ __label__ _e_%d", id);
+    int arm = 0;
+    for (ASTNode *c = node->match_stmt.cases; c; c = c->next, arm++)
+    {
+        if (switch_arm_taken(ranges, count, default_arm, arm))
+        {
+            fprintf(out, ", _a_%d_%d", id, arm);
+        }
+    }
+    fprintf(out, "; switch (%s) { ", subject);
+    for (int i = 0; i < count; i++)
+    {
+        if (ranges[i].lo == ranges[i].hi)
+        {
+            fprintf(out, "case %lld: ", ranges[i].lo);
+        }
+        else
+        {
+            fprintf(out, "case %lld ... %lld: ", ranges[i].lo, ranges[i].hi);
+        }
+        fprintf(out, "goto _a_%d_%d; ", id, ranges[i].arm);
+    }
+    if (default_arm >= 0)
+    {
+        fprintf(out, "default: goto _a_%d_%d; ", id, default_arm);
+    }
+    else
+    {
+        fprintf(out, "default: goto _e_%d; ", id);
+    }
+    fprintf(out, "} ");
+
+    arm = 0;
+    for (ASTNode *c = node->match_stmt.cases; c; c = c->next, arm++)
+    {
+        if (!switch_arm_taken(ranges, count, default_arm, arm))
+        {
+            continue; // Never reached, and an unused label would warn.
+        }
+        fprintf(out, "_a_%d_%d: { ", id, arm);
+        emit_match_arm(ctx, c, id, is_option, is_result, has_ref_binding, is_expr, out);
+        fprintf(out, " } goto _e_%d; ", id);
+    }
+    fprintf(out, "_e_%d: ; }", id);
+}
+
 void codegen_match_internal(ParserContext *ctx, ASTNode *node, FILE *out, int use_result)
 {
     int id = tmp_counter++;
@@ -270,6 +995,18 @@ void codegen_match_internal(ParserContext *ctx, ASTNode *node, FILE *out, int us
     int is_option = (expr_type && strncmp(expr_type, "Option_", 7) == 0);
     int is_result = (expr_type && strncmp(expr_type, "Result_", 7) == 0);
 
+    // Many string arms: find the arm with one switch on the length and the
+    // bytes that tell the patterns apart, instead of a strcmp per pattern.
+    StringArm *string_arms = NULL;
+    int string_count = (is_option || is_result || has_ref_binding)
+                           ? 0
+                           : collect_string_arms(node->match_stmt.cases, &string_arms);
+    int string_dispatch = string_count >= STRING_DISPATCH_MIN;
+    if (string_dispatch)
+    {
+        emit_string_dispatch(string_arms, string_count, id, out);
+    }
+
     char *enum_name = NULL;
     ASTNode *chk = node->match_stmt.cases;
     int has_wildcard = 0;
@@ -296,7 +1033,7 @@ void codegen_match_internal(ParserContext *ctx, ASTNode *node, FILE *out, int us
         EnumVariantReg *v = ctx->enum_variants;
         while (v)
         {
-            if (strcmp(v->enum_name, enum_name) == 0)
+            if (v->enum_name == enum_name)
             {
                 int covered = 0;
                 ASTNode *c2 = node->match_stmt.cases;
@@ -319,8 +1056,44 @@ void codegen_match_internal(ParserContext *ctx, ASTNode *node, FILE *out, int us
         }
     }
 
+    // Matches on integers or enum tags become a C switch, which the C
+    // compiler can lower to a jump table or a binary search.
+    CaseRange *ranges = NULL;
+    int default_arm = -1;
+    int range_count = -1;
+    if (!string_dispatch && !is_option && !is_result &&
+        (enum_name || is_int_scrutinee(ctx, node->match_stmt.expr)))
+    {
+        range_count = collect_case_ranges(ctx, node->match_stmt.cases, enum_name != NULL,
+                                          &ranges, &default_arm);
+    }
+    if (range_count >= SWITCH_DISPATCH_MIN)
+    {
+        char subject[64];
+        if (enum_name)
+        {
+            snprintf(subject, sizeof(subject), has_ref_binding ? "_m_%d->tag" : "_m_%d.tag", id);
+        }
+        else
+        {
+            snprintf(subject, sizeof(subject), has_ref_binding ? "*_m_%d" : "_m_%d", id);
+        }
+        emit_match_switch(ctx, node, subject, ranges, range_count, default_arm, id, is_option,
+                          is_result, has_ref_binding, is_expr, out);
+        if (is_expr)
+        {
+            fprintf(out, " _r_%d; })", id);
+        }
+        else
+        {
+            fprintf(out, " })");
+        }
+        return;
+    }
+
     ASTNode *c = node->match_stmt.cases;
     int first = 1;
+    int arm = 0;
     while (c)
     {
         if (!first)
@@ -362,159 +1135,20 @@ void codegen_match_internal(ParserContext *ctx, ASTNode *node, FILE *out, int us
                 fprintf(out, "1");
             }
         }
+        else if (string_dispatch)
+        {
+            fprintf(out, "_k_%d == %d", id, arm);
+        }
         else
         {
             // Use helper for OR patterns, range patterns, and simple patterns
             emit_pattern_condition(ctx, c->match_case.pattern, id, has_ref_binding, out);
         }
         fprintf(out, ") { ");
-        if (c->match_case.binding_count > 0)
-        {
-            for (int i = 0; i < c->match_case.binding_count; i++)
-            {
-                char *bname = c->match_case.binding_names[i];
-                int is_r = c->match_case.binding_refs ? c->match_case.binding_refs[i] : 0;
-
-                if (is_option)
-                {
-                    if (is_r)
-                    {
-                        fprintf(out, "ZC_AUTO_INIT(%s, &_m_%d->val); ", bname, id);
-                    }
-                    else if (has_ref_binding)
-                    {
-                        fprintf(out, "ZC_AUTO_INIT(%s, _m_%d->val); ", bname, id);
-                    }
-                    else
-                    {
-                        fprintf(out, "ZC_AUTO_INIT(%s, _m_%d.val); ", bname, id);
-                    }
-                }
-                else if (is_result)
-                {
-                    char *field = "val";
-                    if (strcmp(c->match_case.pattern, "Err") == 0)
-                    {
-                        field = "err";
-                    }
-
-                    if (is_r)
-                    {
-                        fprintf(out, "ZC_AUTO_INIT(%s, &_m_%d->%s); ", bname, id, field);
-                    }
-                    else if (has_ref_binding)
-                    {
-                        fprintf(out, "ZC_AUTO_INIT(%s, _m_%d->%s); ", bname, id, field);
-                    }
-                    else
-                    {
-                        fprintf(out, "ZC_AUTO_INIT(%s, _m_%d.%s); ", bname, id, field);
-                    }
-                }
-                else
-                {
-                    char *v = strrchr(c->match_case.pattern, '_');
-                    if (v)
-                    {
-                        v++;
-                    }
-                    else
-                    {
-                        v = c->match_case.pattern;
-                    }
-
-                    if (c->match_case.binding_count > 1)
-                    {
-                        // Tuple destructuring: data.Variant.vI
-                        if (is_r)
-                        {
-                            fprintf(out, "ZC_AUTO_INIT(%s, &_m_%d->data.%s.v%d); ", bname, id, v,
-                                    i);
-                        }
-                        else if (has_ref_binding)
-                        {
-                            fprintf(out, "ZC_AUTO_INIT(%s, _m_%d->data.%s.v%d); ", bname, id, v, i);
-                        }
-                        else
-                        {
-                            fprintf(out, "ZC_AUTO_INIT(%s, _m_%d.data.%s.v%d); ", bname, id, v, i);
-                        }
-                    }
-                    else
-                    {
-                        // Single destructuring: data.Variant
-                        if (is_r)
-                        {
-                            fprintf(out, "ZC_AUTO_INIT(%s, &_m_%d->data.%s); ", bname, id, v);
-                        }
-                        else if (has_ref_binding)
-                        {
-                            fprintf(out, "ZC_AUTO_INIT(%s, _m_%d->data.%s); ", bname, id, v);
-                        }
-                        else
-                        {
-                            fprintf(out, "ZC_AUTO_INIT(%s, _m_%d.data.%s); ", bname, id, v);
-                        }
-                    }
-                }
-            }
-        }
-
-        // Check if body is a string literal (should auto-print).
-        ASTNode *body = c->match_case.body;
-        int is_string_literal =
-            (body->type == NODE_EXPR_LITERAL && body->literal.type_kind == LITERAL_STRING);
-
-        if (is_expr)
-        {
-            fprintf(out, "_r_%d = ", id);
-            if (is_string_literal)
-            {
-                codegen_node_single(ctx, body, out);
-            }
-            else
-            {
-                if (body->type == NODE_BLOCK)
-                {
-                    int saved = defer_count;
-                    fprintf(out, "({ ");
-                    ASTNode *stmt = body->block.statements;
-                    while (stmt)
-                    {
-                        codegen_node_single(ctx, stmt, out);
-                        stmt = stmt->next;
-                    }
-                    for (int i = defer_count - 1; i >= saved; i--)
-                    {
-                        codegen_node_single(ctx, defer_stack[i], out);
-                    }
-                    defer_count = saved;
-                    fprintf(out, " })");
-                }
-                else
-                {
-                    codegen_node_single(ctx, body, out);
-                }
-            }
-            fprintf(out, ";");
-        }
-        else
-        {
-            if (is_string_literal)
-            {
-                char *inner = body->literal.string_val;
-                char *code = process_printf_sugar(ctx, inner, 1, "stdout", NULL, NULL, 0);
-                fprintf(out, "%s;", code);
-                free(code);
-            }
-            else
-            {
-                codegen_node_single(ctx, body, out);
-            }
-        }
-
+        emit_match_arm(ctx, c, id, is_option, is_result, has_ref_binding, is_expr, out);
         fprintf(out, " }");
         first = 0;
+        arm++;
         c = c->next;
     }
 
@@ -115,6 +115,39 @@ void emit_var_decl_type(ParserContext *ctx, FILE *out, const char *type_str, con
     emit_c_decl(ctx, out, type_str, var_name);
 }
 
+// Name indexes over global_user_structs. As with a scan of the list, the first
+// matching node wins.
+static InternMap global_struct_index; // First complete NODE_STRUCT per name.
+static InternMap global_alias_index;  // First NODE_TYPE_ALIAS per alias.
+
+void index_global_user_structs(void)
+{
+    memset(&global_struct_index, 0, sizeof(global_struct_index));
+    memset(&global_alias_index, 0, sizeof(global_alias_index));
+    for (ASTNode *s = global_user_structs; s; s = s->next)
+    {
+        void **slot = NULL;
+        if (s->type == NODE_STRUCT && s->strct.name && !s->strct.is_incomplete)
+        {
+            slot = intern_map_slot(&global_struct_index, intern(s->strct.name));
+        }
+        else if (s->type == NODE_TYPE_ALIAS && s->type_alias.alias)
+        {
+            slot = intern_map_slot(&global_alias_index, intern(s->type_alias.alias));
+        }
+        if (slot && !*slot)
+        {
+            *slot = s;
+        }
+    }
+}
+
+const char *find_global_alias(const char *name)
+{
+    ASTNode *a = intern_map_get(&global_alias_index, name);
+    return a ? a->type_alias.original_type : NULL;
+}
+
 // Find struct definition
 ASTNode *find_struct_def_codegen(ParserContext *ctx, const char *name)
 {
@@ -122,37 +155,50 @@ ASTNode *find_struct_def_codegen(ParserContext *ctx, const char *name)
     {
         return NULL;
     }
-    ASTNode *s = global_user_structs;
-    while (s)
+    ASTNode *s = intern_map_get(&global_struct_index, name);
+    if (s)
     {
-        if (s->type == NODE_STRUCT && strcmp(s->strct.name, name) == 0 && !s->strct.is_incomplete)
-        {
-            return s;
-        }
-        s = s->next;
+        return s;
     }
 
-    // Check parsed structs list (imports)-
-    StructRef *sr = ctx->parsed_structs_list;
-    while (sr)
+    // Check parsed structs list (imports). The index holds the newest node of
+    // that name; only an incomplete one needs the older entries.
+    s = intern_map_get(&ctx->parsed_struct_index, name);
+    if (s && (s->type != NODE_STRUCT || s->strct.is_incomplete))
     {
-        if (sr->node && sr->node->type == NODE_STRUCT && strcmp(sr->node->strct.name, name) == 0 &&
-            !sr->node->strct.is_incomplete)
+        s = NULL;
+        StructRef *sr = ctx->parsed_structs_list;
+        while (sr && !s)
         {
-            return sr->node;
+            if (sr->node && sr->node->type == NODE_STRUCT &&
+                strcmp(sr->node->strct.name, name) == 0 && !sr->node->strct.is_incomplete)
+            {
+                s = sr->node;
+            }
+            sr = sr->next;
         }
-        sr = sr->next;
     }
-    s = ctx->instantiated_structs;
-    while (s)
+    if (s)
     {
-        if (s->type == NODE_STRUCT && strcmp(s->strct.name, name) == 0 && !s->strct.is_incomplete)
+        return s;
+    }
+
+    s = intern_map_get(&ctx->instantiated_struct_index, name);
+    if (s && s->strct.is_incomplete)
+    {
+        s = NULL;
+        ASTNode *i = ctx->instantiated_structs;
+        while (i && !s)
         {
-            return s;
+            if (i->type == NODE_STRUCT && strcmp(i->strct.name, name) == 0 &&
+                !i->strct.is_incomplete)
+            {
+                s = i;
+            }
+            i = i->next;
         }
-        s = s->next;
     }
-    return NULL;
+    return s;
 }
 
 // Get field type from struct.
@@ -1,5 +1,6 @@
 
 #include "zprep.h"
+#include <limits.h>
 
 void lexer_init(Lexer *l, const char *src)
 {
@@ -8,37 +9,324 @@ void lexer_init(Lexer *l, const char *src)
     l->line = 1;
     l->col = 1;
     l->emit_comments = 0;
+    l->buf = NULL;
+    l->cursor = 0;
+    l->split = 0;
 }
 
+// ** Character Classes **
+
+#define CC_SPACE 1 ///< ' ', \t, \n, \v, \f, \r (isspace in the C locale).
+#define CC_DIGIT 2 ///< 0-9.
+#define CC_ALPHA 4 ///< a-z, A-Z and '_'.
+
+#define S CC_SPACE
+#define D CC_DIGIT
+#define A CC_ALPHA
+static const unsigned char char_class[256] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, S, S, S, S, S, 0, 0, // 0x00
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, // 0x10
+    S, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, // 0x20
+    D, D, D, D, D, D, D, D, D, D, 0, 0, 0, 0, 0, 0, // 0x30
+    0, A, A, A, A, A, A, A, A, A, A, A, A, A, A, A, // 0x40
+    A, A, A, A, A, A, A, A, A, A, A, 0, 0, 0, 0, A, // 0x50
+    0, A, A, A, A, A, A, A, A, A, A, A, A, A, A, A, // 0x60
+    A, A, A, A, A, A, A, A, A, A, A, 0, 0, 0, 0, 0, // 0x70
+};
+#undef S
+#undef D
+#undef A
+
 static int is_ident_start(char c)
 {
-    return isalpha(c) || c == '_';
+    return char_class[(unsigned char)c] & CC_ALPHA;
 }
 
 static int is_ident_char(char c)
 {
-    return isalnum(c) || c == '_';
+    return char_class[(unsigned char)c] & (CC_ALPHA | CC_DIGIT);
 }
 
-Token lexer_next(Lexer *l)
+static int is_digit(char c)
 {
-    const char *s = l->src + l->pos;
-    int start_line = l->line;
-    int start_col = l->col;
+    return char_class[(unsigned char)c] & CC_DIGIT;
+}
+
+// ** Keywords **
+
+typedef struct
+{
+    const char *name;
+    int len;
+    ZenTokenType type;
+} Keyword;
+
+// Indexed by a perfect hash over (length, first byte, last byte); see
+// keyword_type. A new keyword must land on a free slot.
+static const Keyword keywords[32] = {
+    [0] = {"defer", 5, TOK_DEFER},
+    [1] = {"comptime", 8, TOK_COMPTIME},
+    [4] = {"and", 3, TOK_AND},
+    [6] = {"union", 5, TOK_UNION},
+    [7] = {"volatile", 8, TOK_VOLATILE},
+    [8] = {"def", 3, TOK_DEF},
+    [9] = {"alias", 5, TOK_ALIAS},
+    [11] = {"asm", 3, TOK_ASM},
+    [12] = {"sizeof", 6, TOK_SIZEOF},
+    [14] = {"impl", 4, TOK_IMPL},
+    [16] = {"or", 2, TOK_OR},
+    [21] = {"opaque", 6, TOK_OPAQUE},
+    [24] = {"await", 5, TOK_AWAIT},
+    [25] = {"async", 5, TOK_ASYNC},
+    [26] = {"assert", 6, TOK_ASSERT},
+    [27] = {"use", 3, TOK_USE},
+    [28] = {"test", 4, TOK_TEST},
+    [29] = {"autofree", 8, TOK_AUTOFREE},
+    [30] = {"trait", 5, TOK_TRAIT},
+};
+
+// Keyword token type of an identifier, or TOK_IDENT.
+static ZenTokenType keyword_type(const char *s, int len)
+{
+    if (len < 2 || len > 8)
+    {
+        return TOK_IDENT;
+    }
+    unsigned h = (2 * (len + (unsigned char)s[0]) + 15 * (unsigned char)s[len - 1]) & 31;
+    const Keyword *k = &keywords[h];
+    if (k->len == len && memcmp(k->name, s, len) == 0)
+    {
+        return k->type;
+    }
+    return TOK_IDENT;
+}
+
+// ** Run Scanning **
+//
+// Whitespace, comment bodies and identifiers longer than a few bytes are
+// scanned a vector at a time where SSE2/AVX2 is available. Loads are aligned, so they never cross into
+// an unmapped page past the source's terminating NUL; bytes before the start
+// of the run are masked out of the first vector. Newlines are counted per
+// vector so line/column tracking does not branch on every byte.
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define LEX_VEC 32
+typedef __m256i LexVec;
+#define vec_load(p) _mm256_load_si256((const __m256i *)(p))
+#define vec_set(c) _mm256_set1_epi8((char)(c))
+#define vec_eq(a, b) _mm256_cmpeq_epi8(a, b)
+#define vec_lt(a, b) _mm256_cmpgt_epi8(b, a)
+#define vec_add(a, b) _mm256_add_epi8(a, b)
+#define vec_or(a, b) _mm256_or_si256(a, b)
+#define vec_mask(v) ((uint32_t)_mm256_movemask_epi8(v))
+#define LEX_VEC_ALL 0xFFFFFFFFu
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define LEX_VEC 16
+typedef __m128i LexVec;
+#define vec_load(p) _mm_load_si128((const __m128i *)(p))
+#define vec_set(c) _mm_set1_epi8((char)(c))
+#define vec_eq(a, b) _mm_cmpeq_epi8(a, b)
+#define vec_lt(a, b) _mm_cmplt_epi8(a, b)
+#define vec_add(a, b) _mm_add_epi8(a, b)
+#define vec_or(a, b) _mm_or_si128(a, b)
+#define vec_mask(v) ((uint32_t)_mm_movemask_epi8(v))
+#define LEX_VEC_ALL 0xFFFFu
+#endif
+
+#ifdef LEX_VEC
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+static int bit_low(uint32_t x)
+{
+    unsigned long i;
+    _BitScanForward(&i, x);
+    return (int)i;
+}
+static int bit_high(uint32_t x)
+{
+    unsigned long i;
+    _BitScanReverse(&i, x);
+    return (int)i;
+}
+#define bit_count(x) ((int)__popcnt(x))
+#else
+#define bit_low(x) __builtin_ctz(x)
+#define bit_high(x) (31 - __builtin_clz(x))
+#define bit_count(x) __builtin_popcount(x)
+#endif
+
+// Lanes holding a byte in [lo, lo + n) (unsigned range check on signed lanes).
+static LexVec vec_in_range(LexVec v, int lo, int n)
+{
+    return vec_lt(vec_add(v, vec_set(128 - lo)), vec_set(-128 + n));
+}
+#endif
+
+// Runs shorter than this are scanned byte by byte: most tokens are short and
+// vectors only pay off on indentation and comment bodies.
+#define LEX_SHORT_RUN 8
+
+#ifdef LEX_VEC
+// Kinds of runs scanned a vector at a time.
+enum
+{
+    RUN_SPACE, ///< Whitespace.
+    RUN_IDENT, ///< Identifier characters.
+    RUN_UNTIL  ///< Anything up to a given byte or NUL.
+};
+
+// Lanes that end a run.
+static uint32_t run_stop_mask(LexVec v, int kind, char until)
+{
+    switch (kind)
+    {
+    case RUN_SPACE:
+        return ~vec_mask(vec_or(vec_eq(v, vec_set(' ')), vec_in_range(v, '\t', 5))) & LEX_VEC_ALL;
+    case RUN_IDENT:
+    {
+        LexVec alpha = vec_in_range(vec_or(v, vec_set(0x20)), 'a', 26);
+        LexVec ident = vec_or(vec_or(alpha, vec_in_range(v, '0', 10)), vec_eq(v, vec_set('_')));
+        return ~vec_mask(ident) & LEX_VEC_ALL;
+    }
+    default:
+        return vec_mask(vec_or(vec_eq(v, vec_set(until)), vec_eq(v, vec_set(0))));
+    }
+}
 
-    while (isspace(*s))
+// Continue a run of `kind` at s + len, `nl` newlines (the last at `last`)
+// already seen. Returns the total run length.
+static int scan_run_vec(const char *s, int len, int kind, char until, int nl, int last,
+                        int *newlines, int *last_nl)
+{
+    const char *start = s + len;
+    const char *p = (const char *)((uintptr_t)start & ~(uintptr_t)(LEX_VEC - 1));
+    uint32_t lead = (1u << (start - p)) - 1;
+    while (1)
     {
-        if (*s == '\n')
+        LexVec v = vec_load(p);
+        uint32_t stop = run_stop_mask(v, kind, until) & ~lead;
+        uint32_t nls = vec_mask(vec_eq(v, vec_set('\n'))) & ~lead;
+        if (stop)
         {
-            l->line++;
-            l->col = 1;
+            nls &= (1u << bit_low(stop)) - 1;
         }
-        else
+        if (nls)
         {
-            l->col++;
+            nl += bit_count(nls);
+            last = (int)(p - s) + bit_high(nls);
         }
-        l->pos++;
-        s++;
+        if (stop)
+        {
+            *newlines = nl;
+            *last_nl = last;
+            return (int)(p - s) + bit_low(stop);
+        }
+        p += LEX_VEC;
+        lead = 0;
+    }
+}
+#endif
+
+// Length of the whitespace run at `s`. The number of newlines in it goes to
+// *newlines and the offset of the last one to *last_nl (-1 if none).
+static int scan_space(const char *s, int *newlines, int *last_nl)
+{
+    int len = 0;
+    int nl = 0;
+    int last = -1;
+    for (; char_class[(unsigned char)s[len]] & CC_SPACE; len++)
+    {
+#ifdef LEX_VEC
+        if (len == LEX_SHORT_RUN)
+        {
+            return scan_run_vec(s, len, RUN_SPACE, 0, nl, last, newlines, last_nl);
+        }
+#endif
+        if (s[len] == '\n')
+        {
+            nl++;
+            last = len;
+        }
+    }
+    *newlines = nl;
+    *last_nl = last;
+    return len;
+}
+
+// Length of the identifier at `s`.
+static int scan_ident(const char *s)
+{
+    int len = 0;
+    for (; is_ident_char(s[len]); len++)
+    {
+#ifdef LEX_VEC
+        if (len == LEX_SHORT_RUN)
+        {
+            int nl, last;
+            return scan_run_vec(s, len, RUN_IDENT, 0, 0, -1, &nl, &last);
+        }
+#endif
+    }
+    return len;
+}
+
+// Length of the text at `s` up to (not including) `until` or the end of the
+// source, with newlines reported as in scan_space.
+static int scan_until(const char *s, char until, int *newlines, int *last_nl)
+{
+    int len = 0;
+    int nl = 0;
+    int last = -1;
+    for (; s[len] && s[len] != until; len++)
+    {
+#ifdef LEX_VEC
+        if (len == LEX_SHORT_RUN)
+        {
+            return scan_run_vec(s, len, RUN_UNTIL, until, nl, last, newlines, last_nl);
+        }
+#endif
+        if (s[len] == '\n')
+        {
+            nl++;
+            last = len;
+        }
+    }
+    *newlines = nl;
+    *last_nl = last;
+    return len;
+}
+
+// Advance the lexer over `len` bytes containing `newlines` newlines, the last
+// one at offset `last_nl`.
+static void advance_run(Lexer *l, int len, int newlines, int last_nl)
+{
+    l->pos += len;
+    if (newlines)
+    {
+        l->line += newlines;
+        l->col = len - last_nl;
+    }
+    else
+    {
+        l->col += len;
+    }
+}
+
+// Scans one token directly from the source, starting at the lexer's state.
+static Token scan_token(Lexer *l)
+{
+    const char *s = l->src + l->pos;
+    int start_line = l->line;
+    int start_col = l->col;
+
+    int newlines, last_nl;
+    if (char_class[(unsigned char)*s] & CC_SPACE)
+    {
+        int len = scan_space(s, &newlines, &last_nl);
+        advance_run(l, len, newlines, last_nl);
+        s += len;
         start_line = l->line;
         start_col = l->col;
     }
@@ -46,7 +334,7 @@ Token lexer_next(Lexer *l)
     // Check for EOF.
     if (!*s)
     {
-        return (Token){TOK_EOF, s, 0, start_line, start_col};
+        return (Token){TOK_EOF, 0, s, start_line, start_col, NULL};
     }
 
     // C preprocessor directives.
@@ -67,159 +355,76 @@ Token lexer_next(Lexer *l)
         }
         l->pos += len;
 
-        return (Token){TOK_PREPROC, s, len, start_line, start_col};
+        return (Token){TOK_PREPROC, len, s, start_line, start_col, NULL};
     }
 
     // Comments.
     if (s[0] == '/' && s[1] == '/')
     {
-        int len = 2;
-        while (s[len] && s[len] != '\n')
-        {
-            len++;
-        }
+        int len = 2 + scan_until(s + 2, '\n', &newlines, &last_nl);
 
         if (l->emit_comments)
         {
             l->pos += len;
             l->col += len;
-            return (Token){TOK_COMMENT, s, len, start_line, start_col};
+            return (Token){TOK_COMMENT, len, s, start_line, start_col, NULL};
         }
 
         l->pos += len;
         l->col += len;
-        return lexer_next(l);
+        return scan_token(l);
     }
 
     // Block Comments.
     if (s[0] == '/' && s[1] == '*')
     {
         const char *comment_start = s;
-        // skip two start chars
+        // skip two start chars (the column is not advanced over "/*" or "*/")
         l->pos += 2;
         s += 2;
 
-        while (s[0])
+        while (1)
         {
-            // s[len+1] can be at most the null terminator
-            if (s[0] == '*' && s[1] == '/')
+            int len = scan_until(s, '*', &newlines, &last_nl);
+            advance_run(l, len, newlines, last_nl);
+            s += len;
+            if (!s[0])
+            {
+                break;
+            }
+            if (s[1] == '/')
             {
                 // go over */
                 l->pos += 2;
                 s += 2;
                 break;
             }
-
-            if (s[0] == '\n')
-            {
-                l->line++;
-                l->col = 1;
-            }
-            else
-            {
-                l->col++;
-            }
-
             l->pos++;
+            l->col++;
             s++;
         }
 
         if (l->emit_comments)
         {
             size_t len = s - comment_start;
-            return (Token){TOK_COMMENT, comment_start, len, start_line, start_col};
+            return (Token){TOK_COMMENT, len, comment_start, start_line, start_col, NULL};
         }
 
-        return lexer_next(l);
+        return scan_token(l);
     }
 
     // Identifiers.
     if (is_ident_start(*s))
     {
-        int len = 0;
-        while (is_ident_char(s[len]))
-        {
-            len++;
-        }
+        int len = scan_ident(s);
 
         l->pos += len;
         l->col += len;
 
-        if (len == 4 && strncmp(s, "test", 4) == 0)
-        {
-            return (Token){TOK_TEST, s, 4, start_line, start_col};
-        }
-        if (len == 6 && strncmp(s, "assert", 6) == 0)
+        ZenTokenType kw = keyword_type(s, len);
+        if (kw != TOK_IDENT)
         {
-            return (Token){TOK_ASSERT, s, 6, start_line, start_col};
-        }
-        if (len == 6 && strncmp(s, "sizeof", 6) == 0)
-        {
-            return (Token){TOK_SIZEOF, s, 6, start_line, start_col};
-        }
-        if (len == 5 && strncmp(s, "defer", 5) == 0)
-        {
-            return (Token){TOK_DEFER, s, 5, start_line, start_col};
-        }
-        if (len == 3 && strncmp(s, "def", 3) == 0)
-        {
-            return (Token){TOK_DEF, s, 3, start_line, start_col};
-        }
-        if (len == 5 && strncmp(s, "trait", 5) == 0)
-        {
-            return (Token){TOK_TRAIT, s, 5, start_line, start_col};
-        }
-        if (len == 4 && strncmp(s, "impl", 4) == 0)
-        {
-            return (Token){TOK_IMPL, s, 4, start_line, start_col};
-        }
-        if (len == 8 && strncmp(s, "autofree", 8) == 0)
-        {
-            return (Token){TOK_AUTOFREE, s, 8, start_line, start_col};
-        }
-        if (len == 5 && strncmp(s, "alias", 5) == 0)
-        {
-            return (Token){TOK_ALIAS, s, 5, start_line, start_col};
-        }
-        if (len == 3 && strncmp(s, "use", 3) == 0)
-        {
-            return (Token){TOK_USE, s, 3, start_line, start_col};
-        }
-        if (len == 8 && strncmp(s, "comptime", 8) == 0)
-        {
-            return (Token){TOK_COMPTIME, s, 8, start_line, start_col};
-        }
-        if (len == 5 && strncmp(s, "union", 5) == 0)
-        {
-            return (Token){TOK_UNION, s, 5, start_line, start_col};
-        }
-        if (len == 3 && strncmp(s, "asm", 3) == 0)
-        {
-            return (Token){TOK_ASM, s, 3, start_line, start_col};
-        }
-        if (len == 8 && strncmp(s, "volatile", 8) == 0)
-        {
-            return (Token){TOK_VOLATILE, s, 8, start_line, start_col};
-        }
-        if (len == 5 && strncmp(s, "async", 5) == 0)
-        {
-            return (Token){TOK_ASYNC, s, 5, start_line, start_col};
-        }
-        if (len == 5 && strncmp(s, "await", 5) == 0)
-        {
-            return (Token){TOK_AWAIT, s, 5, start_line, start_col};
-        }
-        if (len == 3 && strncmp(s, "and", 3) == 0)
-        {
-            return (Token){TOK_AND, s, 3, start_line, start_col};
-        }
-        if (len == 2 && strncmp(s, "or", 2) == 0)
-        {
-            return (Token){TOK_OR, s, 2, start_line, start_col};
-        }
-        if (len == 6 && strncmp(s, "opaque", 6) == 0)
-        {
-            return (Token){TOK_OPAQUE, s, 6, start_line, start_col};
+            return (Token){kw, len, s, start_line, start_col, NULL};
         }
 
         // F-Strings
@@ -238,7 +443,7 @@ Token lexer_next(Lexer *l)
         }
         else
         {
-            return (Token){TOK_IDENT, s, len, start_line, start_col};
+            return (Token){TOK_IDENT, len, s, start_line, start_col, intern_n(s, len)};
         }
     }
 
@@ -259,7 +464,7 @@ Token lexer_next(Lexer *l)
         }
         l->pos += len;
         l->col += len;
-        return (Token){TOK_FSTRING, s, len, start_line, start_col};
+        return (Token){TOK_FSTRING, len, s, start_line, start_col, NULL};
     }
 
     // Raw Strings (r"..." or r'...')
@@ -285,11 +490,11 @@ Token lexer_next(Lexer *l)
         }
         l->pos += len;
         l->col += len;
-        return (Token){TOK_RAW_STRING, s, len, start_line, start_col};
+        return (Token){TOK_RAW_STRING, len, s, start_line, start_col, NULL};
     }
 
     // Numbers
-    if (isdigit(*s))
+    if (is_digit(*s))
     {
         int len = 0;
         int is_hex = 0;
@@ -325,7 +530,7 @@ Token lexer_next(Lexer *l)
         }
         else
         {
-            while (isdigit(s[len]))
+            while (is_digit(s[len]))
             {
                 len++;
             }
@@ -340,7 +545,7 @@ Token lexer_next(Lexer *l)
                 {
                     is_float = 1;
                     len++;
-                    while (isdigit(s[len]))
+                    while (is_digit(s[len]))
                     {
                         len++;
                     }
@@ -355,7 +560,7 @@ Token lexer_next(Lexer *l)
                 {
                     len++;
                 }
-                while (isdigit(s[len]))
+                while (is_digit(s[len]))
                 {
                     len++;
                 }
@@ -372,7 +577,7 @@ Token lexer_next(Lexer *l)
                 }
                 l->pos += len;
                 l->col += len;
-                return (Token){TOK_FLOAT, s, len, start_line, start_col};
+                return (Token){TOK_FLOAT, len, s, start_line, start_col, NULL};
             }
         }
 
@@ -386,7 +591,7 @@ Token lexer_next(Lexer *l)
 
         l->pos += len;
         l->col += len;
-        return (Token){TOK_INT, s, len, start_line, start_col};
+        return (Token){TOK_INT, len, s, start_line, start_col, NULL};
     }
 
     // Strings
@@ -407,7 +612,7 @@ Token lexer_next(Lexer *l)
         }
         l->pos += len;
         l->col += len;
-        return (Token){TOK_STRING, s, len, start_line, start_col};
+        return (Token){TOK_STRING, len, s, start_line, start_col, NULL};
     }
 
     if (*s == '\'')
@@ -430,7 +635,7 @@ Token lexer_next(Lexer *l)
 
         l->pos += len;
         l->col += len;
-        return (Token){TOK_CHAR, s, len, start_line, start_col};
+        return (Token){TOK_CHAR, len, s, start_line, start_col, NULL};
     }
 
     // Operators.
@@ -565,18 +770,396 @@ Token lexer_next(Lexer *l)
 
     l->pos += len;
     l->col += len;
-    return (Token){type, s, len, start_line, start_col};
+    return (Token){type, len, s, start_line, start_col, NULL};
+}
+
+// ** Token Buffer **
+//
+// Tokens are scanned once into a buffer shared by every copy of a lexer, so
+// peeks, lookahead copies and backtracking are index arithmetic instead of
+// re-lexing. The buffer is filled on demand in growing chunks, starting from
+// the state the lexer had when it was first used. Comments are always
+// buffered and skipped at read time when `emit_comments` is off.
+//
+// A lexer is "in sync" when its (pos, line, col) is the state right before
+// buffered token `cursor`. Code that moves `pos` by hand only falls back to
+// scanning directly until the lexer lands on a token boundary again.
+
+#define TOKBUF_MIN_CHUNK 16
+#define TOKBUF_BLOCK_SHIFT 12
+#define TOKBUF_BLOCK (1 << TOKBUF_BLOCK_SHIFT)
+#define TOKBUF_MAX_LEN ((1 << 24) - 1)
+
+typedef struct
+{
+    int start;         ///< Offset of the token text in the source.
+    unsigned len : 24; ///< Length of the token text (see TOKBUF_MAX_LEN).
+    unsigned type : 8; ///< ZenTokenType.
+    int line;          ///< Line of the token.
+    int col;           ///< Column of the token.
+    int end_line;      ///< Lexer line right after the token.
+    int end_col;       ///< Lexer column right after the token.
+    InternedStr ident; ///< Interned text of a TOK_IDENT.
+} LexedToken;
+
+struct TokenBuffer
+{
+    const char *src;  ///< Source the tokens were scanned from.
+    int base_pos;     ///< Lexer position before the first token.
+    int base_line;    ///< Lexer line before the first token.
+    int base_col;     ///< Lexer column before the first token.
+    LexedToken **blocks; ///< Scanned tokens (comments included), TOKBUF_BLOCK per block.
+    int nblocks;         ///< Number of allocated blocks.
+    int count;           ///< Number of buffered tokens.
+    int cap;             ///< Token capacity; the first block grows up to TOKBUF_BLOCK.
+    int at_eof;          ///< 1 once TOK_EOF is buffered (always the last entry).
+};
+
+static LexedToken *tok_at(const struct TokenBuffer *b, int i)
+{
+    return &b->blocks[i >> TOKBUF_BLOCK_SHIFT][i & (TOKBUF_BLOCK - 1)];
+}
+
+// scan_token always leaves the lexer right after the token text, so the end
+// position is not stored. Together with the packed len/type this keeps
+// LexedToken at 32 bytes.
+static int tok_end(const LexedToken *t)
+{
+    return t->start + (int)t->len;
+}
+
+// Blocks never move once full, so a large source is not copied around while
+// its token buffer grows.
+static void tokbuf_grow(struct TokenBuffer *b)
+{
+    if (b->cap < TOKBUF_BLOCK)
+    {
+        if (!b->blocks)
+        {
+            b->blocks = xmalloc(sizeof(LexedToken *));
+            b->blocks[0] = NULL;
+            b->nblocks = 1;
+        }
+        b->cap = b->cap ? b->cap * 2 : TOKBUF_MIN_CHUNK;
+        b->blocks[0] = xrealloc(b->blocks[0], sizeof(LexedToken) * b->cap);
+        return;
+    }
+    b->blocks = xrealloc(b->blocks, sizeof(LexedToken *) * (b->nblocks + 1));
+    b->blocks[b->nblocks++] = xmalloc(sizeof(LexedToken) * TOKBUF_BLOCK);
+    b->cap += TOKBUF_BLOCK;
+}
+
+static struct TokenBuffer *tokbuf_new(const Lexer *l)
+{
+    struct TokenBuffer *b = xcalloc(1, sizeof(struct TokenBuffer));
+    b->src = l->src;
+    b->base_pos = l->pos;
+    b->base_line = l->line;
+    b->base_col = l->col;
+    return b;
+}
+
+static void tokbuf_state_before(const struct TokenBuffer *b, int i, int *pos, int *line,
+                                int *col)
+{
+    if (i == 0)
+    {
+        *pos = b->base_pos;
+        *line = b->base_line;
+        *col = b->base_col;
+        return;
+    }
+    const LexedToken *t = tok_at(b, i - 1);
+    *pos = tok_end(t);
+    *line = t->end_line;
+    *col = t->end_col;
+}
+
+// Make sure token `i` is buffered (or the buffer ends with TOK_EOF before it).
+static void tokbuf_fill(struct TokenBuffer *b, int i)
+{
+    int first = b->count;
+    double started = g_config.time_passes ? z_get_monotonic_time() : 0;
+
+    while (i >= b->count && !b->at_eof)
+    {
+        // Scan ahead in chunks that double up to a block, so small sub-lexers
+        // stay cheap and large sources are scanned in long runs.
+        int chunk = b->count < TOKBUF_MIN_CHUNK ? TOKBUF_MIN_CHUNK : b->count;
+        if (chunk > TOKBUF_BLOCK)
+        {
+            chunk = TOKBUF_BLOCK;
+        }
+
+        Lexer sc = {0};
+        sc.src = b->src;
+        sc.emit_comments = 1;
+        tokbuf_state_before(b, b->count, &sc.pos, &sc.line, &sc.col);
+
+        for (int k = 0; k < chunk && !b->at_eof; k++)
+        {
+            Token t = scan_token(&sc);
+            if (b->count == b->cap)
+            {
+                tokbuf_grow(b);
+            }
+            if (t.len > TOKBUF_MAX_LEN)
+            {
+                zfatal("Token at line %d is too long (%d bytes)", t.line, t.len);
+            }
+            LexedToken *e = tok_at(b, b->count++);
+            e->start = (int)(t.start - b->src);
+            e->len = t.len;
+            e->line = t.line;
+            e->col = t.col;
+            e->type = t.type;
+            e->end_line = sc.line;
+            e->end_col = sc.col;
+            e->ident = t.ident;
+            if (t.type == TOK_EOF)
+            {
+                b->at_eof = 1;
+            }
+        }
+    }
+
+    if (b->count > first)
+    {
+        stats_add_lex(b->count - first, started ? z_get_monotonic_time() - started : 0);
+    }
+}
+
+static int state_is(const Lexer *l, int pos, int line, int col)
+{
+    return l->pos == pos && l->line == line && l->col == col;
+}
+
+// Check that the lexer state matches its cursor, re-locating the cursor by
+// position if it was moved by hand. Returns 0 when the lexer is in the middle
+// of a token (the caller then scans directly).
+static int lexer_sync(Lexer *l)
+{
+    struct TokenBuffer *b = l->buf;
+    if (!b || b->src != l->src)
+    {
+        l->buf = tokbuf_new(l);
+        l->cursor = 0;
+        l->split = 0;
+        return 1;
+    }
+    if (l->split)
+    {
+        return 0;
+    }
+
+    int pos, line, col;
+    if (l->cursor >= 0 && l->cursor <= b->count)
+    {
+        tokbuf_state_before(b, l->cursor, &pos, &line, &col);
+        if (state_is(l, pos, line, col))
+        {
+            return 1;
+        }
+        // Reading TOK_EOF consumes trailing whitespace but keeps the cursor.
+        const LexedToken *t = l->cursor < b->count ? tok_at(b, l->cursor) : NULL;
+        if (t && t->type == TOK_EOF && state_is(l, tok_end(t), t->end_line, t->end_col))
+        {
+            return 1;
+        }
+    }
+
+    if (state_is(l, b->base_pos, b->base_line, b->base_col))
+    {
+        l->cursor = 0;
+        return 1;
+    }
+    if (l->pos < b->base_pos)
+    {
+        return 0;
+    }
+    while (!b->at_eof && (b->count == 0 || tok_end(tok_at(b, b->count - 1)) < l->pos))
+    {
+        tokbuf_fill(b, b->count);
+    }
+
+    // First token ending at `pos`.
+    int lo = 0;
+    int hi = b->count;
+    while (lo < hi)
+    {
+        int mid = lo + (hi - lo) / 2;
+        if (tok_end(tok_at(b, mid)) < l->pos)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    for (int i = lo; i < b->count && tok_end(tok_at(b, i)) == l->pos; i++)
+    {
+        const LexedToken *t = tok_at(b, i);
+        if (t->end_line == l->line && t->end_col == l->col)
+        {
+            l->cursor = t->type == TOK_EOF ? i : i + 1;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Index of the first token at or after `i` that the lexer would return.
+static int visible_index(const Lexer *l, int i)
+{
+    struct TokenBuffer *b = l->buf;
+    while (1)
+    {
+        tokbuf_fill(b, i);
+        if (i >= b->count)
+        {
+            return b->count - 1;
+        }
+        if (tok_at(b, i)->type != TOK_COMMENT || l->emit_comments)
+        {
+            return i;
+        }
+        i++;
+    }
+}
+
+static Token make_token(const struct TokenBuffer *b, int i)
+{
+    const LexedToken *t = tok_at(b, i);
+    return (Token){(ZenTokenType)t->type, (int)t->len, b->src + t->start, t->line, t->col, t->ident};
+}
+
+// Index of the next visible token when the lexer is in sync and that token is
+// already buffered, -1 otherwise. This is the common case of every
+// lexer_next/lexer_peek, so it avoids the general lexer_sync.
+static int fast_index(const Lexer *l)
+{
+    const struct TokenBuffer *b = l->buf;
+    int i = l->cursor;
+    if (!b || b->src != l->src || l->split || i >= b->count)
+    {
+        return -1;
+    }
+    if (i == 0)
+    {
+        if (!state_is(l, b->base_pos, b->base_line, b->base_col))
+        {
+            return -1;
+        }
+    }
+    else
+    {
+        const LexedToken *prev = tok_at(b, i - 1);
+        if (!state_is(l, tok_end(prev), prev->end_line, prev->end_col))
+        {
+            return -1;
+        }
+    }
+    while (tok_at(b, i)->type == TOK_COMMENT && !l->emit_comments)
+    {
+        if (++i >= b->count)
+        {
+            return -1;
+        }
+    }
+    return i;
+}
+
+Token lexer_next(Lexer *l)
+{
+    int i = fast_index(l);
+    if (i < 0)
+    {
+        if (!lexer_sync(l))
+        {
+            l->split = 0;
+            return scan_token(l);
+        }
+        i = visible_index(l, l->cursor);
+    }
+
+    const LexedToken *t = tok_at(l->buf, i);
+    l->pos = tok_end(t);
+    l->line = t->end_line;
+    l->col = t->end_col;
+    l->cursor = t->type == TOK_EOF ? i : i + 1;
+    return make_token(l->buf, i);
 }
 
 Token lexer_peek(Lexer *l)
 {
-    Lexer saved = *l;
-    return lexer_next(&saved);
+    int i = fast_index(l);
+    if (i < 0)
+    {
+        if (!lexer_sync(l))
+        {
+            Lexer saved = *l;
+            return scan_token(&saved);
+        }
+        i = visible_index(l, l->cursor);
+    }
+    return make_token(l->buf, i);
 }
 
 Token lexer_peek2(Lexer *l)
 {
-    Lexer saved = *l;
-    lexer_next(&saved);
-    return lexer_next(&saved);
+    if (!lexer_sync(l))
+    {
+        Lexer saved = *l;
+        saved.split = 0;
+        scan_token(&saved);
+        return lexer_next(&saved);
+    }
+    int i = visible_index(l, l->cursor);
+    if (tok_at(l->buf, i)->type != TOK_EOF)
+    {
+        i = visible_index(l, i + 1);
+    }
+    return make_token(l->buf, i);
+}
+
+int lexer_mark(Lexer *l)
+{
+    if (!l->split && !lexer_sync(l))
+    {
+        // Mid-token position set by hand: start a buffer from here.
+        l->buf = tokbuf_new(l);
+        l->cursor = 0;
+    }
+    return l->cursor * 2 + l->split;
+}
+
+void lexer_rewind(Lexer *l, int mark)
+{
+    l->cursor = mark / 2;
+    l->split = mark % 2;
+    tokbuf_state_before(l->buf, l->cursor, &l->pos, &l->line, &l->col);
+    if (l->split)
+    {
+        l->pos += 1;
+        l->col += 1;
+    }
+}
+
+void lexer_split_rangle(Lexer *l)
+{
+    int synced = !l->split && lexer_sync(l);
+    l->pos += 1;
+    l->col += 1;
+    l->split = synced;
+}
+
+void lexer_prelex(Lexer *l)
+{
+    if (!l->split && !lexer_sync(l))
+    {
+        l->buf = tokbuf_new(l);
+        l->cursor = 0;
+    }
+    tokbuf_fill(l->buf, INT_MAX);
 }
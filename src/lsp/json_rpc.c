@@ -31,7 +31,7 @@ static void get_params(cJSON *root, char **uri, int *line, int *col)
         cJSON *u = cJSON_GetObjectItem(doc, "uri");
         if (u && u->valuestring)
         {
-            *uri = strdup(u->valuestring);
+            *uri = xstrdup(u->valuestring);
         }
     }
 
@@ -83,21 +83,21 @@ void handle_request(const char *json_str)
             cJSON *rp = cJSON_GetObjectItem(params, "rootPath");
             if (rp && rp->valuestring)
             {
-                root = strdup(rp->valuestring);
+                root = xstrdup(rp->valuestring);
             }
             else
             {
                 cJSON *ru = cJSON_GetObjectItem(params, "rootUri");
                 if (ru && ru->valuestring)
                 {
-                    root = strdup(ru->valuestring);
+                    root = xstrdup(ru->valuestring);
                 }
             }
         }
 
         if (root && strncmp(root, "file://", 7) == 0)
         {
-            char *clean = strdup(root + 7);
+            char *clean = xstrdup(root + 7);
             free(root);
             root = clean;
         }
@@ -134,7 +134,7 @@ void handle_request(const char *json_str)
         char *str = cJSON_PrintUnformatted(res_json);
         fprintf(stdout, "Content-Length: %zu\r\n\r\n%s", strlen(str), str);
         fflush(stdout);
-        free(str);
+        cJSON_free(str);
         cJSON_Delete(res_json);
         fflush(stdout);
     }
@@ -257,12 +257,12 @@ void handle_request(const char *json_str)
                         // fallback empty
                         cJSON_AddItemToObject(res_json, "result", cJSON_CreateObject());
                     }
-                    free(resp);
+                    cJSON_free(resp);
 
                     char *str = cJSON_PrintUnformatted(res_json);
                     fprintf(stdout, "Content-Length: %zu\r\n\r\n%s", strlen(str), str);
                     fflush(stdout);
-                    free(str);
+                    cJSON_free(str);
                     cJSON_Delete(res_json);
                 }
             }
@@ -28,7 +28,7 @@ static void send_json_response(cJSON *root)
     {
         fprintf(stdout, "Content-Length: %zu\r\n\r\n%s", strlen(str), str);
         fflush(stdout);
-        free(str);
+        cJSON_free(str);
     }
     cJSON_Delete(root);
 }
@@ -41,7 +41,7 @@ void lsp_on_error(void *data, Token t, const char *msg)
     Diagnostic *d = calloc(1, sizeof(Diagnostic));
     d->line = t.line > 0 ? t.line - 1 : 0;
     d->col = t.col > 0 ? t.col - 1 : 0;
-    d->message = strdup(msg);
+    d->message = xstrdup(msg);
     d->next = NULL;
 
     if (!list->head)
@@ -75,7 +75,7 @@ void lsp_check_file(const char *uri, const char *json_src, int id)
     // Setup error capture on the global project context
     DiagnosticList diagnostics = {0};
 
-    // We attach the callback to 'g_project->ctx'.
+    // We attach the callback to 'g_project->ctx'; the file's context copies it while parsing.
     void *old_data = g_project->ctx->error_callback_data;
     void (*old_cb)(void *, Token, const char *) = g_project->ctx->on_error;
 
@@ -411,7 +411,7 @@ static Type *resolve_local_type(ASTNode *func, const char *name)
 void lsp_completion(const char *uri, int line, int col, int id)
 {
     ProjectFile *pf = lsp_project_get_file(uri);
-    if (!g_project || !g_project->ctx || !pf)
+    if (!g_project || !pf || !pf->ctx)
     {
         return;
     }
@@ -490,11 +490,11 @@ void lsp_completion(const char *uri, int line, int col, int id)
                         ASTNode *decl = find_local_in_func(target_func, var_name);
                         if (decl && decl->type == NODE_VAR_DECL && decl->var_decl.type_str)
                         {
-                            type_name = strdup(decl->var_decl.type_str);
+                            type_name = xstrdup(decl->var_decl.type_str);
                         }
                         else
                         {
-                            ZenSymbol *sym = find_symbol_in_all(g_project->ctx, var_name);
+                            ZenSymbol *sym = find_symbol_in_all(pf->ctx, var_name);
                             if (sym)
                             {
                                 if (sym->type_info)
@@ -503,7 +503,7 @@ void lsp_completion(const char *uri, int line, int col, int id)
                                 }
                                 else if (sym->type_name)
                                 {
-                                    type_name = strdup(sym->type_name);
+                                    type_name = xstrdup(sym->type_name);
                                 }
                             }
                         }
@@ -525,7 +525,7 @@ void lsp_completion(const char *uri, int line, int col, int id)
                         }
                         *dst = 0;
 
-                        StructDef *sd = g_project->ctx->struct_defs;
+                        StructDef *sd = pf->ctx->struct_defs;
                         while (sd)
                         {
                             if (strcmp(sd->name, clean_name) == 0)
@@ -574,7 +574,7 @@ void lsp_completion(const char *uri, int line, int col, int id)
             cJSON_AddItemToArray(items, item);
         }
 
-        StructRef *g = g_project->ctx->parsed_globals_list;
+        StructRef *g = pf->ctx->parsed_globals_list;
         while (g)
         {
             if (g->node)
@@ -588,7 +588,7 @@ void lsp_completion(const char *uri, int line, int col, int id)
             g = g->next;
         }
 
-        StructDef *s = g_project->ctx->struct_defs;
+        StructDef *s = pf->ctx->struct_defs;
         while (s)
         {
             cJSON *item = cJSON_CreateObject();
@@ -598,7 +598,7 @@ void lsp_completion(const char *uri, int line, int col, int id)
             s = s->next;
         }
 
-        FuncSig *f = g_project->ctx->func_registry;
+        FuncSig *f = pf->ctx->func_registry;
         while (f)
         {
             cJSON *item = cJSON_CreateObject();
@@ -893,7 +893,7 @@ void lsp_signature_help(const char *uri, int line, int col, int id)
     cJSON_AddStringToObject(root, "jsonrpc", "2.0");
     cJSON_AddNumberToObject(root, "id", id);
 
-    if (!g_project || !g_project->ctx || !pf || !pf->source)
+    if (!g_project || !pf || !pf->ctx || !pf->source)
     {
         cJSON_AddNullToObject(root, "result");
         send_json_response(root);
@@ -957,7 +957,7 @@ void lsp_signature_help(const char *uri, int line, int col, int id)
                 strncpy(func_name, ident_start, len);
                 func_name[len] = 0;
                 // Lookup
-                FuncSig *fn = g_project->ctx->func_registry;
+                FuncSig *fn = pf->ctx->func_registry;
                 while (fn)
                 {
                     if (strcmp(fn->name, func_name) == 0)
@@ -1037,29 +1037,29 @@ static char *get_symbol_at(ProjectFile *pf, int line, int col)
         {
             if (r->node->type == NODE_FUNCTION)
             {
-                return strdup(r->node->func.name);
+                return xstrdup(r->node->func.name);
             }
             if (r->node->type == NODE_VAR_DECL)
             {
-                return strdup(r->node->var_decl.name);
+                return xstrdup(r->node->var_decl.name);
             }
             if (r->node->type == NODE_CONST)
             {
-                return strdup(r->node->var_decl.name);
+                return xstrdup(r->node->var_decl.name);
             }
             if (r->node->type == NODE_STRUCT)
             {
-                return strdup(r->node->strct.name);
+                return xstrdup(r->node->strct.name);
             }
             if (r->node->type == NODE_EXPR_VAR)
             {
-                return strdup(r->node->var_ref.name);
+                return xstrdup(r->node->var_ref.name);
             }
             if (r->node->type == NODE_EXPR_CALL)
             {
                 if (r->node->call.callee && r->node->call.callee->type == NODE_EXPR_VAR)
                 {
-                    return strdup(r->node->call.callee->var_ref.name);
+                    return xstrdup(r->node->call.callee->var_ref.name);
                 }
             }
         }
@@ -1,6 +1,7 @@
 
 #include "json_rpc.h"
 #include "zprep.h"
+#include "../utils/arena.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -14,6 +15,11 @@ int lsp_main(int argc, char **argv)
     fprintf(stderr, "zls: Zen Language Server starting...\n");
     g_config.mode_lsp = 1;
 
+    // Each message is handled in a region that is reset afterwards. State that
+    // outlives it (the project, each file's region) is allocated elsewhere.
+    ZArena *request_arena = arena_create("lsp-request");
+    ZArena *prev = arena_use(request_arena);
+
     while (1)
     {
         // Read headers
@@ -59,9 +65,9 @@ int lsp_main(int argc, char **argv)
         // Process JSON-RPC.
         fprintf(stderr, "zls: Received: %s\n", body);
         handle_request(body);
-
-        free(body);
+        arena_reset(request_arena);
     }
 
+    arena_use(prev);
     return 0;
 }
@@ -8,6 +8,7 @@
 LSPProject *g_project = NULL;
 
 static void scan_dir(const char *dir_path);
+void lsp_default_on_error(void *data, Token t, const char *msg);
 
 void lsp_project_init(const char *root_path)
 {
@@ -18,6 +19,8 @@ void lsp_project_init(const char *root_path)
 
     fprintf(stderr, "zls: Initializing project at %s\n", root_path);
 
+    // The project outlives the request that creates it.
+    ZArena *prev = arena_use(arena_global());
     g_project = xcalloc(1, sizeof(LSPProject));
     g_project->root_path = xstrdup(root_path);
 
@@ -27,8 +30,8 @@ void lsp_project_init(const char *root_path)
 
     // Set a default error handler that just logs to stderr (or ignores)
     // to prevent exit(1) during initial scan.
-    void lsp_default_on_error(void *data, Token t, const char *msg);
     g_project->ctx->on_error = lsp_default_on_error;
+    arena_use(prev);
 
     // Scan workspace
     scan_dir(root_path);
@@ -125,6 +128,7 @@ ProjectFile *lsp_project_get_file(const char *uri)
 
 static ProjectFile *add_project_file(const char *uri)
 {
+    ZArena *prev = arena_use(arena_global());
     ProjectFile *f = xcalloc(1, sizeof(ProjectFile));
     f->uri = xstrdup(uri);
     // Simple path extraction from URI (file://...)
@@ -137,6 +141,12 @@ static ProjectFile *add_project_file(const char *uri)
         f->path = xstrdup(uri);
     }
 
+    char name[64];
+    const char *base = strrchr(f->path, '/');
+    snprintf(name, sizeof(name), "lsp:%s", base ? base + 1 : f->path);
+    f->arena = arena_create(name);
+    arena_use(prev);
+
     f->next = g_project->files;
     g_project->files = f;
     return f;
@@ -149,40 +159,45 @@ void lsp_project_update_file(const char *uri, const char *src)
         return;
     }
 
-    extern char *g_current_filename;
-    g_current_filename = (char *)uri;
-
     ProjectFile *pf = lsp_project_get_file(uri);
     if (!pf)
     {
         pf = add_project_file(uri);
     }
 
-    if (pf->index)
-    {
-        lsp_index_free(pf->index);
-        pf->index = NULL;
-    }
+    extern char *g_current_filename;
+    g_current_filename = pf->uri;
+
+    // Everything parsed from the previous version lives in the file's region
+    // (each file has its own context), so it is dropped wholesale.
+    pf->ast = NULL;
+    pf->ctx = NULL;
+    pf->index = NULL;
+    arena_reset(pf->arena);
+    ZArena *prev = arena_use(pf->arena);
 
-    if (pf->source)
-    {
-        free(pf->source);
-    }
     pf->source = xstrdup(src);
+    pf->ctx = xcalloc(1, sizeof(ParserContext));
+    pf->ctx->is_fault_tolerant = g_project->ctx->is_fault_tolerant;
+    pf->ctx->on_error = g_project->ctx->on_error;
+    pf->ctx->error_callback_data = g_project->ctx->error_callback_data;
 
     Lexer l;
-    lexer_init(&l, src);
-
-    ASTNode *root = parse_program(g_project->ctx, &l);
+    lexer_init(&l, pf->source);
 
+    ASTNode *root = parse_program(pf->ctx, &l);
     pf->ast = root;
 
     pf->index = lsp_index_new();
     if (root)
     {
         lsp_build_index(pf->index, root);
-        validate_types(g_project->ctx);
+        validate_types(pf->ctx);
     }
+    // The handler's data belongs to this update; later requests only read the context.
+    pf->ctx->on_error = lsp_default_on_error;
+    pf->ctx->error_callback_data = NULL;
+    arena_use(prev);
 }
 
 DefinitionResult lsp_project_find_definition(const char *name)
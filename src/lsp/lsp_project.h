@@ -3,17 +3,20 @@
 
 #include "parser.h"
 #include "lsp_index.h"
+#include "../utils/arena.h"
 
 /**
  * @brief Represents a tracked file in the LSP project.
  */
 typedef struct ProjectFile
 {
-    char *path;      ///< Absolute file path.
-    char *uri;       ///< file:// URI.
-    char *source;    ///< Cached source content (in-memory).
-    ASTNode *ast;    ///< Cached AST for semantic analysis.
-    LSPIndex *index; ///< File-specific symbol index.
+    char *path;         ///< Absolute file path.
+    char *uri;          ///< file:// URI.
+    char *source;       ///< Cached source content (in-memory).
+    ASTNode *ast;       ///< Cached AST for semantic analysis.
+    ParserContext *ctx; ///< Context the AST was parsed in (its registries).
+    LSPIndex *index;    ///< File-specific symbol index.
+    ZArena *arena;      ///< Region holding source, AST, context and index; reset on every update.
     struct ProjectFile *next;
 } ProjectFile;
 
@@ -23,8 +26,8 @@ typedef struct ProjectFile
 typedef struct
 {
     /**
-     * @brief Global shared parser context.
-     * Contains global registries (structs, functions) reused across files.
+     * @brief Settings for the files' parser contexts.
+     * Its flags and error handler are copied into each file's context.
      */
     ParserContext *ctx;
 
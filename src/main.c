@@ -6,12 +6,16 @@
 #include "zprep.h"
 #include "analysis/typecheck.h"
 #include "codegen/compat.h"
+#include <ctype.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 #include "utils/cmd.h"
+#include "utils/threadpool.h"
+#include "utils/watch.h"
+#include "utils/arena.h"
 
 // Forward decl for LSP
 int lsp_main(int argc, char **argv);
@@ -43,17 +47,35 @@ void print_usage()
     printf("  " COLOR_GREEN "transpile" COLOR_RESET
            "    Transpile to C code only (no compilation)\n");
     printf("  " COLOR_GREEN "lsp" COLOR_RESET "          Start Language Server\n");
+    printf("  " COLOR_GREEN "watch" COLOR_RESET
+           "        Rebuild (watch run: re-run, watch check: re-check) on changes\n");
+    printf("  " COLOR_GREEN "cache" COLOR_RESET "        Build cache: stats, prune\n");
     printf("\n" COLOR_BOLD COLOR_YELLOW "Options:" COLOR_RESET "\n");
     printf("  " COLOR_CYAN "-o" COLOR_RESET " <file>       Output executable name\n");
     printf("  " COLOR_CYAN "-O" COLOR_RESET "<level>       Optimization level\n");
     printf("  " COLOR_CYAN "-g" COLOR_RESET "              Debug info\n");
     printf("  " COLOR_CYAN "-c" COLOR_RESET "              Compile only (produce .o)\n");
+    printf("  " COLOR_CYAN "-j" COLOR_RESET "<n>           Worker threads (default: CPU count)\n");
+    printf("  " COLOR_CYAN "--split-units" COLOR_RESET "[=n] Compile as n C units in parallel\n");
+    printf("  " COLOR_CYAN "--release" COLOR_RESET "[=native] -O3 with LTO (and -march=native)\n");
+    printf("  " COLOR_CYAN "--pgo-gen" COLOR_RESET
+           "[=dir]   Build instrumented to record a profile\n");
+    printf("  " COLOR_CYAN "--pgo-use" COLOR_RESET
+           "[=dir]   Build optimized with the recorded profile\n");
+    printf("  " COLOR_CYAN "--pgo-train" COLOR_RESET
+           " <cmd>  Instrumented build, run <cmd>, optimized build\n");
+    printf("  " COLOR_CYAN "-MD" COLOR_RESET " [" COLOR_CYAN "-MF" COLOR_RESET
+           " <file>] Write the files read as a make rule (-MP: phony targets)\n");
     printf("  " COLOR_CYAN "-v" COLOR_RESET ", " COLOR_CYAN "--verbose" COLOR_RESET
            "   Verbose output\n");
     printf("  " COLOR_CYAN "-q" COLOR_RESET ", " COLOR_CYAN "--quiet" COLOR_RESET
            "     Quiet output\n");
+    printf("  " COLOR_CYAN "--no-cache" COLOR_RESET "      Skip the build cache\n");
     printf("  " COLOR_CYAN "--emit-c" COLOR_RESET "        Keep generated C file (out.c)\n");
     printf("  " COLOR_CYAN "--keep-comments" COLOR_RESET " Preserve comments in output C\n");
+    printf("  " COLOR_CYAN "--mem-stats" COLOR_RESET "     Report memory usage per region\n");
+    printf("  " COLOR_CYAN "--stats" COLOR_RESET "         Report compiler work counters\n");
+    printf("  " COLOR_CYAN "--time-passes" COLOR_RESET "   Report time and memory per phase\n");
     printf("  " COLOR_CYAN "--freestanding" COLOR_RESET "  Freestanding mode (no stdlib)\n");
     printf("  " COLOR_CYAN "--cc" COLOR_RESET
            " <compiler> C compiler to use (gcc, clang, tcc, zig)\n");
@@ -67,8 +89,171 @@ void print_usage()
     printf("  " COLOR_CYAN "--version" COLOR_RESET "       Print version information\n");
 }
 
-void build_compile_command(char *cmd, size_t cmd_size, const char *outfile,
-                           const char *temp_source_file, const char *extra_c_sources)
+static void print_mem_stats(void)
+{
+    arena_print_stats(stderr);
+}
+
+static void print_compile_stats(void)
+{
+    stats_report(stderr);
+}
+
+// Keep the program's sources and imports loaded and lexed in the zc watch
+// process. Only the files that changed are read again before each build.
+static void watch_prepare(void)
+{
+    prefetch_keep(g_config.input_file);
+    for (int ef = 0; ef < g_config.extra_file_count; ef++)
+    {
+        char *real_path = realpath(g_config.extra_files[ef], NULL);
+        const char *path = real_path ? real_path : g_config.extra_files[ef];
+        const char *ext = strrchr(path, '.');
+        if (!ext || !ZC_IS_BACKEND_EXT(ext))
+        {
+            prefetch_keep(path);
+        }
+        if (real_path)
+        {
+            free(real_path);
+        }
+    }
+}
+
+// Run the built program (zc run) or report the build (zc build).
+static int finish_build(const char *outfile, double start_time)
+{
+    if (build_cache_write_depfile(outfile) != 0)
+    {
+        return 1;
+    }
+    watch_note_built();
+    if (g_config.mode_run)
+    {
+        char run_cmd[2048];
+        if (z_is_windows() || strchr(outfile, '/'))
+        {
+            snprintf(run_cmd, sizeof(run_cmd), "%s", outfile);
+        }
+        else
+        {
+            snprintf(run_cmd, sizeof(run_cmd), "./%s", outfile);
+        }
+        if (!g_config.quiet)
+        {
+            printf(COLOR_BOLD COLOR_GREEN "     Running" COLOR_RESET " %s\n", outfile);
+            fflush(stdout);
+        }
+        // Execute the program directly; fall back to the shell where
+        // z_spawn is not available.
+        char *run_argv[] = {run_cmd, NULL};
+        watch_exec(run_argv);
+        ZProcess proc;
+        int ret;
+        if (z_spawn(&proc, run_argv, 0, 0) == 0)
+        {
+            ret = z_wait(&proc);
+        }
+        else
+        {
+            ret = system(run_cmd);
+#if defined(WIFEXITED) && defined(WEXITSTATUS)
+            ret = WIFEXITED(ret) ? WEXITSTATUS(ret) : ret;
+#endif
+        }
+        remove(outfile);
+        zptr_plugin_mgr_cleanup();
+        zen_trigger_global();
+        return ret;
+    }
+
+    zptr_plugin_mgr_cleanup();
+    zen_trigger_global();
+
+    double end_time = z_get_monotonic_time();
+    double time_taken = end_time - start_time;
+
+    if (!g_config.quiet && !g_config.mode_run && !g_config.mode_check)
+    {
+        if (g_warning_count > 0)
+        {
+            printf(COLOR_BOLD COLOR_GREEN "    Finished" COLOR_RESET
+                                          " build in %.2fs with %d warning%s\n",
+                   time_taken, g_warning_count, g_warning_count == 1 ? "" : "s");
+        }
+        else
+        {
+            printf(COLOR_BOLD COLOR_GREEN "    Finished" COLOR_RESET " build in %.2fs\n",
+                   time_taken);
+        }
+        fflush(stdout);
+    }
+
+    return 0;
+}
+
+// Backends whose flag conventions zc knows.
+typedef enum
+{
+    BACKEND_OTHER,
+    BACKEND_GCC,
+    BACKEND_CLANG
+} BackendKind;
+
+static BackendKind backend_kind(void)
+{
+    if (strstr(g_config.cc, "clang"))
+    {
+        return BACKEND_CLANG;
+    }
+    if (strstr(g_config.cc, "gcc"))
+    {
+        return BACKEND_GCC;
+    }
+    return BACKEND_OTHER;
+}
+
+// Flags of --release and of profile-guided builds. Other backends than gcc
+// and clang only get -O3 (and -march=native).
+static void add_optimization_flags(CmdBuilder *cb)
+{
+    BackendKind kind = backend_kind();
+    if (g_config.release)
+    {
+        cmd_add(cb, "-O3");
+        if (kind != BACKEND_OTHER)
+        {
+            cmd_add(cb, "-flto");
+#if !defined(_WIN32) && !defined(__APPLE__)
+            cmd_add(cb, "-fno-plt"); // ELF only.
+#endif
+        }
+        if (g_config.release == 2)
+        {
+            cmd_add(cb, "-march=native");
+        }
+    }
+
+    if (g_config.pgo_gen)
+    {
+        cmd_add_fmt(cb, "-fprofile-generate=\"%s\"", g_config.pgo_dir);
+    }
+    else if (g_config.pgo_use && kind == BACKEND_CLANG)
+    {
+        cmd_add_fmt(cb, "-fprofile-use=\"%s/default.profdata\"", g_config.pgo_dir);
+    }
+    else if (g_config.pgo_use)
+    {
+        // Counters of threaded programs are updated racily; let gcc repair
+        // small inconsistencies instead of rejecting the profile.
+        cmd_add_fmt(cb, "-fprofile-use=\"%s\" -fprofile-correction", g_config.pgo_dir);
+    }
+}
+
+// Backend command producing `outfile` from `inputs`: an object file with
+// `link` 0 (-c), the program otherwise.
+static void build_backend_command(char *cmd, size_t cmd_size, const char *outfile,
+                                  const char *inputs, const char *extra_c_sources, int link)
 {
     CmdBuilder cb;
     cmd_init(&cb);
@@ -79,6 +264,7 @@ void build_compile_command(char *cmd, size_t cmd_size, const char *outfile,
     // GCC Flags
     cmd_add(&cb, g_config.gcc_flags);
     cmd_add(&cb, g_cflags);
+    add_optimization_flags(&cb);
 
     // Freestanding
     if (g_config.is_freestanding)
@@ -93,28 +279,35 @@ void build_compile_command(char *cmd, size_t cmd_size, const char *outfile,
     }
 
     // Output file
+    if (!link)
+    {
+        cmd_add(&cb, "-c");
+    }
     cmd_add(&cb, "-o");
     cmd_add(&cb, outfile);
 
     // Input files
-    cmd_add(&cb, temp_source_file);
+    cmd_add(&cb, inputs);
     cmd_add(&cb, extra_c_sources);
 
-    // Platform flags
-    if (!z_is_windows() && !g_config.is_freestanding)
+    if (link)
     {
-        cmd_add(&cb, "-lm");
-        if (g_parser_ctx && g_parser_ctx->has_async)
+        // Platform flags
+        if (!z_is_windows() && !g_config.is_freestanding)
         {
-            cmd_add(&cb, "-lpthread");
+            cmd_add(&cb, "-lm");
+            if (g_parser_ctx && g_parser_ctx->has_async)
+            {
+                cmd_add(&cb, "-lpthread");
+            }
         }
-    }
 
-    // Linker flags
-    cmd_add(&cb, g_link_flags);
-    if (z_is_windows())
-    {
-        cmd_add(&cb, "-lws2_32");
+        // Linker flags
+        cmd_add(&cb, g_link_flags);
+        if (z_is_windows())
+        {
+            cmd_add(&cb, "-lws2_32");
+        }
     }
 
     // Include paths
@@ -171,6 +364,411 @@ void build_compile_command(char *cmd, size_t cmd_size, const char *outfile,
     cmd_free(&cb);
 }
 
+void build_compile_command(char *cmd, size_t cmd_size, const char *outfile,
+                           const char *temp_source_file, const char *extra_c_sources)
+{
+    build_backend_command(cmd, cmd_size, outfile, temp_source_file, extra_c_sources, 1);
+}
+
+// Run a backend command, without a shell unless it needs one. With
+// `capture`, its output is collected and written out in one piece, so
+// compiles running side by side do not interleave their diagnostics.
+static int run_command(const char *cmd, int capture)
+{
+    char **argv = cmd_split_argv(cmd);
+    ZProcess proc;
+    if (!argv || z_spawn(&proc, argv, 0, capture) != 0)
+    {
+        return system(cmd);
+    }
+
+    if (capture)
+    {
+        size_t len = 0;
+        size_t cap = 4096;
+        char *output = xmalloc(cap);
+        ssize_t n;
+        while ((n = read(proc.out, output + len, cap - len)) > 0)
+        {
+            len += n;
+            if (len == cap)
+            {
+                cap *= 2;
+                output = xrealloc(output, cap);
+            }
+        }
+        fwrite(output, 1, len, stderr);
+    }
+    return z_wait(&proc);
+}
+
+// The backend inputs for a generated source: the source, preceded by the
+// precompiled preamble header when there is one.
+static void backend_inputs(char *buf, size_t size, const char *pch_header, const char *source)
+{
+    if (pch_header)
+    {
+        snprintf(buf, size, "-include \"%s\" %s", pch_header, source);
+    }
+    else
+    {
+        snprintf(buf, size, "%s", source);
+    }
+}
+
+typedef struct
+{
+    char cmd[32768];
+    int ret;
+} UnitJob;
+
+static void compile_unit_job(void *arg)
+{
+    UnitJob *job = arg;
+    job->ret = run_command(job->cmd, 1);
+}
+
+// Compile the units written by codegen_split_units concurrently, then link.
+static int compile_split_units(const char *outfile, const char *stem, int units,
+                               const char *pch_header, const char *extra_c_sources)
+{
+    UnitJob *jobs = xmalloc(sizeof(UnitJob) * units);
+    CmdBuilder objects;
+    cmd_init(&objects);
+    for (int u = 0; u < units; u++)
+    {
+        char unit_c[256];
+        char unit_o[256];
+        char inputs[2048];
+        snprintf(unit_c, sizeof(unit_c), "%s_%d.c", stem, u);
+        snprintf(unit_o, sizeof(unit_o), "%s_%d.o", stem, u);
+        backend_inputs(inputs, sizeof(inputs), pch_header, unit_c);
+        build_backend_command(jobs[u].cmd, sizeof(jobs[u].cmd), unit_o, inputs, NULL, 0);
+        jobs[u].ret = -1;
+        cmd_add(&objects, unit_o);
+        if (g_config.verbose)
+        {
+            printf(COLOR_BOLD COLOR_BLUE "     Command" COLOR_RESET " %s\n", jobs[u].cmd);
+        }
+    }
+    fflush(stdout);
+
+    int workers = g_config.jobs > 0 ? g_config.jobs : thread_pool_default_size();
+    ZThreadPool *pool = thread_pool_create(workers < units ? workers : units);
+    for (int u = 0; u < units; u++)
+    {
+        if (pool)
+        {
+            thread_pool_submit(pool, compile_unit_job, &jobs[u]);
+        }
+        else
+        {
+            compile_unit_job(&jobs[u]);
+        }
+    }
+    if (pool)
+    {
+        thread_pool_destroy(pool);
+    }
+
+    int ret = 0;
+    for (int u = 0; u < units; u++)
+    {
+        if (jobs[u].ret != 0)
+        {
+            ret = jobs[u].ret;
+        }
+    }
+    if (ret == 0)
+    {
+        char cmd[32768];
+        build_backend_command(cmd, sizeof(cmd), outfile, cmd_to_string(&objects),
+                              extra_c_sources, 1);
+        if (g_config.verbose)
+        {
+            printf(COLOR_BOLD COLOR_BLUE "        Link" COLOR_RESET " %s\n", cmd);
+        }
+        ret = run_command(cmd, 0);
+    }
+
+    for (int u = 0; u < units; u++)
+    {
+        char path[256];
+        snprintf(path, sizeof(path), "%s_%d.o", stem, u);
+        remove(path);
+        if (!g_config.emit_c)
+        {
+            snprintf(path, sizeof(path), "%s_%d.c", stem, u);
+            remove(path);
+        }
+    }
+    if (!g_config.emit_c)
+    {
+        char path[256];
+        snprintf(path, sizeof(path), "%s.h", stem);
+        remove(path);
+    }
+    cmd_free(&objects);
+    return ret;
+}
+
+// Number of units to split into, or 0 to compile one file. Splitting needs
+// a C backend that links (not -c, -S or -E, which expect one output). Profile
+// files are named after the source, so profile-guided builds do not split.
+static int split_unit_count(void)
+{
+    if (g_config.split_units == 0 || g_config.use_cpp || g_config.use_cuda ||
+        g_config.use_objc || g_config.pgo_gen || g_config.pgo_use)
+    {
+        return 0;
+    }
+    const char *only[] = {"-c", "-S", "-E"};
+    for (size_t i = 0; i < sizeof(only) / sizeof(only[0]); i++)
+    {
+        const char *f = g_config.gcc_flags;
+        while ((f = strstr(f, only[i])) != NULL)
+        {
+            if ((f == g_config.gcc_flags || f[-1] == ' ') && (f[2] == 0 || f[2] == ' '))
+            {
+                return 0;
+            }
+            f += 2;
+        }
+    }
+    if (g_config.split_units > 0)
+    {
+        return g_config.split_units;
+    }
+    return g_config.jobs > 0 ? g_config.jobs : thread_pool_default_size();
+}
+
+// Extension of the precompiled header that the backend picks up next to a
+// header passed with -include, or NULL if it is not known to support it.
+static const char *pch_extension(void)
+{
+    switch (backend_kind())
+    {
+    case BACKEND_CLANG:
+        return ".pch";
+    case BACKEND_GCC:
+        return ".gch";
+    default:
+        return NULL;
+    }
+}
+
+// Build (or reuse from the cache) the precompiled preamble of this program.
+// Returns the header to pass with -include, or NULL to emit the whole
+// preamble into the generated source.
+static const char *precompile_preamble(ParserContext *ctx, ASTNode *root)
+{
+    const char *ext = pch_extension();
+    // Extra C sources would be compiled with -include too, and an emitted C
+    // file has to stand on its own.
+    if (!ext || g_config.no_cache || g_config.emit_c || g_config.is_freestanding ||
+        g_config.use_cpp || g_config.use_cuda || g_config.use_objc || g_config.c_file_count > 0)
+    {
+        return NULL;
+    }
+
+    FILE *f = z_tmpfile();
+    if (!f)
+    {
+        return NULL;
+    }
+    emit_preamble_header(ctx, root, f);
+    long len = ftell(f);
+    char *text = xmalloc(len + 1);
+    rewind(f);
+    text[fread(text, 1, len, f)] = 0;
+    fclose(f);
+
+    // The compiler rejects a precompiled header built with other flags, so
+    // they are part of the key.
+    char cmd[32768];
+    static char header[1024];
+    build_backend_command(cmd, sizeof(cmd), "zc_preamble.h.gch", "-x c-header zc_preamble.h", NULL,
+                          0);
+    int found = build_cache_pch(text, cmd, ext, header, sizeof(header));
+    if (found != 0)
+    {
+        return found > 0 ? header : NULL;
+    }
+
+    char pch[1100];
+    char tmp[1200];
+    char input[1100];
+    snprintf(pch, sizeof(pch), "%s%s", header, ext);
+    snprintf(tmp, sizeof(tmp), "%s.tmp%d", pch, z_get_pid());
+    snprintf(input, sizeof(input), "-x c-header \"%s\"", header);
+    build_backend_command(cmd, sizeof(cmd), tmp, input, NULL, 0);
+    if (g_config.verbose)
+    {
+        printf(COLOR_BOLD COLOR_BLUE "  Precompile" COLOR_RESET " %s\n", cmd);
+        fflush(stdout);
+    }
+    remove(pch);
+    if (run_command(cmd, 0) != 0 || rename(tmp, pch) != 0)
+    {
+        remove(tmp);
+        return NULL;
+    }
+    return header;
+}
+
+// Start the C compiler reading the generated code from a pipe (gcc and clang,
+// C output only). Returns the stream to generate into, or NULL to write a
+// file instead. --stats needs the file to report the output size.
+static FILE *start_streamed_compile(ZProcess *proc, char *cmd, size_t cmd_size,
+                                    const char *outfile, const char *pch_header,
+                                    const char *extra_c_sources)
+{
+    if (g_config.mode_transpile || g_config.emit_c || g_config.stats || g_config.use_cpp ||
+        g_config.use_cuda || g_config.use_objc || !pch_extension())
+    {
+        return NULL;
+    }
+
+    char inputs[2048];
+    backend_inputs(inputs, sizeof(inputs), pch_header, "-x c - -x none");
+    build_compile_command(cmd, cmd_size, outfile, inputs, extra_c_sources);
+    char **argv = cmd_split_argv(cmd);
+    if (!argv || z_spawn(proc, argv, 1, 0) != 0)
+    {
+        return NULL;
+    }
+    if (g_config.verbose)
+    {
+        printf(COLOR_BOLD COLOR_BLUE "     Command" COLOR_RESET " %s\n", cmd);
+        fflush(stdout);
+    }
+
+    FILE *f = fdopen(proc->in, "w");
+    if (!f)
+    {
+        z_wait(proc);
+        return NULL;
+    }
+    setvbuf(f, NULL, _IOFBF, 1 << 16);
+    return f;
+}
+
+// Resolve the profile directory of a --pgo-gen or --pgo-use build. With
+// clang, --pgo-use first merges the raw profiles the program wrote.
+static int prepare_pgo(const char *outfile)
+{
+    if (g_config.pgo_gen && g_config.pgo_use)
+    {
+        fprintf(stderr, COLOR_BOLD COLOR_RED "error" COLOR_RESET
+                        ": --pgo-gen and --pgo-use cannot be combined\n");
+        return 1;
+    }
+    if (backend_kind() == BACKEND_OTHER)
+    {
+        fprintf(stderr,
+                COLOR_BOLD COLOR_RED "error" COLOR_RESET
+                ": profile-guided builds need gcc or clang (not '%s')\n",
+                g_config.cc);
+        return 1;
+    }
+
+    // The instrumented program may run from another directory, so the
+    // directory is passed to the compiler as an absolute path.
+    static char dir[PATH_MAX];
+    int ok;
+    if (g_config.pgo_dir)
+    {
+        z_mkdir(g_config.pgo_dir);
+        ok = realpath(g_config.pgo_dir, dir) != NULL;
+    }
+    else
+    {
+        ok = build_cache_profile_dir(outfile, dir, sizeof(dir)) == 0;
+    }
+    if (!ok)
+    {
+        fprintf(stderr,
+                COLOR_BOLD COLOR_RED "error" COLOR_RESET ": cannot create profile directory '%s'\n",
+                g_config.pgo_dir ? g_config.pgo_dir : dir);
+        return 1;
+    }
+    g_config.pgo_dir = dir;
+
+    if (g_config.pgo_use && backend_kind() == BACKEND_CLANG)
+    {
+        char cmd[PATH_MAX * 2 + 64];
+        snprintf(cmd, sizeof(cmd),
+                 "llvm-profdata merge -output=\"%s/default.profdata\" \"%s\"/*.profraw", dir,
+                 dir);
+        if (system(cmd) != 0)
+        {
+            fprintf(stderr,
+                    COLOR_BOLD COLOR_RED "error" COLOR_RESET
+                    ": cannot merge the profiles in '%s' (llvm-profdata)\n",
+                    dir);
+            return 1;
+        }
+    }
+    if (g_config.pgo_gen && !g_config.quiet)
+    {
+        printf(COLOR_BOLD COLOR_GREEN "  Instrument" COLOR_RESET " profiles go to %s\n", dir);
+        fflush(stdout);
+    }
+    return 0;
+}
+
+// --pgo-train: an instrumented build, the training command, then a build
+// optimized with the recorded profiles. Each build is a fresh zc.
+static int pgo_train(int argc, char **argv)
+{
+    char **sub = xmalloc(sizeof(char *) * (argc + 1));
+    int n = 0;
+    for (int i = 0; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--pgo-train") == 0)
+        {
+            i++;
+            continue;
+        }
+        sub[n++] = argv[i];
+    }
+    sub[n + 1] = NULL;
+
+    char *steps[] = {"--pgo-gen", "--pgo-use"};
+    for (int s = 0; s < 2; s++)
+    {
+        sub[n] = steps[s];
+        ZProcess proc;
+        if (z_spawn(&proc, sub, 0, 0) != 0)
+        {
+            fprintf(stderr, COLOR_BOLD COLOR_RED "error" COLOR_RESET ": cannot run '%s'\n",
+                    argv[0]);
+            return 1;
+        }
+        int ret = z_wait(&proc);
+        if (ret != 0)
+        {
+            return ret;
+        }
+        if (s == 0)
+        {
+            if (!g_config.quiet)
+            {
+                printf(COLOR_BOLD COLOR_GREEN "    Training" COLOR_RESET " %s\n",
+                       g_config.pgo_train);
+                fflush(stdout);
+            }
+            if (system(g_config.pgo_train) != 0)
+            {
+                fprintf(stderr,
+                        COLOR_BOLD COLOR_RED "error" COLOR_RESET ": training command failed\n");
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
 int main(int argc, char **argv)
 {
     memset(&g_config, 0, sizeof(g_config));
@@ -197,6 +795,10 @@ int main(int argc, char **argv)
     {
         return lsp_main(argc, argv);
     }
+    else if (strcmp(command, "cache") == 0)
+    {
+        return build_cache_main(argc, argv);
+    }
     else if (strcmp(command, "repl") == 0)
     {
         run_repl(argv[0]); // Pass self path for recursive calls
@@ -215,6 +817,17 @@ int main(int argc, char **argv)
     {
         g_config.mode_check = 1;
     }
+    else if (strcmp(command, "watch") == 0)
+    {
+        g_config.mode_watch = 1;
+        if (argc > 2 && (strcmp(argv[2], "run") == 0 || strcmp(argv[2], "check") == 0 ||
+                         strcmp(argv[2], "build") == 0))
+        {
+            g_config.mode_run = strcmp(argv[2], "run") == 0;
+            g_config.mode_check = strcmp(argv[2], "check") == 0;
+            arg_start = 3;
+        }
+    }
     else if (strcmp(command, "build") == 0)
     {
         // default mode
@@ -266,6 +879,22 @@ int main(int argc, char **argv)
         {
             g_config.keep_comments = 1;
         }
+        else if (strcmp(arg, "--mem-stats") == 0)
+        {
+            g_config.mem_stats = 1;
+        }
+        else if (strcmp(arg, "--stats") == 0)
+        {
+            g_config.stats = 1;
+        }
+        else if (strcmp(arg, "--time-passes") == 0)
+        {
+            g_config.time_passes = 1;
+        }
+        else if (strcmp(arg, "--no-cache") == 0)
+        {
+            g_config.no_cache = 1;
+        }
         else if (strcmp(arg, "--version") == 0 || strcmp(arg, "-V") == 0)
         {
             print_version();
@@ -343,6 +972,69 @@ int main(int argc, char **argv)
         {
             strcat(g_config.gcc_flags, " -g");
         }
+        else if (strcmp(arg, "-j") == 0 || strcmp(arg, "--jobs") == 0)
+        {
+            if (i + 1 < argc)
+            {
+                g_config.jobs = atoi(argv[++i]);
+            }
+        }
+        else if (strncmp(arg, "-j", 2) == 0 && isdigit((unsigned char)arg[2]))
+        {
+            g_config.jobs = atoi(arg + 2);
+        }
+        else if (strcmp(arg, "--split-units") == 0)
+        {
+            g_config.split_units = -1;
+        }
+        else if (strncmp(arg, "--split-units=", 14) == 0)
+        {
+            g_config.split_units = atoi(arg + 14);
+        }
+        else if (strcmp(arg, "--release") == 0)
+        {
+            g_config.release = 1;
+        }
+        else if (strcmp(arg, "--release=native") == 0)
+        {
+            g_config.release = 2;
+        }
+        else if (strncmp(arg, "--pgo-gen", 9) == 0 && (arg[9] == 0 || arg[9] == '='))
+        {
+            g_config.pgo_gen = 1;
+            g_config.pgo_dir = arg[9] ? arg + 10 : g_config.pgo_dir;
+        }
+        else if (strncmp(arg, "--pgo-use", 9) == 0 && (arg[9] == 0 || arg[9] == '='))
+        {
+            g_config.pgo_use = 1;
+            g_config.pgo_dir = arg[9] ? arg + 10 : g_config.pgo_dir;
+        }
+        else if (strcmp(arg, "--pgo-train") == 0)
+        {
+            if (i + 1 < argc)
+            {
+                g_config.pgo_train = argv[++i];
+            }
+        }
+        else if (strcmp(arg, "-MD") == 0)
+        {
+            g_config.dep_file = 1;
+        }
+        else if (strcmp(arg, "-MP") == 0)
+        {
+            g_config.dep_phony = 1;
+        }
+        else if (strncmp(arg, "-MF", 3) == 0)
+        {
+            if (arg[3])
+            {
+                g_config.dep_output = arg + 3;
+            }
+            else if (i + 1 < argc)
+            {
+                g_config.dep_output = argv[++i];
+            }
+        }
         else if (arg[0] == '-')
         {
             // Unknown flag or C flag
@@ -370,6 +1062,52 @@ int main(int argc, char **argv)
 
     g_current_filename = g_config.input_file;
 
+    if (g_config.pgo_train)
+    {
+        return pgo_train(argc, argv);
+    }
+    if ((g_config.pgo_gen || g_config.pgo_use) &&
+        prepare_pgo(g_config.output_file ? g_config.output_file : "a.out") != 0)
+    {
+        return 1;
+    }
+
+    // Setup that does not depend on the input comes before zc watch forks, so
+    // every build starts from it.
+    init_builtins();
+
+    // Initialize Plugin Manager
+    zptr_plugin_mgr_init();
+
+    if (g_config.mode_watch)
+    {
+        // Only the build children return; they carry on below.
+        int ret = watch_main(watch_prepare);
+        if (ret >= 0)
+        {
+            return ret;
+        }
+    }
+
+    if (g_config.mem_stats)
+    {
+        atexit(print_mem_stats);
+    }
+    if (g_config.stats || g_config.time_passes)
+    {
+        atexit(print_compile_stats);
+    }
+
+    // Builds that produce an executable go through the build cache; measuring
+    // the compiler, keeping its C output, or using profiles the cache does not
+    // track always compiles.
+    if (!g_config.no_cache && !g_config.mode_transpile && !g_config.mode_check &&
+        !g_config.emit_c && !g_config.stats && !g_config.time_passes && !g_config.mem_stats &&
+        !g_config.pgo_gen && !g_config.pgo_use)
+    {
+        build_cache_begin();
+    }
+
     // Load file
     char *src = load_file(g_config.input_file);
     if (!src)
@@ -379,15 +1117,23 @@ int main(int argc, char **argv)
         return 1;
     }
 
-    init_builtins();
     zen_init();
 
-    // Initialize Plugin Manager
-    zptr_plugin_mgr_init();
-
     // Load all configurations (system, hidden project, visible project)
     load_all_configs();
 
+    char *outfile = g_config.output_file ? g_config.output_file : "a.out";
+    if (build_cache_lookup(outfile))
+    {
+        z_setup_terminal();
+        if (!g_config.quiet)
+        {
+            printf(COLOR_BOLD COLOR_GREEN "      Cached" COLOR_RESET " %s\n", g_config.input_file);
+            fflush(stdout);
+        }
+        return finish_build(outfile, z_get_monotonic_time());
+    }
+
     // Parse context init
     ParserContext ctx;
     memset(&ctx, 0, sizeof(ctx));
@@ -395,8 +1141,29 @@ int main(int argc, char **argv)
     // Scan for build directives (e.g. //> link: -lm)
     scan_build_directives(&ctx, src);
 
+    // Load and lex the import graph (and extra inputs) on worker threads while
+    // the parser works through it in order.
+    prefetch_source(g_config.input_file, src);
+    for (int ef = 0; ef < g_config.extra_file_count; ef++)
+    {
+        char *real_path = realpath(g_config.extra_files[ef], NULL);
+        const char *path = real_path ? real_path : g_config.extra_files[ef];
+        const char *ext = strrchr(path, '.');
+        if (!ext || !ZC_IS_BACKEND_EXT(ext))
+        {
+            prefetch_source(path, NULL);
+        }
+        if (real_path)
+        {
+            free(real_path);
+        }
+    }
+
     Lexer l;
-    lexer_init(&l, src);
+    if (!prefetch_take(g_config.input_file, &l))
+    {
+        lexer_init(&l, src);
+    }
 
     ctx.hoist_out = z_tmpfile();
     if (!ctx.hoist_out)
@@ -416,7 +1183,16 @@ int main(int argc, char **argv)
         fflush(stdout);
     }
 
+    // Per-phase regions. The AST and registries outlive the parse phase, so these
+    // are only released at exit; they exist to attribute memory in --mem-stats.
+    ZArena *parse_arena = arena_create("parse");
+    ZArena *analysis_arena = arena_create("analysis");
+    ZArena *codegen_arena = arena_create("codegen");
+    arena_use(parse_arena);
+
+    stats_phase_begin(PHASE_PARSE);
     ASTNode *root = parse_program(&ctx, &l);
+    stats_phase_end(PHASE_PARSE);
 
     if (!root)
     {
@@ -427,6 +1203,8 @@ int main(int argc, char **argv)
     // Parse extra input files and merge into AST
     if (g_config.extra_file_count > 0)
     {
+        stats_phase_begin(PHASE_PARSE_EXTRA);
+
         // Mark primary file as imported to prevent re-parsing
         char *primary_real = realpath(g_config.input_file, NULL);
         if (primary_real)
@@ -466,7 +1244,12 @@ int main(int argc, char **argv)
             }
             mark_file_imported(&ctx, path);
 
-            char *extra_src = load_file(path);
+            Lexer extra_l;
+            char *extra_src = prefetch_take(path, &extra_l);
+            if (!extra_src && (extra_src = load_file(path)) != NULL)
+            {
+                lexer_init(&extra_l, extra_src);
+            }
             if (!extra_src)
             {
                 fprintf(stderr,
@@ -486,8 +1269,6 @@ int main(int argc, char **argv)
 
             scan_build_directives(&ctx, extra_src);
 
-            Lexer extra_l;
-            lexer_init(&extra_l, extra_src);
             ASTNode *extra_root = parse_program_nodes(&ctx, &extra_l);
             g_current_filename = (char *)saved_fn;
 
@@ -506,9 +1287,18 @@ int main(int argc, char **argv)
                 free(real_path);
             }
         }
+
+        stats_phase_end(PHASE_PARSE_EXTRA);
     }
 
-    if (!validate_types(&ctx))
+    prefetch_finish();
+    g_stats.lambdas = ctx.lambda_counter;
+    arena_use(analysis_arena);
+
+    stats_phase_begin(PHASE_VALIDATE);
+    int types_ok = validate_types(&ctx);
+    stats_phase_end(PHASE_VALIDATE);
+    if (!types_ok)
     {
         // Type validation failed
         return 1;
@@ -516,7 +1306,9 @@ int main(int argc, char **argv)
 
     if (!g_config.use_typecheck && !g_config.mode_check)
     {
+        stats_phase_begin(PHASE_MOVE_CHECK);
         int move_result = check_moves_only(&ctx, root);
+        stats_phase_end(PHASE_MOVE_CHECK);
         if (move_result != 0)
         {
             return 1;
@@ -527,7 +1319,9 @@ int main(int argc, char **argv)
     int tc_result = 0;
     if (g_config.use_typecheck || g_config.mode_check)
     {
+        stats_phase_begin(PHASE_TYPECHECK);
         tc_result = check_program(&ctx, root);
+        stats_phase_end(PHASE_TYPECHECK);
         if (tc_result != 0 && !g_config.mode_check)
         {
             return 1; // Stop if type errors found
@@ -560,16 +1354,58 @@ int main(int argc, char **argv)
         temp_source_file = "out.m";
     }
 
-    // Codegen to C/C++/CUDA
-    FILE *out = fopen(temp_source_file, "w");
+    char extra_c_sources[4096] = {0};
+    for (int i = 0; i < g_config.c_file_count; i++)
+    {
+        strcat(extra_c_sources, " ");
+        strcat(extra_c_sources, g_config.c_files[i]);
+        build_cache_note_path(g_config.c_files[i]);
+    }
+
+    stats_phase_begin(PHASE_BACKEND);
+    const char *pch_header = g_config.mode_transpile ? NULL : precompile_preamble(&ctx, root);
+    ctx.preamble_pch = pch_header != NULL;
+    stats_phase_end(PHASE_BACKEND);
+
+    // Files that --emit-c does not keep get a per-process name, so concurrent
+    // builds in one directory do not overwrite each other's.
+    int units = g_config.mode_transpile ? 0 : split_unit_count();
+    char stem[64] = "out";
+    char temp_path[80];
+    if (!g_config.emit_c)
+    {
+        snprintf(stem, sizeof(stem), "out_%d", z_get_pid());
+        snprintf(temp_path, sizeof(temp_path), "%s%s", stem, strrchr(temp_source_file, '.'));
+        temp_source_file = temp_path;
+    }
+
+    // Codegen to C/C++/CUDA, straight into the C compiler when possible.
+    char cmd[32768];
+    ZProcess cc_proc;
+    FILE *out = NULL;
+    if (units <= 1)
+    {
+        out = start_streamed_compile(&cc_proc, cmd, sizeof(cmd), outfile, pch_header,
+                                     extra_c_sources);
+    }
+    int streamed = out != NULL;
+    if (!out)
+    {
+        out = fopen(temp_source_file, "w");
+    }
     if (!out)
     {
         perror("fopen temp output");
         return 1;
     }
 
+    arena_use(codegen_arena);
+    stats_phase_begin(PHASE_CODEGEN);
     codegen_node(&ctx, root, out);
+    g_stats.output_bytes = streamed ? 0 : ftell(out);
     fclose(out);
+    stats_phase_end(PHASE_CODEGEN);
+    arena_use(arena_global());
 
     if (g_config.mode_transpile)
     {
@@ -596,92 +1432,52 @@ int main(int argc, char **argv)
             }
         }
         // Done, no C compilation
-        return 0;
+        return build_cache_write_depfile(g_config.output_file ? g_config.output_file
+                                                              : temp_source_file) != 0;
     }
 
     // Compile C
-    char cmd[32768];
-    char *outfile = g_config.output_file ? g_config.output_file : "a.out";
-
-    char extra_c_sources[4096] = {0};
-    for (int i = 0; i < g_config.c_file_count; i++)
+    stats_phase_begin(PHASE_BACKEND);
+    int ret;
+    if (streamed)
     {
-        strcat(extra_c_sources, " ");
-        strcat(extra_c_sources, g_config.c_files[i]);
+        cc_proc.in = -1; // Closed with `out`.
+        ret = z_wait(&cc_proc);
     }
-
-    // Build command
-    build_compile_command(cmd, sizeof(cmd), outfile, temp_source_file, extra_c_sources);
-
-    if (g_config.verbose)
+    else if (units > 1 && (units = codegen_split_units(temp_source_file, stem, units)) > 0)
     {
-        printf(COLOR_BOLD COLOR_BLUE "     Command" COLOR_RESET " %s\n", cmd);
+        ret = compile_split_units(outfile, stem, units, pch_header, extra_c_sources);
     }
-
-    int ret = system(cmd);
-    if (ret != 0)
+    else
     {
-        fprintf(stderr, COLOR_BOLD COLOR_RED "error" COLOR_RESET ": C compilation failed\n");
-        if (!g_config.emit_c)
+        // Build command
+        char inputs[2048];
+        backend_inputs(inputs, sizeof(inputs), pch_header, temp_source_file);
+        build_compile_command(cmd, sizeof(cmd), outfile, inputs, extra_c_sources);
+
+        if (g_config.verbose)
         {
-            remove(temp_source_file);
+            printf(COLOR_BOLD COLOR_BLUE "     Command" COLOR_RESET " %s\n", cmd);
         }
-        return 1;
-    }
 
-    if (!g_config.emit_c)
+        ret = run_command(cmd, 0);
+    }
+    stats_phase_end(PHASE_BACKEND);
+    if (!streamed && !g_config.emit_c)
     {
         remove(temp_source_file);
     }
-
-    if (g_config.mode_run)
+    if (ret != 0)
     {
-        char run_cmd[2048];
-        if (z_is_windows())
-        {
-            sprintf(run_cmd, "%s", outfile);
-        }
-        else
-        {
-            sprintf(run_cmd, "./%s", outfile);
-        }
-        if (!g_config.quiet)
-        {
-            printf(COLOR_BOLD COLOR_GREEN "     Running" COLOR_RESET " %s\n", outfile);
-            fflush(stdout);
-        }
-        ret = system(run_cmd);
-        remove(outfile);
-        zptr_plugin_mgr_cleanup();
-        zen_trigger_global();
-#if defined(WIFEXITED) && defined(WEXITSTATUS)
-        return WIFEXITED(ret) ? WEXITSTATUS(ret) : ret;
-#else
-        return ret;
-#endif
+        fprintf(stderr, COLOR_BOLD COLOR_RED "error" COLOR_RESET ": C compilation failed\n");
+        return 1;
     }
 
-    zptr_plugin_mgr_cleanup();
-    zen_trigger_global();
-
-    double end_time = z_get_monotonic_time();
-    double time_taken = end_time - start_time;
-
-    if (!g_config.quiet && !g_config.mode_run && !g_config.mode_check)
+    // Warnings are not replayed on a hit, so only clean builds are stored.
+    if (g_warning_count == 0)
     {
-        if (g_warning_count > 0)
-        {
-            printf(COLOR_BOLD COLOR_GREEN "    Finished" COLOR_RESET
-                                          " build in %.2fs with %d warning%s\n",
-                   time_taken, g_warning_count, g_warning_count == 1 ? "" : "s");
-        }
-        else
-        {
-            printf(COLOR_BOLD COLOR_GREEN "    Finished" COLOR_RESET " build in %.2fs\n",
-                   time_taken);
-        }
-        fflush(stdout);
+        build_cache_store(outfile);
     }
 
-    return 0;
+    return finish_build(outfile, start_time);
 }
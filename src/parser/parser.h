@@ -47,17 +47,19 @@ extern ParserContext *g_parser_ctx;
  */
 typedef struct ZenSymbol
 {
-    char *name;             ///< Symbol name.
-    char *type_name;        ///< String representation of the type.
-    Type *type_info;        ///< Formal type definition.
-    int is_used;            ///< 1 if the symbol has been referenced.
-    int is_autofree;        ///< 1 if it requires automatic memory management (RAII).
-    Token decl_token;       ///< Token where the symbol was declared.
-    int is_const_value;     ///< 1 if it is a compile-time constant.
-    int is_def;             ///< 1 if it is a definition (vs declaration).
-    int const_int_val;      ///< Integer value if it is a constant.
-    int is_moved;           ///< 1 if the value has been moved (ownership transfer).
-    struct ZenSymbol *next; ///< Next symbol in the bucket/list (chaining).
+    InternedStr name;           ///< Symbol name (interned).
+    char *type_name;            ///< String representation of the type.
+    Type *type_info;            ///< Formal type definition.
+    int is_used;                ///< 1 if the symbol has been referenced.
+    int is_autofree;            ///< 1 if it requires automatic memory management (RAII).
+    Token decl_token;           ///< Token where the symbol was declared.
+    int is_const_value;         ///< 1 if it is a compile-time constant.
+    int is_def;                 ///< 1 if it is a definition (vs declaration).
+    int const_int_val;          ///< Integer value if it is a constant.
+    int is_moved;               ///< 1 if the value has been moved (ownership transfer).
+    int depth;                  ///< Depth of the declaring scope (0 = global).
+    struct ZenSymbol *shadowed; ///< Outer binding of the same name hidden by this one.
+    struct ZenSymbol *next;     ///< Next symbol declared in the same scope.
 } ZenSymbol;
 
 /**
@@ -69,6 +71,7 @@ typedef struct Scope
 {
     ZenSymbol *symbols;   ///< Linked list of symbols in this scope.
     struct Scope *parent; ///< Pointer to the parent scope (NULL for global).
+    int depth;            ///< Nesting depth (0 = global).
 } Scope;
 
 /**
@@ -78,7 +81,7 @@ typedef struct Scope
  */
 typedef struct FuncSig
 {
-    char *name;           ///< Function name.
+    InternedStr name;     ///< Function name (interned).
     Token decl_token;     ///< declaration token.
     int total_args;       ///< Total argument count.
     char **defaults;      ///< Default values for arguments (or NULL).
@@ -145,11 +148,11 @@ typedef struct ImportedFile
  */
 typedef struct Instantiation
 {
-    char *name;           ///< Mangled name of the instantiation (e.g. "Vec_int").
-    char *template_name;  ///< Original template name (e.g. "Vec").
-    char *concrete_arg;   ///< Concrete type argument string.
-    char *unmangled_arg;  ///< Unmangled argument for substitution code.
-    ASTNode *struct_node; ///< The AST node of the instantiated struct.
+    InternedStr name;          ///< Mangled name of the instantiation (e.g. "Vec_int").
+    InternedStr template_name; ///< Original template name (e.g. "Vec").
+    char *concrete_arg;        ///< Concrete type argument string.
+    char *unmangled_arg;       ///< Unmangled argument for substitution code.
+    ASTNode *struct_node;      ///< The AST node of the instantiated struct.
     struct Instantiation *next;
 } Instantiation;
 
@@ -167,7 +170,7 @@ typedef struct StructRef
  */
 typedef struct StructDef
 {
-    char *name;
+    InternedStr name;
     ASTNode *node;
     struct StructDef *next;
 } StructDef;
@@ -195,9 +198,9 @@ typedef struct TupleType
  */
 typedef struct EnumVariantReg
 {
-    char *enum_name;    ///< Name of the enum.
-    char *variant_name; ///< Name of the variant.
-    int tag_id;         ///< Integration tag value.
+    InternedStr enum_name;    ///< Name of the enum.
+    InternedStr variant_name; ///< Name of the variant.
+    int tag_id;               ///< Integration tag value.
     struct EnumVariantReg *next;
 } EnumVariantReg;
 
@@ -239,8 +242,8 @@ typedef struct SelectiveImport
  */
 typedef struct ImplReg
 {
-    char *trait; ///< Trait name.
-    char *strct; ///< Implementing struct name.
+    InternedStr trait; ///< Trait name.
+    InternedStr strct; ///< Implementing struct name.
     struct ImplReg *next;
 } ImplReg;
 
@@ -271,11 +274,17 @@ typedef struct TypeAlias
  *
  * ParserContext maintains the state of the compiler during parsing and analysis.
  * It holds symbol tables, type definitions, function registries, and configuration.
+ *
+ * Registries are linked lists, newest first, which codegen walks in order. The
+ * ones looked up by name have an InternMap index beside them that resolves a
+ * name to the same entry a scan of the list would find first.
  */
 struct ParserContext
 {
     Scope *current_scope;   ///< Current lexical scope for variable lookup.
+    InternMap scope_index;  ///< Innermost visible symbol per name (see ZenSymbol.shadowed).
     FuncSig *func_registry; ///< Registry of declared function signatures.
+    InternMap func_index;   ///< Newest FuncSig per name.
 
     // Lambdas
     LambdaRef *global_lambdas; ///< List of all lambdas generated during parsing.
@@ -287,40 +296,56 @@ struct ParserContext
         *known_generics[MAX_KNOWN_GENERICS]; ///< Stack of currently active generic type parameters.
     int known_generics_count;                ///< Count of active generic parameters.
     GenericTemplate *templates;              ///< Struct generic templates.
+    InternMap template_index;                ///< Newest GenericTemplate per name.
     GenericFuncTemplate *func_templates;     ///< Function generic templates.
+    InternMap func_template_index;           ///< Newest GenericFuncTemplate per name.
     GenericImplTemplate *impl_templates;     ///< Implementation block templates.
 
     // Instantiations
-    Instantiation *instantiations; ///< Cache of instantiated generic types.
-    ASTNode *instantiated_structs; ///< List of AST nodes for instantiated structs.
-    ASTNode *instantiated_funcs;   ///< List of AST nodes for instantiated functions.
+    Instantiation *instantiations;       ///< Cache of instantiated generic types.
+    InternMap instantiation_index;       ///< Instantiation per mangled name.
+    ASTNode *instantiated_structs;       ///< List of AST nodes for instantiated structs.
+    InternMap instantiated_struct_index; ///< Newest NODE_STRUCT in instantiated_structs per name.
+    ASTNode *instantiated_funcs;         ///< List of AST nodes for instantiated functions.
+    InternedStr *generic_uses;           ///< Mangled name per instantiated `Tpl<Args>` type ID.
+    int generic_use_cap;                 ///< Length of generic_uses.
 
     // Structs/Enums
     StructRef *parsed_structs_list; ///< List of all parsed struct nodes.
+    InternMap parsed_struct_index;  ///< Newest parsed struct node per name.
     StructRef *parsed_enums_list;   ///< List of all parsed enum nodes.
+    InternMap parsed_enum_index;    ///< Newest parsed enum node per name.
     StructRef *parsed_funcs_list;   ///< List of all parsed function nodes.
     StructRef *parsed_impls_list;   ///< List of all parsed impl blocks.
     StructRef *parsed_globals_list; ///< List of all parsed global variables.
     StructDef *struct_defs;         ///< Registry of struct definitions (map name -> node).
+    InternMap struct_def_index;     ///< Newest StructDef per name.
     EnumVariantReg *enum_variants;  ///< Registry of enum variants for global lookup.
+    InternMap enum_variant_index;   ///< Newest EnumVariantReg per variant name.
     ImplReg *registered_impls;      ///< Cache of type/trait implementations.
+    InternMap impl_index;           ///< ImplReg per "Trait:Struct" key.
 
     // Types
-    SliceType *used_slices;  ///< Cache of generated slice types.
-    TupleType *used_tuples;  ///< Cache of generated tuple types.
-    TypeAlias *type_aliases; ///< Defined type aliases.
+    SliceType *used_slices;     ///< Cache of generated slice types.
+    InternMap slice_index;      ///< SliceType per element type.
+    TupleType *used_tuples;     ///< Cache of generated tuple types.
+    TypeAlias *type_aliases;    ///< Defined type aliases.
+    InternMap type_alias_index; ///< Newest TypeAlias per alias.
 
     // Modules/Imports
     Module *modules;                    ///< List of registered modules.
+    InternMap module_index;             ///< Newest aliased Module per alias.
     SelectiveImport *selective_imports; ///< Symbols imported via `import { ... }`.
     char *current_module_prefix;        ///< Prefix for current module (namespacing).
     ImportedFile *imported_files;       ///< List of files already included/imported.
+    InternMap imported_file_index;      ///< ImportedFile per path.
     ImportedPlugin *imported_plugins;   ///< List of active plugins.
 
     // Config/State
     char *current_impl_struct;     ///< Name of struct currently being implemented (in impl block).
     ASTNode *current_impl_methods; ///< Head of method list for current impl block.
     int in_method_with_self;       ///< 1 if parsing body of method with self parameter.
+    int self_type_uses;            ///< Uses of Self parsed outside an impl block.
     int self_is_pointer;           ///< 1 if self is a pointer receiver (self*).
 
     // Internal tracking
@@ -331,17 +356,19 @@ struct ParserContext
     void *error_callback_data; ///< User data for error callback.
     void (*on_error)(void *data, Token t, const char *msg); ///< Callback for reporting errors.
 
-    // LSP: Flat symbol list (persists after parsing for LSP queries)
-    ZenSymbol *all_symbols; ///< comprehensive list of all symbols seen.
+    // LSP: Symbol index (persists after parsing for LSP queries)
+    InternMap all_symbols; ///< Most recent declaration per name, kept after scope exit.
 
     // External C interop: suppress undefined warnings for external symbols
     int has_external_includes; ///< Set when `#include <...>` is used.
     char **extern_symbols;     ///< Explicitly declared extern symbols.
     int extern_symbol_count;   ///< Count of external symbols.
+    InternMap extern_index;    ///< Each name in extern_symbols (big C headers declare many).
 
     // Codegen state:
     FILE *hoist_out;    ///< File stream for hoisting code (e.g. from plugins).
     int skip_preamble;  ///< If 1, codegen won't emit standard preamble (includes etc).
+    int preamble_pch;   ///< If 1, the preamble declarations come from a precompiled header.
     int is_repl;        ///< 1 if running in REPL mode.
     int has_async;      ///< 1 if async/await features are used in the program.
     int in_defer_block; ///< 1 if currently parsing inside a defer block.
@@ -381,6 +408,11 @@ int validate_types(ParserContext *ctx);
  */
 char *token_strdup(Token t);
 
+/**
+ * @brief Interned text of a token (reuses the lexer's handle for identifiers).
+ */
+InternedStr token_intern(Token t);
+
 /**
  * @brief Checks if a token matches a string.
  */
@@ -581,6 +613,11 @@ int check_impl(ParserContext *ctx, const char *trait, const char *strct);
  */
 void register_template(ParserContext *ctx, const char *name, ASTNode *node);
 
+/**
+ * @brief Finds a struct/enum generic template by name.
+ */
+GenericTemplate *find_template(ParserContext *ctx, const char *name);
+
 /**
  * @brief Registers a deprecated function.
  */
@@ -744,8 +781,9 @@ Module *find_module(ParserContext *ctx, const char *alias);
 
 /**
  * @brief Registers a module.
+ * @return The new module, so callers can fill in the remaining fields.
  */
-void register_module(ParserContext *ctx, const char *alias, const char *path);
+Module *register_module(ParserContext *ctx, const char *alias, const char *path);
 
 /**
  * @brief Registers a selective import.
@@ -1015,6 +1053,41 @@ ASTNode *parse_include(ParserContext *ctx, Lexer *l);
  */
 ASTNode *parse_import(ParserContext *ctx, Lexer *l);
 
+/**
+ * @brief Resolves an import path as written in `from_file` to the file to load.
+ */
+char *resolve_import_path(const char *name, const char *from_file);
+
+/**
+ * @brief Starts loading and lexing `path` and everything it imports on worker threads.
+ *
+ * `src` is the already loaded source of `path`, or NULL. Does nothing when
+ * only one job is allowed (see CompilerConfig::jobs).
+ */
+void prefetch_source(const char *path, char *src);
+
+/**
+ * @brief Takes the prefetched source of `path`, waiting for it if needed.
+ * @return The source with `*l` set to a lexer over it, or NULL if `path` was
+ *         not prefetched or could not be read.
+ */
+char *prefetch_take(const char *path, Lexer *l);
+
+/**
+ * @brief Loads and lexes `path` and everything it imports, and keeps them for
+ * builds forked from this process (zc watch).
+ *
+ * Calling it again reloads only the files that changed since they were read.
+ * Kept files are recorded as inputs by the build that takes them. No worker
+ * threads are left running on return.
+ */
+void prefetch_keep(const char *path);
+
+/**
+ * @brief Stops the prefetch workers.
+ */
+void prefetch_finish(void);
+
 /**
  * @brief Parses a comptime statement.
  */
@@ -18,7 +18,7 @@ ASTNode *parse_function(ParserContext *ctx, Lexer *l, int is_async)
 {
     lexer_next(l); // eat 'fn'
     Token name_tok = lexer_next(l);
-    char *name = token_strdup(name_tok);
+    char *name = token_intern(name_tok);
 
     if (is_async)
     {
@@ -388,7 +388,7 @@ ASTNode *parse_var_decl(ParserContext *ctx, Lexer *l)
 
     // Normal Declaration OR Named Struct Destructuring
     Token name_tok = lexer_next(l);
-    char *name = token_strdup(name_tok);
+    char *name = token_intern(name_tok);
 
     // Check for Struct Destructuring: var Point { x, y }
     if (lexer_peek(l).type == TOK_LBRACE)
@@ -612,7 +612,7 @@ ASTNode *parse_var_decl(ParserContext *ctx, Lexer *l)
                 type_obj = type_new(init->type_info->kind);
                 if (init->type_info->name)
                 {
-                    type_obj->name = xstrdup(init->type_info->name);
+                    type_obj->name = intern(init->type_info->name);
                 }
                 if (init->type_info->inner)
                 {
@@ -661,7 +661,7 @@ ASTNode *parse_var_decl(ParserContext *ctx, Lexer *l)
             {
                 type = xstrdup(init->struct_init.struct_name);
                 type_obj = type_new(TYPE_STRUCT);
-                type_obj->name = xstrdup(type);
+                type_obj->name = intern(type);
             }
         }
     }
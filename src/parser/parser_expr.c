@@ -692,47 +692,14 @@ void analyze_lambda_captures(ParserContext *ctx, ASTNode *lambda)
             continue;
         }
 
-        FuncSig *fs = ctx->func_registry;
-        int is_func = 0;
-        while (fs)
-        {
-            if (0 == strcmp(fs->name, var_name))
-            {
-                is_func = 1;
-                break;
-            }
-            fs = fs->next;
-        }
-        if (is_func)
+        if (intern_map_get(&ctx->func_index, var_name))
         {
             continue;
         }
 
-        Scope *s = ctx->current_scope;
-        int is_local = 0;
-        int is_found = 0;
-        while (s)
-        {
-            ZenSymbol *cur = s->symbols;
-            while (cur)
-            {
-                if (0 == strcmp(cur->name, var_name))
-                {
-                    is_found = 1;
-                    if (s->parent != NULL)
-                    {
-                        is_local = 1;
-                    }
-                    break;
-                }
-                cur = cur->next;
-            }
-            if (is_found)
-            {
-                break;
-            }
-            s = s->parent;
-        }
+        ZenSymbol *sym = find_symbol_entry(ctx, var_name);
+        int is_found = sym != NULL;
+        int is_local = sym && sym->depth > 0;
 
         if (is_found && !is_local)
         {
@@ -850,7 +817,7 @@ ASTNode *parse_lambda(ParserContext *ctx, Lexer *l)
             zpanic_at(name_tok, "Expected parameter name");
         }
 
-        param_names[num_params] = token_strdup(name_tok);
+        param_names[num_params] = token_intern(name_tok);
 
         if (lexer_peek(l).type != TOK_COLON)
         {
@@ -1390,9 +1357,7 @@ static ASTNode *parse_sizeof_expr(ParserContext *ctx, Lexer *l)
     }
     lexer_next(l);
 
-    int pos = l->pos;
-    int col = l->col;
-    int line = l->line;
+    int mark = lexer_mark(l);
     Type *ty = parse_type_formal(ctx, l);
 
     ASTNode *node;
@@ -1407,9 +1372,7 @@ static ASTNode *parse_sizeof_expr(ParserContext *ctx, Lexer *l)
     }
     else
     {
-        l->pos = pos;
-        l->col = col;
-        l->line = line;
+        lexer_rewind(l, mark);
         ASTNode *ex = parse_expression(ctx, l);
         if (lexer_next(l).type != TOK_RPAREN)
         {
@@ -1432,9 +1395,7 @@ static ASTNode *parse_typeof_expr(ParserContext *ctx, Lexer *l)
     }
     lexer_next(l);
 
-    int pos = l->pos;
-    int col = l->col;
-    int line = l->line;
+    int mark = lexer_mark(l);
     Type *ty = parse_type_formal(ctx, l);
 
     ASTNode *node;
@@ -1448,9 +1409,7 @@ static ASTNode *parse_typeof_expr(ParserContext *ctx, Lexer *l)
     }
     else
     {
-        l->pos = pos;
-        l->col = col;
-        l->line = line;
+        lexer_rewind(l, mark);
         ASTNode *ex = parse_expression(ctx, l);
         if (lexer_next(l).type != TOK_RPAREN)
         {
@@ -1527,18 +1486,18 @@ ASTNode *parse_primary(ParserContext *ctx, Lexer *l)
             Type *inner_type = type_new(TYPE_STRUCT);
             if (ctx->current_impl_struct)
             {
-                inner_type->name = xstrdup(ctx->current_impl_struct);
+                inner_type->name = intern(ctx->current_impl_struct);
             }
             else
             {
-                inner_type->name = xstrdup("Self");
+                inner_type->name = intern("Self");
             }
             self_node->type_info = type_new_ptr(inner_type);
             self_node->resolved_type = xstrdup("Self*");
 
             node = ast_create(NODE_EXPR_MEMBER);
             node->member.target = self_node;
-            node->member.field = token_strdup(member_tok);
+            node->member.field = token_intern(member_tok);
             node->member.is_pointer_access = 1;
             node->token = dot_tok;
 
@@ -1552,6 +1511,7 @@ ASTNode *parse_primary(ParserContext *ctx, Lexer *l)
         }
     }
 
+    int start_mark = lexer_mark(l);
     Token t = lexer_next(l);
 
     // ** Prefixes **
@@ -1809,12 +1769,11 @@ ASTNode *parse_primary(ParserContext *ctx, Lexer *l)
         if (t.len == 2 && strncmp(t.start, "fn", 2) == 0 &&
             (lexer_peek(l).type == TOK_LPAREN || lexer_peek(l).type == TOK_LBRACKET))
         {
-            l->pos -= t.len;
-            l->col -= t.len;
+            lexer_rewind(l, start_mark);
             return parse_lambda(ctx, l);
         }
 
-        char *ident = token_strdup(t);
+        char *ident = token_intern(t);
 
         if (lexer_peek(l).type == TOK_OP && lexer_peek(l).start[0] == '!' && lexer_peek(l).len == 1)
         {
@@ -2127,27 +2086,28 @@ ASTNode *parse_primary(ParserContext *ctx, Lexer *l)
 
             if (lexer_peek(l).type == TOK_LANGLE)
             {
-                Lexer lookahead = *l;
-                lexer_next(&lookahead);
+                int spec_mark = lexer_mark(l);
+                lexer_next(l);
 
                 int valid_generic = 0;
                 int saved_speculative = ctx->is_speculative;
                 ctx->is_speculative = 1;
                 while (1)
                 {
-                    parse_type(ctx, &lookahead);
-                    if (lexer_peek(&lookahead).type == TOK_COMMA)
+                    parse_type(ctx, l);
+                    if (lexer_peek(l).type == TOK_COMMA)
                     {
-                        lexer_next(&lookahead);
+                        lexer_next(l);
                         continue;
                     }
-                    if (lexer_peek(&lookahead).type == TOK_RANGLE)
+                    if (lexer_peek(l).type == TOK_RANGLE)
                     {
                         valid_generic = 1;
                     }
                     break;
                 }
                 ctx->is_speculative = saved_speculative;
+                lexer_rewind(l, spec_mark);
 
                 if (valid_generic)
                 {
@@ -2173,17 +2133,7 @@ ASTNode *parse_primary(ParserContext *ctx, Lexer *l)
                     }
                     lexer_next(l); // eat >
 
-                    int is_struct = 0;
-                    GenericTemplate *st = ctx->templates;
-                    while (st)
-                    {
-                        if (strcmp(st->name, acc) == 0)
-                        {
-                            is_struct = 1;
-                            break;
-                        }
-                        st = st->next;
-                    }
+                    int is_struct = find_template(ctx, acc) != NULL;
                     if (!is_struct && (strcmp(acc, "Result") == 0 || strcmp(acc, "Option") == 0))
                     {
                         is_struct = 1;
@@ -2451,7 +2401,7 @@ ASTNode *parse_primary(ParserContext *ctx, Lexer *l)
                 node = ast_create(NODE_EXPR_STRUCT_INIT);
                 node->struct_init.struct_name = struct_name;
                 Type *init_type = type_new(TYPE_STRUCT);
-                init_type->name = xstrdup(struct_name);
+                init_type->name = intern(struct_name);
                 node->type_info = init_type;
 
                 ASTNode *head = NULL, *tail = NULL;
@@ -2489,14 +2439,10 @@ ASTNode *parse_primary(ParserContext *ctx, Lexer *l)
                 lexer_next(l);
                 node->struct_init.fields = head;
 
-                GenericTemplate *gtpl = ctx->templates;
-                while (gtpl)
+                GenericTemplate *gtpl = find_template(ctx, acc);
+                if (!gtpl)
                 {
-                    if (strcmp(gtpl->name, acc) == 0 || strcmp(gtpl->name, struct_name) == 0)
-                    {
-                        break;
-                    }
-                    gtpl = gtpl->next;
+                    gtpl = find_template(ctx, struct_name);
                 }
                 if (gtpl && gtpl->struct_node && gtpl->struct_node->type == NODE_STRUCT)
                 {
@@ -2600,7 +2546,7 @@ ASTNode *parse_primary(ParserContext *ctx, Lexer *l)
                 }
 
                 Type *st = type_new(TYPE_STRUCT);
-                st->name = xstrdup(struct_name);
+                st->name = intern(struct_name);
                 node->type_info = st;
                 return node;
             }
@@ -2805,7 +2751,7 @@ ASTNode *parse_primary(ParserContext *ctx, Lexer *l)
                                             init->struct_init.struct_name = xstrdup(expected->name);
 
                                             Type *trait_type = type_new(TYPE_STRUCT);
-                                            trait_type->name = xstrdup(expected->name);
+                                            trait_type->name = intern(expected->name);
                                             init->type_info = trait_type;
 
                                             // Field: self
@@ -2850,7 +2796,7 @@ ASTNode *parse_primary(ParserContext *ctx, Lexer *l)
                                     init->struct_init.struct_name = xstrdup(expected->name);
 
                                     Type *trait_type = type_new(TYPE_STRUCT);
-                                    trait_type->name = xstrdup(expected->name);
+                                    trait_type->name = intern(expected->name);
                                     init->type_info = trait_type;
 
                                     // Field: self
@@ -2946,7 +2892,7 @@ ASTNode *parse_primary(ParserContext *ctx, Lexer *l)
                                         init->struct_init.struct_name = xstrdup(expected->name);
 
                                         Type *trait_type = type_new(TYPE_STRUCT);
-                                        trait_type->name = xstrdup(expected->name);
+                                        trait_type->name = intern(expected->name);
                                         init->type_info = trait_type;
 
                                         ASTNode *f_self = ast_create(NODE_VAR_DECL);
@@ -2985,7 +2931,7 @@ ASTNode *parse_primary(ParserContext *ctx, Lexer *l)
                                 init->struct_init.struct_name = xstrdup(expected->name);
 
                                 Type *trait_type = type_new(TYPE_STRUCT);
-                                trait_type->name = xstrdup(expected->name);
+                                trait_type->name = intern(expected->name);
                                 init->type_info = trait_type;
 
                                 ASTNode *f_self = ast_create(NODE_VAR_DECL);
@@ -3051,7 +2997,7 @@ ASTNode *parse_primary(ParserContext *ctx, Lexer *l)
             if (sig->is_async)
             {
                 Type *async_type = type_new(TYPE_STRUCT);
-                async_type->name = xstrdup("Async");
+                async_type->name = intern("Async");
                 node->type_info = async_type;
 
                 if (sig->ret_type)
@@ -3062,7 +3008,7 @@ ASTNode *parse_primary(ParserContext *ctx, Lexer *l)
                         char buf[512];
                         snprintf(buf, 511, "Async<%s>", inner);
                         node->resolved_type = xstrdup(buf);
-                        async_type->name = xstrdup(buf); // HACK: Persist generic info in name
+                        async_type->name = intern(buf); // HACK: Persist generic info in name
                         free(inner);
                     }
                     else
@@ -3382,7 +3328,7 @@ ASTNode *parse_primary(ParserContext *ctx, Lexer *l)
             return parse_arrow_lambda_multi(ctx, l, params, nparams, 0);
         }
 
-        int saved = l->pos;
+        int saved = lexer_mark(l);
         if (lexer_peek(l).type == TOK_IDENT)
         {
             Lexer cast_look = *l;
@@ -3434,7 +3380,7 @@ ASTNode *parse_primary(ParserContext *ctx, Lexer *l)
                 }
             }
         }
-        l->pos = saved; // Reset if not a cast
+        lexer_rewind(l, saved); // Reset if not a cast
 
         ASTNode *expr = parse_expression(ctx, l);
 
@@ -3535,7 +3481,7 @@ ASTNode *parse_primary(ParserContext *ctx, Lexer *l)
 
             // Set type info
             Type *tuple_type = type_new(TYPE_STRUCT);
-            tuple_type->name = xstrdup(tuple_name);
+            tuple_type->name = intern(tuple_name);
             node->type_info = tuple_type;
 
             // Cleanup
@@ -4569,7 +4515,7 @@ ASTNode *parse_expr_prec(ParserContext *ctx, Lexer *l, Precedence min_prec)
                                 else
                                 {
                                     lhs->type_info = type_new(TYPE_STRUCT);
-                                    lhs->type_info->name = xstrdup(inner_type);
+                                    lhs->type_info->name = intern(inner_type);
                                 }
                                 goto await_done;
                             }
@@ -4854,7 +4800,7 @@ ASTNode *parse_expr_prec(ParserContext *ctx, Lexer *l, Precedence min_prec)
             ASTNode *node = ast_create(NODE_EXPR_MEMBER);
             node->token = field;
             node->member.target = lhs;
-            node->member.field = token_strdup(field);
+            node->member.field = token_intern(field);
             node->member.is_pointer_access = 1;
 
             // Opaque Check
@@ -4908,7 +4854,7 @@ ASTNode *parse_expr_prec(ParserContext *ctx, Lexer *l, Precedence min_prec)
             ASTNode *node = ast_create(NODE_EXPR_MEMBER);
             node->token = field;
             node->member.target = lhs;
-            node->member.field = token_strdup(field);
+            node->member.field = token_intern(field);
             node->member.is_pointer_access = 2;
 
             // Opaque Check
@@ -5686,7 +5632,7 @@ ASTNode *parse_expr_prec(ParserContext *ctx, Lexer *l, Precedence min_prec)
             ASTNode *node = ast_create(NODE_EXPR_MEMBER);
             node->token = field;
             node->member.target = lhs;
-            node->member.field = token_strdup(field);
+            node->member.field = token_intern(field);
             node->member.is_pointer_access = 0;
 
             // Opaque Check
@@ -5713,7 +5659,7 @@ ASTNode *parse_expr_prec(ParserContext *ctx, Lexer *l, Precedence min_prec)
                 }
             }
 
-            node->member.field = token_strdup(field);
+            node->member.field = token_intern(field);
             node->member.is_pointer_access = 0;
 
             if (lhs->type_info && lhs->type_info->kind == TYPE_POINTER)
@@ -5824,7 +5770,7 @@ ASTNode *parse_expr_prec(ParserContext *ctx, Lexer *l, Precedence min_prec)
                         // It is a method! Create a Function Type Info to carry the return
                         // type
                         Type *ft = type_new(TYPE_FUNCTION);
-                        ft->name = xstrdup(mangled);
+                        ft->name = intern(mangled);
                         ft->inner = sig->ret_type; // Return type
                         node->type_info = ft;
                     }
@@ -5843,8 +5789,8 @@ ASTNode *parse_expr_prec(ParserContext *ctx, Lexer *l, Precedence min_prec)
             // Handle Generic Method Call: object.method<T>
             if (lexer_peek(l).type == TOK_LANGLE)
             {
-                Lexer lookahead = *l;
-                lexer_next(&lookahead);
+                int spec_mark = lexer_mark(l);
+                lexer_next(l);
 
                 int valid_generic = 0;
                 int saved = ctx->is_speculative;
@@ -5853,19 +5799,20 @@ ASTNode *parse_expr_prec(ParserContext *ctx, Lexer *l, Precedence min_prec)
                 // Speculatively check if it's a valid generic list
                 while (1)
                 {
-                    parse_type(ctx, &lookahead);
-                    if (lexer_peek(&lookahead).type == TOK_COMMA)
+                    parse_type(ctx, l);
+                    if (lexer_peek(l).type == TOK_COMMA)
                     {
-                        lexer_next(&lookahead);
+                        lexer_next(l);
                         continue;
                     }
-                    if (lexer_peek(&lookahead).type == TOK_RANGLE)
+                    if (lexer_peek(l).type == TOK_RANGLE)
                     {
                         valid_generic = 1;
                     }
                     break;
                 }
                 ctx->is_speculative = saved;
+                lexer_rewind(l, spec_mark);
 
                 if (valid_generic)
                 {
@@ -5962,7 +5909,7 @@ ASTNode *parse_expr_prec(ParserContext *ctx, Lexer *l, Precedence min_prec)
 
                             // Update Type Info
                             Type *ft = type_new(TYPE_FUNCTION);
-                            ft->name = xstrdup(mn);
+                            ft->name = intern(mn);
                             // Look up return type from instantiated func
                             FuncSig *isig = find_func(ctx, mn);
                             if (isig)
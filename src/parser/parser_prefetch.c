@@ -0,0 +1,216 @@
+
+#include "../platform/os.h"
+#include "../utils/build_cache.h"
+#include "../utils/threadpool.h"
+#include "parser.h"
+
+// Import prefetching. The import graph is walked ahead of the parser on a
+// worker pool that loads and lexes every module, so the parser thread only
+// parses. Parsing itself stays on one thread: it instantiates generics and
+// registers symbols in the shared ParserContext as it goes. Files are still
+// parsed, and their declarations merged, in source order, so the output does
+// not depend on how the workers were scheduled.
+//
+// `zc watch` keeps the import graph loaded and lexed between builds
+// (prefetch_keep). Each build is a fork of the watcher and takes these
+// copies as they are; they are recorded as inputs of the build when taken.
+
+typedef struct
+{
+    InternedStr path; ///< Resolved path, as parse_import computes it.
+    char *src;        ///< Source text (NULL if the file could not be read).
+    Lexer lexer;      ///< Lexer at the start of `src`, with all tokens scanned.
+    atomic_int done;  ///< Set (last) by the worker once `src` and `lexer` are ready.
+    int kept;         ///< 1 if loaded by prefetch_keep (not yet recorded by the build).
+    size_t len;       ///< Length of `src` (kept files).
+    long long mtime;  ///< Modification time before the file was read (kept files).
+    long long size;   ///< Size before the file was read (kept files).
+} PrefetchedFile;
+
+static ZThreadPool *prefetch_pool = NULL;
+static int prefetch_disabled = 0;
+static int prefetch_keeping = 0; // Inside prefetch_keep.
+static InternMap prefetched; // Resolved path -> PrefetchedFile.
+static atomic_flag prefetch_lock = ATOMIC_FLAG_INIT;
+
+static void prefetch_acquire(void)
+{
+    while (atomic_flag_test_and_set_explicit(&prefetch_lock, memory_order_acquire))
+    {
+    }
+}
+
+static void prefetch_release(void)
+{
+    atomic_flag_clear_explicit(&prefetch_lock, memory_order_release);
+}
+
+static void prefetch_job(void *arg);
+
+// Queue `path` unless it was queued before.
+static void prefetch_submit(const char *path, char *src)
+{
+    InternedStr key = intern(path);
+    PrefetchedFile *f = NULL;
+
+    prefetch_acquire();
+    void **slot = intern_map_slot(&prefetched, key);
+    if (!*slot)
+    {
+        f = xcalloc(1, sizeof(PrefetchedFile));
+        f->path = key;
+        f->src = src;
+        *slot = f;
+    }
+    prefetch_release();
+
+    if (f)
+    {
+        thread_pool_submit(prefetch_pool, prefetch_job, f);
+    }
+}
+
+// Queue the modules `f` imports, resolved the way parse_import will.
+static void prefetch_imports(PrefetchedFile *f)
+{
+    Lexer l = f->lexer;
+    Token t;
+    while ((t = lexer_next(&l)).type != TOK_EOF)
+    {
+        if (t.type != TOK_IDENT || t.len != 6 || strncmp(t.start, "import", 6) != 0)
+        {
+            continue;
+        }
+
+        Token name = lexer_next(&l);
+        if (name.type == TOK_LBRACE)
+        {
+            // import { a, b as c } from "file"
+            while (name.type != TOK_RBRACE && name.type != TOK_EOF)
+            {
+                name = lexer_next(&l);
+            }
+            lexer_next(&l); // from
+            name = lexer_next(&l);
+        }
+        if (name.type != TOK_STRING || name.len < 2)
+        {
+            continue;
+        }
+
+        char *fn = xmalloc(name.len - 1);
+        strncpy(fn, name.start + 1, name.len - 2);
+        fn[name.len - 2] = 0;
+
+        size_t len = strlen(fn);
+        if (len > 2 && strcmp(fn + len - 2, ".h") == 0)
+        {
+            continue; // C headers are included, not parsed.
+        }
+        prefetch_submit(resolve_import_path(fn, f->path), NULL);
+    }
+}
+
+static void prefetch_job(void *arg)
+{
+    PrefetchedFile *f = arg;
+    if (prefetch_keeping)
+    {
+        // Stamp first: a write during the read then shows up as a change.
+        f->kept = z_file_stamp(f->path, &f->mtime, &f->size) == 0;
+        f->src = f->kept ? load_file_untracked(f->path, &f->len) : NULL;
+    }
+    else if (!f->src)
+    {
+        f->src = load_file(f->path);
+    }
+    if (f->src)
+    {
+        lexer_init(&f->lexer, f->src);
+        lexer_prelex(&f->lexer);
+        prefetch_imports(f);
+    }
+    atomic_store_explicit(&f->done, 1, memory_order_release);
+}
+
+void prefetch_source(const char *path, char *src)
+{
+    if (!prefetch_pool && !prefetch_disabled)
+    {
+        int jobs = g_config.jobs > 0 ? g_config.jobs : thread_pool_default_size();
+        prefetch_pool = jobs > 1 ? thread_pool_create(jobs) : NULL;
+        prefetch_disabled = !prefetch_pool;
+    }
+    if (prefetch_pool)
+    {
+        prefetch_submit(path, src);
+    }
+}
+
+char *prefetch_take(const char *path, Lexer *l)
+{
+    if (!prefetch_pool && prefetched.count == 0)
+    {
+        return NULL;
+    }
+
+    InternedStr key = intern_find(path);
+    if (!key)
+    {
+        return NULL;
+    }
+    prefetch_acquire();
+    PrefetchedFile *f = intern_map_get(&prefetched, key);
+    prefetch_release();
+    if (!f)
+    {
+        return NULL;
+    }
+
+    thread_pool_wait_flag(prefetch_pool, &f->done);
+    if (!f->src)
+    {
+        return NULL;
+    }
+    if (f->kept)
+    {
+        build_cache_note_file(f->path, f->src, f->len);
+    }
+    *l = f->lexer;
+    return f->src;
+}
+
+void prefetch_keep(const char *path)
+{
+    // Drop the files that changed since they were read and queue them again:
+    // they are reloaded, with any imports they gained, and the rest is kept.
+    InternedStr *stale = xmalloc(sizeof(InternedStr) * (prefetched.cap + 1));
+    int stale_count = 0;
+    for (int i = 0; i < prefetched.cap; i++)
+    {
+        PrefetchedFile *f = prefetched.slots[i].value;
+        long long mtime;
+        long long size;
+        if (f && (!f->src || z_file_stamp(f->path, &mtime, &size) != 0 || mtime != f->mtime ||
+                  size != f->size))
+        {
+            prefetched.slots[i].value = NULL;
+            stale[stale_count++] = f->path;
+        }
+    }
+
+    prefetch_keeping = 1;
+    prefetch_source(path, NULL);
+    for (int i = 0; i < stale_count && prefetch_pool; i++)
+    {
+        prefetch_submit(stale[i], NULL);
+    }
+    prefetch_finish(); // No worker threads may be running when the caller forks.
+    prefetch_keeping = 0;
+}
+
+void prefetch_finish(void)
+{
+    thread_pool_destroy(prefetch_pool);
+    prefetch_pool = NULL;
+}
@@ -26,14 +26,9 @@ extern char *g_current_filename;
 static void auto_import_std_slice(ParserContext *ctx)
 {
     // Check if already imported via templates
-    GenericTemplate *t = ctx->templates;
-    while (t)
+    if (find_template(ctx, "Slice"))
     {
-        if (strcmp(t->name, "Slice") == 0)
-        {
-            return; // Already have the Slice template
-        }
-        t = t->next;
+        return; // Already have the Slice template
     }
 
     // Try to find and import std/slice.zc
@@ -1189,7 +1184,7 @@ ASTNode *parse_for(ParserContext *ctx, Lexer *l)
     // Range Loop: for i in 0..10
     if (lexer_peek(l).type == TOK_IDENT)
     {
-        int saved_pos = l->pos;
+        int saved_pos = lexer_mark(l);
         Token var = lexer_next(l);
         Token in_tok = lexer_next(l);
 
@@ -1548,7 +1543,7 @@ ASTNode *parse_for(ParserContext *ctx, Lexer *l)
                 return outer_block;
             }
         }
-        l->pos = saved_pos; // Restore
+        lexer_rewind(l, saved_pos); // Restore
     }
 
     // C-Style For Loop
@@ -3001,7 +2996,8 @@ ASTNode *parse_block(ParserContext *ctx, Lexer *l)
     return b;
 }
 
-void try_parse_c_function_decl(ParserContext *ctx, const char *line)
+// Name declared by a C function prototype on `line`, or NULL.
+static char *c_function_decl_name(const char *line)
 {
     const char *p = line;
     while (*p && isspace(*p))
@@ -3012,34 +3008,34 @@ void try_parse_c_function_decl(ParserContext *ctx, const char *line)
     // Skip lines we don't want to parse as function declarations
     if (*p == '#' || *p == '/' || *p == '*' || *p == '\0')
     {
-        return;
+        return NULL;
     }
     if (strncmp(p, "typedef", 7) == 0 && !isalnum(p[7]) && p[7] != '_')
     {
-        return;
+        return NULL;
     }
     if (strncmp(p, "static", 6) == 0 && !isalnum(p[6]) && p[6] != '_')
     {
-        return;
+        return NULL;
     }
     if (strncmp(p, "struct", 6) == 0 && !isalnum(p[6]) && p[6] != '_')
     {
-        return;
+        return NULL;
     }
     if (strncmp(p, "union", 5) == 0 && !isalnum(p[5]) && p[5] != '_')
     {
-        return;
+        return NULL;
     }
     if (strncmp(p, "enum", 4) == 0 && !isalnum(p[4]) && p[4] != '_')
     {
-        return;
+        return NULL;
     }
 
     // Must contain '(' and end with ';' (prototype, not definition body)
     const char *lparen = strchr(p, '(');
     if (!lparen)
     {
-        return;
+        return NULL;
     }
 
     // Check that the line ends with ';' (skip trailing whitespace)
@@ -3050,13 +3046,13 @@ void try_parse_c_function_decl(ParserContext *ctx, const char *line)
     }
     if (*end != ';')
     {
-        return; // Likely a function definition (has body) or multi-line
+        return NULL; // Likely a function definition (has body) or multi-line
     }
 
     // Must not contain '{' — that would be a function body
     if (strchr(p, '{'))
     {
-        return;
+        return NULL;
     }
 
     // Walk backwards from '(' to find the function name
@@ -3076,7 +3072,7 @@ void try_parse_c_function_decl(ParserContext *ctx, const char *line)
     int name_len = (int)(name_end - name_start);
     if (name_len <= 0)
     {
-        return;
+        return NULL;
     }
 
     // Reject names that are C keywords commonly seen in headers
@@ -3085,25 +3081,33 @@ void try_parse_c_function_decl(ParserContext *ctx, const char *line)
         (name_len == 3 && strncmp(name_start, "for", 3) == 0) ||
         (name_len == 5 && strncmp(name_start, "while", 5) == 0))
     {
-        return;
+        return NULL;
     }
 
     // There must be a return type before the name (at least one identifier/keyword)
     if (name_start == p)
     {
-        return; // No return type
+        return NULL; // No return type
     }
 
     char *name = xmalloc(name_len + 1);
     strncpy(name, name_start, name_len);
     name[name_len] = '\0';
+    return name;
+}
 
-    register_extern_symbol(ctx, name);
-    free(name);
+void try_parse_c_function_decl(ParserContext *ctx, const char *line)
+{
+    char *name = c_function_decl_name(line);
+    if (name)
+    {
+        register_extern_symbol(ctx, name);
+        free(name);
+    }
 }
 
 /**
- * @brief Try to parse a C struct/union declaration from a header line.
+ * @brief Find a C struct/union declaration in a header line.
  *
  * Detects patterns like:
  *   - typedef struct <tag> { ... (open brace on same line)
@@ -3111,10 +3115,9 @@ void try_parse_c_function_decl(ParserContext *ctx, const char *line)
  *   - struct <name> {
  *   - } <name>;  (closing typedef)
  *
- * Registers detected names as opaque type aliases so Zen C code can
- * reference them (e.g. as pointer types) without needing raw {} blocks.
+ * @return 1 with `*name` and the C type it names (`*c_type`) set, or 0.
  */
-void try_parse_c_struct_decl(ParserContext *ctx, const char *line)
+static int c_struct_decl(const char *line, char **name, char **c_type)
 {
     const char *p = line;
     while (*p && isspace(*p))
@@ -3124,7 +3127,7 @@ void try_parse_c_struct_decl(ParserContext *ctx, const char *line)
 
     if (*p == '#' || *p == '/' || *p == '*' || *p == '\0')
     {
-        return;
+        return 0;
     }
 
     int is_typedef = 0;
@@ -3153,7 +3156,7 @@ void try_parse_c_struct_decl(ParserContext *ctx, const char *line)
     }
     else if (is_typedef)
     {
-        return; // typedef of something else (e.g. typedef int foo_t;)
+        return 0; // typedef of something else (e.g. typedef int foo_t;)
     }
     else
     {
@@ -3178,15 +3181,14 @@ void try_parse_c_struct_decl(ParserContext *ctx, const char *line)
             }
             if (name_len > 0 && *p == ';')
             {
-                char *name = xmalloc(name_len + 1);
-                strncpy(name, name_start, name_len);
-                name[name_len] = '\0';
-                register_type_alias(ctx, name, name, 1, NULL);
-                register_extern_symbol(ctx, name);
-                free(name);
+                *name = xmalloc(name_len + 1);
+                strncpy(*name, name_start, name_len);
+                (*name)[name_len] = '\0';
+                *c_type = *name;
+                return 1;
             }
         }
-        return;
+        return 0;
     }
 
     // Skip whitespace after struct/union keyword
@@ -3205,35 +3207,130 @@ void try_parse_c_struct_decl(ParserContext *ctx, const char *line)
 
     if (tag_len <= 0)
     {
-        return; // Anonymous struct/union
+        return 0; // Anonymous struct/union
     }
 
-    // Register the tag name as an opaque type
-    char *tag_name = xmalloc(tag_len + 1);
-    strncpy(tag_name, tag_start, tag_len);
-    tag_name[tag_len] = '\0';
-
     // Skip whitespace
     while (*p && isspace(*p))
     {
         p++;
     }
 
-    // Only register if this looks like a real declaration (has '{' or ';')
-    if (*p == '{' || *p == ';')
+    // Only register if this looks like a real declaration (has '{' or ';').
+    // If typedef, the alias after '}' is found on a later line.
+    if (*p != '{' && *p != ';')
+    {
+        return 0;
+    }
+    const char *c_keyword = is_union ? "union" : "struct";
+    *name = xmalloc(tag_len + 1);
+    strncpy(*name, tag_start, tag_len);
+    (*name)[tag_len] = '\0';
+    *c_type = xmalloc(strlen(c_keyword) + 1 + tag_len + 1);
+    sprintf(*c_type, "%s %s", c_keyword, *name);
+    return 1;
+}
+
+/**
+ * @brief Try to parse a C struct/union declaration from a header line.
+ *
+ * Registers detected names as opaque type aliases so Zen C code can
+ * reference them (e.g. as pointer types) without needing raw {} blocks.
+ */
+void try_parse_c_struct_decl(ParserContext *ctx, const char *line)
+{
+    char *name;
+    char *c_type;
+    if (c_struct_decl(line, &name, &c_type))
     {
-        const char *c_keyword = is_union ? "union" : "struct";
-        char *c_type = xmalloc(strlen(c_keyword) + 1 + tag_len + 1);
-        sprintf(c_type, "%s %s", c_keyword, tag_name);
-        register_type_alias(ctx, tag_name, c_type, 1, NULL);
-        register_extern_symbol(ctx, tag_name);
-        free(c_type);
+        register_type_alias(ctx, name, c_type, 1, NULL);
+        register_extern_symbol(ctx, name);
     }
+}
 
-    // If typedef: also check for alias after '}'
-    // (handled by the '}' branch on subsequent lines)
+/**
+ * @brief The declarations found in one C header, kept in the build cache.
+ *
+ * Each record is a kind byte followed by NUL-terminated fields: 'D' and a
+ * #define line, 'F' and a function name, 'T' and a type name with the C type
+ * it names, or 'I' and the path of a nested header.
+ */
+typedef struct
+{
+    char *data;
+    size_t len;
+    size_t cap;
+} CHeaderScan;
 
-    free(tag_name);
+static void header_scan_record(CHeaderScan *scan, char kind, const char *a, const char *b)
+{
+    size_t a_len = strlen(a) + 1;
+    size_t b_len = b ? strlen(b) + 1 : 0;
+    size_t need = scan->len + 1 + a_len + b_len;
+    if (need > scan->cap)
+    {
+        scan->cap = need > scan->cap * 2 ? need : scan->cap * 2;
+        scan->data = xrealloc(scan->data, scan->cap);
+    }
+    scan->data[scan->len++] = kind;
+    memcpy(scan->data + scan->len, a, a_len);
+    scan->len += a_len;
+    if (b)
+    {
+        memcpy(scan->data + scan->len, b, b_len);
+        scan->len += b_len;
+    }
+}
+
+// Register one declaration, found by a scan or replayed from the cache.
+static void header_scan_apply(ParserContext *ctx, char kind, const char *a, const char *b,
+                              int depth)
+{
+    switch (kind)
+    {
+    case 'D':
+        try_parse_macro_const(ctx, a);
+        break;
+    case 'F':
+        register_extern_symbol(ctx, a);
+        break;
+    case 'T':
+        register_type_alias(ctx, a, b, 1, NULL);
+        register_extern_symbol(ctx, a);
+        break;
+    case 'I':
+        scan_c_header_contents(ctx, a, depth + 1);
+        break;
+    }
+}
+
+static void header_scan_replay(ParserContext *ctx, const char *data, size_t len, int depth)
+{
+    const char *p = data;
+    const char *end = data + len;
+    while (p < end)
+    {
+        char kind = *p++;
+        const char *a = p;
+        const char *a_end = memchr(a, 0, end - a);
+        if (!a_end)
+        {
+            return;
+        }
+        const char *b = NULL;
+        p = a_end + 1;
+        if (kind == 'T')
+        {
+            const char *b_end = memchr(p, 0, end - p);
+            if (!b_end)
+            {
+                return;
+            }
+            b = p;
+            p = b_end + 1;
+        }
+        header_scan_apply(ctx, kind, a, b, depth);
+    }
 }
 
 /**
@@ -3246,7 +3343,9 @@ void try_parse_c_struct_decl(ParserContext *ctx, const char *line)
  *   - Nested #include "..." directives (recursively scanned)
  *
  * System includes (#include <...>) are skipped.
- * Already-scanned files are tracked to prevent infinite cycles.
+ * Already-scanned files are tracked to prevent infinite cycles. The
+ * declarations found are stored in the build cache by path and contents,
+ * so an unchanged header is not scanned again.
  *
  * @param ctx     Parser context
  * @param path    Path to the header file
@@ -3270,8 +3369,21 @@ void scan_c_header_contents(ParserContext *ctx, const char *path, int depth)
     char *src = load_file(path);
     if (!src)
     {
+        // The backend compiler may still find it (e.g. through -I), unseen by the cache.
+        build_cache_disable("local C header not found");
+        return;
+    }
+
+    size_t cached_len = 0;
+    char *cached = build_cache_header_scan(path, src, &cached_len);
+    if (cached)
+    {
+        header_scan_replay(ctx, cached, cached_len, depth);
+        free(cached);
+        free(src);
         return;
     }
+    CHeaderScan scan = {0};
 
     // Compute directory of the current header for resolving relative includes
     char header_dir[1024];
@@ -3322,15 +3434,18 @@ void scan_c_header_contents(ParserContext *ctx, const char *path, int depth)
             }
             if (*p == '#')
             {
-                try_parse_macro_const(ctx, line_buf);
-
-                // Check for nested #include "..." directives
+                // Check for #define constants and nested #include "..." directives
                 const char *inc = p + 1;
                 while (*inc && isspace(*inc))
                 {
                     inc++;
                 }
-                if (strncmp(inc, "include", 7) == 0 && !isalnum(inc[7]) && inc[7] != '_')
+                if (strncmp(inc, "define", 6) == 0)
+                {
+                    header_scan_record(&scan, 'D', line_buf, NULL);
+                    header_scan_apply(ctx, 'D', line_buf, NULL, depth);
+                }
+                else if (strncmp(inc, "include", 7) == 0 && !isalnum(inc[7]) && inc[7] != '_')
                 {
                     inc += 7;
                     while (*inc && isspace(*inc))
@@ -3364,15 +3479,26 @@ void scan_c_header_contents(ParserContext *ctx, const char *path, int depth)
                             }
 
                             // Recursively scan the nested header
-                            scan_c_header_contents(ctx, nested_path, depth + 1);
+                            header_scan_record(&scan, 'I', nested_path, NULL);
+                            header_scan_apply(ctx, 'I', nested_path, NULL, depth);
                         }
                     }
                 }
             }
             else
             {
-                try_parse_c_function_decl(ctx, line_buf);
-                try_parse_c_struct_decl(ctx, line_buf);
+                char *name = c_function_decl_name(line_buf);
+                if (name)
+                {
+                    header_scan_record(&scan, 'F', name, NULL);
+                    header_scan_apply(ctx, 'F', name, NULL, depth);
+                }
+                char *c_type;
+                if (c_struct_decl(line_buf, &name, &c_type))
+                {
+                    header_scan_record(&scan, 'T', name, c_type);
+                    header_scan_apply(ctx, 'T', name, c_type, depth);
+                }
             }
             free(line_buf);
         }
@@ -3383,6 +3509,8 @@ void scan_c_header_contents(ParserContext *ctx, const char *path, int depth)
             ptr++;
         }
     }
+    build_cache_store_header_scan(path, src, scan.data ? scan.data : "", scan.len);
+    free(scan.data);
     free(src);
 }
 
@@ -3434,6 +3562,89 @@ ASTNode *parse_include(ParserContext *ctx, Lexer *l)
 
     return n;
 }
+
+char *resolve_import_path(const char *name, const char *from_file)
+{
+    char *fn = xstrdup(name);
+
+    // Resolve paths relative to current file
+    char resolved_path[1024];
+    int is_explicit_relative = (fn[0] == '.' && (fn[1] == '/' || (fn[1] == '.' && fn[2] == '/')));
+
+    // Try to resolve relative to current file if not absolute
+    // On Windows, absolute paths can start with drive letter (C:\) or backslash
+    int is_abs = z_is_abs_path(fn);
+
+    if (!is_abs)
+    {
+        char *current_dir = xstrdup(from_file);
+        char *last_slash = z_path_last_sep(current_dir);
+
+        if (last_slash)
+        {
+            *last_slash = 0; // Truncate to directory
+
+            // Handles explicit relative AND implicit relative lookups
+            snprintf(resolved_path, sizeof(resolved_path), "%s/%s", current_dir, fn);
+
+            // If it's an explicit relative path, OR if the file exists at this relative location
+            if (is_explicit_relative || access(resolved_path, R_OK) == 0)
+            {
+                free(fn);
+                fn = xstrdup(resolved_path);
+            }
+        }
+        free(current_dir);
+    }
+
+    // Check if file exists, if not try system-wide paths
+    if (access(fn, R_OK) != 0)
+    {
+        // Try system-wide standard library location
+        const char *system_paths[] = {getenv("ZC_ROOT"), "/usr/local/share/zenc",
+                                      "/usr/share/zenc"};
+        size_t system_paths_count = sizeof(system_paths) / sizeof(*system_paths);
+
+        char system_path[1024];
+        int found = 0;
+
+        for (size_t i = 0; i < system_paths_count && !found; i++)
+        {
+            if (!system_paths[i])
+            {
+                continue;
+            }
+            snprintf(system_path, sizeof(system_path), "%s/%s", system_paths[i], fn);
+            if (access(system_path, R_OK) == 0)
+            {
+                free(fn);
+                fn = xstrdup(system_path);
+                found = 1;
+            }
+        }
+
+        if (!found)
+        {
+            // File not found anywhere - will error later when trying to open
+        }
+    }
+
+    // Canonicalize path to avoid duplicates (for example: "./std/io.zc" vs "std/io.zc")
+    // Only resolve if file exists! On Windows, realpath (_fullpath) resolves non-existent files to
+    // CWD.
+    if (access(fn, R_OK) == 0)
+    {
+        char *real_fn = realpath(fn, NULL);
+        if (real_fn)
+        {
+            free(fn);
+            fn = real_fn;
+        }
+    }
+
+    return fn;
+}
+
 ASTNode *parse_import(ParserContext *ctx, Lexer *l)
 {
     lexer_next(l); // eat 'import'
@@ -3579,80 +3790,9 @@ ASTNode *parse_import(ParserContext *ctx, Lexer *l)
     strncpy(fn, t.start + 1, ln);
     fn[ln] = 0;
 
-    // Resolve paths relative to current file
-    char resolved_path[1024];
-    int is_explicit_relative = (fn[0] == '.' && (fn[1] == '/' || (fn[1] == '.' && fn[2] == '/')));
-
-    // Try to resolve relative to current file if not absolute
-    // On Windows, absolute paths can start with drive letter (C:\) or backslash
-    int is_abs = z_is_abs_path(fn);
-
-    if (!is_abs)
-    {
-        char *current_dir = xstrdup(g_current_filename);
-        char *last_slash = z_path_last_sep(current_dir);
-
-        if (last_slash)
-        {
-            *last_slash = 0; // Truncate to directory
-
-            // Handles explicit relative AND implicit relative lookups
-            snprintf(resolved_path, sizeof(resolved_path), "%s/%s", current_dir, fn);
-
-            // If it's an explicit relative path, OR if the file exists at this relative location
-            if (is_explicit_relative || access(resolved_path, R_OK) == 0)
-            {
-                free(fn);
-                fn = xstrdup(resolved_path);
-            }
-        }
-        free(current_dir);
-    }
-
-    // Check if file exists, if not try system-wide paths
-    if (access(fn, R_OK) != 0)
-    {
-        // Try system-wide standard library location
-        const char *system_paths[] = {getenv("ZC_ROOT"), "/usr/local/share/zenc",
-                                      "/usr/share/zenc"};
-        size_t system_paths_count = sizeof(system_paths) / sizeof(*system_paths);
-
-        char system_path[1024];
-        int found = 0;
-
-        for (size_t i = 0; i < system_paths_count && !found; i++)
-        {
-            if (!system_paths[i])
-            {
-                continue;
-            }
-            snprintf(system_path, sizeof(system_path), "%s/%s", system_paths[i], fn);
-            if (access(system_path, R_OK) == 0)
-            {
-                free(fn);
-                fn = xstrdup(system_path);
-                found = 1;
-            }
-        }
-
-        if (!found)
-        {
-            // File not found anywhere - will error later when trying to open
-        }
-    }
-
-    // Canonicalize path to avoid duplicates (for example: "./std/io.zc" vs "std/io.zc")
-    // Only resolve if file exists! On Windows, realpath (_fullpath) resolves non-existent files to
-    // CWD.
-    if (access(fn, R_OK) == 0)
-    {
-        char *real_fn = realpath(fn, NULL);
-        if (real_fn)
-        {
-            free(fn);
-            fn = real_fn;
-        }
-    }
+    char *resolved = resolve_import_path(fn, g_current_filename);
+    free(fn);
+    fn = resolved;
 
     // Check if file already imported
     if (is_file_imported(ctx, fn))
@@ -3702,13 +3842,8 @@ ASTNode *parse_import(ParserContext *ctx, Lexer *l)
             }
 
             // Register the module
-            Module *m = xmalloc(sizeof(Module));
-            m->alias = xstrdup(alias);
-            m->path = xstrdup(fn);
-            m->base_name = extract_module_name(fn);
+            Module *m = register_module(ctx, alias, fn);
             m->is_c_header = is_header;
-            m->next = ctx->modules;
-            ctx->modules = m;
         }
     }
 
@@ -3721,10 +3856,12 @@ ASTNode *parse_import(ParserContext *ctx, Lexer *l)
         return n;
     }
 
-    // Load and parse the file
-    char *src = load_file(fn);
+    // Load and parse the file (already lexed if the prefetcher got to it)
+    Lexer i;
+    char *src = prefetch_take(fn, &i);
     if (!src)
     {
+        src = load_file(fn);
         if (!src)
         {
             if (g_config.mode_lsp)
@@ -3738,10 +3875,9 @@ ASTNode *parse_import(ParserContext *ctx, Lexer *l)
             }
             zpanic_at(t, "Not found: %s", fn);
         }
+        lexer_init(&i, src);
     }
-
-    Lexer i;
-    lexer_init(&i, src);
+    g_stats.modules++;
 
     // If this is a namespaced import or selective import, set the module prefix
     char *prev_module_prefix = ctx->current_module_prefix;
@@ -3806,6 +3942,7 @@ ASTNode *parse_import(ParserContext *ctx, Lexer *l)
 char *run_comptime_block(ParserContext *ctx, Lexer *l)
 {
     (void)ctx;
+    build_cache_disable("comptime block");
     expect(l, TOK_COMPTIME, "comptime");
     expect(l, TOK_LBRACE, "expected { after comptime");
 
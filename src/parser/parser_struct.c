@@ -208,8 +208,16 @@ ASTNode *parse_trait(ParserContext *ctx, Lexer *l)
         ASTNode **default_values = NULL;
         char **param_names = NULL;
         int is_varargs = 0;
+        int self_uses = ctx->self_type_uses;
         char *args = parse_and_convert_args(ctx, l, &defaults, &default_values, &arg_count,
                                             &arg_types, &param_names, &is_varargs, NULL);
+        if (ctx->self_type_uses != self_uses)
+        {
+            // A trait object erases the implementing type, so its dispatch wrapper has no
+            // type to pass for Self (or Self*, Vec<Self>, ...) in an argument.
+            zpanic_with_suggestion(mn, "Trait method arguments cannot use Self",
+                                   "Take a concrete type, or the trait itself, instead");
+        }
 
         char *ret = xstrdup("void");
         if (lexer_peek(l).type == TOK_ARROW)
@@ -593,7 +601,7 @@ ASTNode *parse_impl(ParserContext *ctx, Lexer *l)
                         strcmp(f->func.param_names[0], "self") == 0)
                     {
                         Type *t_struct = type_new(TYPE_STRUCT);
-                        t_struct->name = xstrdup(name1);
+                        t_struct->name = intern(name1);
                         t_struct->arg_count = 1;
                         t_struct->args = xmalloc(sizeof(Type *));
                         t_struct->args[0] = type_new(TYPE_GENERIC);
@@ -636,7 +644,7 @@ ASTNode *parse_impl(ParserContext *ctx, Lexer *l)
                             strcmp(f->func.param_names[0], "self") == 0)
                         {
                             Type *t_struct = type_new(TYPE_STRUCT);
-                            t_struct->name = xstrdup(name1);
+                            t_struct->name = intern(name1);
                             t_struct->arg_count = 1;
                             t_struct->args = xmalloc(sizeof(Type *));
                             t_struct->args[0] = type_new(TYPE_GENERIC);
@@ -889,7 +897,7 @@ ASTNode *parse_struct(ParserContext *ctx, Lexer *l, int is_union, int is_opaque)
                 expect(l, TOK_SEMICOLON, "Expected ;");
 
                 ASTNode *nf = ast_create(NODE_FIELD);
-                nf->field.name = token_strdup(field_name);
+                nf->field.name = token_intern(field_name);
                 nf->field.type = field_type_str;
                 nf->type_info = ft;
 
@@ -972,7 +980,7 @@ ASTNode *parse_struct(ParserContext *ctx, Lexer *l, int is_union, int is_opaque)
             char *f_type = type_to_c_string(ft);
 
             ASTNode *f = ast_create(NODE_FIELD);
-            f->field.name = token_strdup(f_name);
+            f->field.name = token_intern(f_name);
             f->field.type = f_type;
             f->type_info = ft;
             f->field.bit_width = 0;
@@ -1011,7 +1019,6 @@ ASTNode *parse_struct(ParserContext *ctx, Lexer *l, int is_union, int is_opaque)
     }
 
     ASTNode *node = ast_create(NODE_STRUCT);
-    add_to_struct_list(ctx, node);
 
     // Auto-prefix struct name if in module context
     if (ctx->current_module_prefix && gp_count == 0)
@@ -1023,10 +1030,11 @@ ASTNode *parse_struct(ParserContext *ctx, Lexer *l, int is_union, int is_opaque)
     }
 
     node->strct.name = name;
+    add_to_struct_list(ctx, node);
 
     // Initialize Type Info so we can track traits (like Drop)
     node->type_info = type_new(TYPE_STRUCT);
-    node->type_info->name = xstrdup(name);
+    node->type_info->name = intern(name);
     if (gp_count > 0)
     {
         node->type_info->kind = TYPE_GENERIC;
@@ -1159,7 +1167,7 @@ ASTNode *parse_enum(ParserContext *ctx, Lexer *l)
                     sprintf(tuple_name, "Tuple_%s", sig);
 
                     payload = type_new(TYPE_STRUCT);
-                    payload->name = tuple_name;
+                    payload->name = intern(tuple_name);
                 }
                 else
                 {
@@ -1188,7 +1196,7 @@ ASTNode *parse_enum(ParserContext *ctx, Lexer *l)
                 Type **at = xmalloc(sizeof(Type *));
                 at[0] = payload;
                 Type *ret_t = type_new(TYPE_ENUM);
-                ret_t->name = xstrdup(ename);
+                ret_t->name = intern(ename);
 
                 register_func(ctx, mangled, 1, NULL, at, ret_t, 0, 0, vt);
             }
@@ -1196,7 +1204,7 @@ ASTNode *parse_enum(ParserContext *ctx, Lexer *l)
             {
                 // No payload: fn Name() -> Enum
                 Type *ret_t = type_new(TYPE_ENUM);
-                ret_t->name = xstrdup(ename);
+                ret_t->name = intern(ename);
                 register_func(ctx, mangled, 0, NULL, NULL, ret_t, 0, 0, vt);
             }
 
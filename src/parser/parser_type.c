@@ -3,6 +3,89 @@
 #include "analysis/const_fold.h"
 #include "parser.h"
 
+// Mangled name of a generic use already instantiated in this context, if any.
+static InternedStr find_generic_use(ParserContext *ctx, Type *use)
+{
+    return use->id < ctx->generic_use_cap ? ctx->generic_uses[use->id] : NULL;
+}
+
+static void remember_generic_use(ParserContext *ctx, Type *use, InternedStr mangled)
+{
+    if (use->id >= ctx->generic_use_cap)
+    {
+        int cap = ctx->generic_use_cap ? ctx->generic_use_cap : 256;
+        while (cap <= use->id)
+        {
+            cap *= 2;
+        }
+        ctx->generic_uses = xrealloc(ctx->generic_uses, sizeof(InternedStr) * cap);
+        memset(ctx->generic_uses + ctx->generic_use_cap, 0,
+               sizeof(InternedStr) * (cap - ctx->generic_use_cap));
+        ctx->generic_use_cap = cap;
+    }
+    ctx->generic_uses[use->id] = mangled;
+}
+
+static int is_known_generic_arg(ParserContext *ctx, const char *arg)
+{
+    for (int k = 0; k < ctx->known_generics_count; ++k)
+    {
+        if (strcmp(arg, ctx->known_generics[k]) == 0)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Instantiate `tpl<args>` unless an argument is a generic parameter in scope,
+// and return the mangled struct name.
+static InternedStr instantiate_generic_use(ParserContext *ctx, const char *tpl, Type **arg_types,
+                                           int arg_count, Token t)
+{
+    char mangled[256];
+
+    if (arg_count == 1)
+    {
+        char *arg = type_to_string(arg_types[0]);
+        if (!is_known_generic_arg(ctx, arg))
+        {
+            instantiate_generic(ctx, tpl, arg, arg, t);
+        }
+
+        char *clean_arg = sanitize_mangled_name(arg);
+        sprintf(mangled, "%s_%s", tpl, clean_arg);
+        free(clean_arg);
+        free(arg);
+        return intern(mangled);
+    }
+
+    char **args = xmalloc(sizeof(char *) * arg_count);
+    int is_generic_dep = 0;
+    for (int i = 0; i < arg_count; i++)
+    {
+        args[i] = type_to_string(arg_types[i]);
+        is_generic_dep |= is_known_generic_arg(ctx, args[i]);
+    }
+
+    if (!is_generic_dep)
+    {
+        instantiate_generic_multi(ctx, tpl, args, arg_count, t);
+    }
+
+    strcpy(mangled, tpl);
+    for (int i = 0; i < arg_count; i++)
+    {
+        char *clean = sanitize_mangled_name(args[i]);
+        strcat(mangled, "_");
+        strcat(mangled, clean);
+        free(clean);
+        free(args[i]);
+    }
+    free(args);
+    return intern(mangled);
+}
+
 Type *parse_type_base(ParserContext *ctx, Lexer *l)
 {
     Token t = lexer_peek(l);
@@ -41,7 +124,7 @@ Type *parse_type_base(ParserContext *ctx, Lexer *l)
             {
                 Type *underlying = parse_type_formal(ctx, &tmp);
                 Type *wrapper = type_new(TYPE_ALIAS);
-                wrapper->name = xstrdup(alias_node->alias);
+                wrapper->name = intern(alias_node->alias);
                 wrapper->inner = underlying;
                 wrapper->alias.is_opaque_alias = 1;
                 wrapper->alias.alias_defined_in_file =
@@ -57,6 +140,10 @@ Type *parse_type_base(ParserContext *ctx, Lexer *l)
         {
             name = xstrdup(ctx->current_impl_struct);
         }
+        else if (strcmp(name, "Self") == 0)
+        {
+            ctx->self_type_uses++; // Counted for parse_trait (at any depth, e.g. Vec<Self>).
+        }
 
         // Handle Namespace :: (A::B -> A_B)
         while (lexer_peek(l).type == TOK_DCOLON)
@@ -515,7 +602,7 @@ Type *parse_type_base(ParserContext *ctx, Lexer *l)
         if (explicit_struct)
         {
             Type *ty = type_new(TYPE_STRUCT);
-            ty->name = name;
+            ty->name = intern(name);
             ty->is_explicit_struct = 1;
         }
 
@@ -551,7 +638,7 @@ Type *parse_type_base(ParserContext *ctx, Lexer *l)
         }
 
         Type *ty = type_new(TYPE_STRUCT);
-        ty->name = name;
+        ty->name = intern(name);
         ty->is_explicit_struct = explicit_struct;
 
         // Handle Generics <T> or <K, V>
@@ -559,127 +646,60 @@ Type *parse_type_base(ParserContext *ctx, Lexer *l)
             (lexer_peek(l).type == TOK_OP && strncmp(lexer_peek(l).start, "<", 1) == 0))
         {
             lexer_next(l); // eat <
-            Type *first_arg = parse_type_formal(ctx, l);
-            char *first_arg_str = type_to_string(first_arg);
-
-            // Check for multi-arg: <K, V>
-            Token next_tok = lexer_peek(l);
-            if (next_tok.type == TOK_COMMA)
+            Type **arg_types = xmalloc(sizeof(Type *) * 8);
+            int arg_count = 0;
+            arg_types[arg_count++] = parse_type_formal(ctx, l);
+            while (lexer_peek(l).type == TOK_COMMA)
             {
-                // Multi-arg case
-                char **args = xmalloc(sizeof(char *) * 8);
-                int arg_count = 0;
-                args[arg_count++] = xstrdup(first_arg_str);
-
-                while (lexer_peek(l).type == TOK_COMMA)
-                {
-                    lexer_next(l); // eat ,
-                    Type *arg = parse_type_formal(ctx, l);
-                    char *arg_str = type_to_string(arg);
-                    args = realloc(args, sizeof(char *) * (arg_count + 1));
-                    args[arg_count++] = xstrdup(arg_str);
-                    free(arg_str);
-                }
-
-                // Consume >
-                next_tok = lexer_peek(l);
-                if (next_tok.type == TOK_RANGLE)
+                lexer_next(l); // eat ,
+                if (arg_count % 8 == 0)
                 {
-                    lexer_next(l);
+                    arg_types = xrealloc(arg_types, sizeof(Type *) * (arg_count + 8));
                 }
-                else if (next_tok.type == TOK_OP && next_tok.len == 2 &&
-                         strncmp(next_tok.start, ">>", 2) == 0)
-                {
-                    l->pos += 1;
-                    l->col += 1;
-                }
-                else
-                {
-                    zpanic_at(t, "Expected > after generic");
-                }
-
-                // Call multi-arg instantiation
-                int is_generic_dep = 0;
-                for (int i = 0; i < arg_count; ++i)
-                {
-                    for (int k = 0; k < ctx->known_generics_count; ++k)
-                    {
-                        if (strcmp(args[i], ctx->known_generics[k]) == 0)
-                        {
-                            is_generic_dep = 1;
-                            break;
-                        }
-                    }
-                }
-
-                if (!is_generic_dep)
-                {
-                    instantiate_generic_multi(ctx, name, args, arg_count, t);
-                }
-
-                // Build mangled name
-                char mangled[256];
-                strcpy(mangled, name);
-                for (int i = 0; i < arg_count; i++)
-                {
-                    char *clean = sanitize_mangled_name(args[i]);
-                    strcat(mangled, "_");
-                    strcat(mangled, clean);
-                    free(clean);
-                    free(args[i]);
-                }
-                free(args);
+                arg_types[arg_count++] = parse_type_formal(ctx, l);
+            }
 
-                free(ty->name);
-                ty->name = xstrdup(mangled);
+            Token next_tok = lexer_peek(l);
+            if (next_tok.type == TOK_RANGLE)
+            {
+                lexer_next(l); // Consume >
+            }
+            else if (next_tok.type == TOK_OP && next_tok.len == 2 &&
+                     strncmp(next_tok.start, ">>", 2) == 0)
+            {
+                // Split >> into two > tokens
+                lexer_split_rangle(l);
             }
             else
             {
-                // Single-arg case - PRESERVE ORIGINAL FLOW EXACTLY
-                if (next_tok.type == TOK_RANGLE)
-                {
-                    lexer_next(l); // Consume >
-                }
-                else if (next_tok.type == TOK_OP && next_tok.len == 2 &&
-                         strncmp(next_tok.start, ">>", 2) == 0)
-                {
-                    // Split >> into two > tokens
-                    l->pos += 1;
-                    l->col += 1;
-                }
-                else
-                {
-                    zpanic_at(t, "Expected > after generic");
-                }
-
-                char *unmangled_arg = type_to_string(first_arg);
-
-                int is_single_dep = 0;
-                for (int k = 0; k < ctx->known_generics_count; ++k)
-                {
-                    if (strcmp(first_arg_str, ctx->known_generics[k]) == 0)
-                    {
-                        is_single_dep = 1;
-                        break;
-                    }
-                }
+                zpanic_at(t, "Expected > after generic");
+            }
 
-                if (!is_single_dep)
+            // The mangled name depends only on the template and the argument
+            // types, so a repeated use is one lookup by canonical type ID.
+            Type use = {0};
+            use.kind = TYPE_GENERIC;
+            use.name = ty->name;
+            use.args = arg_types;
+            use.arg_count = arg_count;
+            Type *use_key = type_intern(&use);
+            InternedStr mangled = find_generic_use(ctx, use_key);
+
+            if (mangled)
+            {
+                g_stats.instance_reuses++;
+            }
+            else
+            {
+                mangled = instantiate_generic_use(ctx, name, arg_types, arg_count, t);
+                if (intern_map_get(&ctx->instantiation_index, mangled))
                 {
-                    instantiate_generic(ctx, name, first_arg_str, unmangled_arg, t);
+                    remember_generic_use(ctx, use_key, mangled);
                 }
-                free(unmangled_arg);
-
-                char *clean_arg = sanitize_mangled_name(first_arg_str);
-                char mangled[256];
-                sprintf(mangled, "%s_%s", name, clean_arg);
-                free(clean_arg);
-
-                free(ty->name);
-                ty->name = xstrdup(mangled);
             }
+            free(arg_types);
 
-            free(first_arg_str);
+            ty->name = mangled;
             ty->kind = TYPE_STRUCT;
             ty->args = NULL;
             ty->arg_count = 0;
@@ -771,7 +791,7 @@ Type *parse_type_base(ParserContext *ctx, Lexer *l)
         sprintf(tuple_name, "Tuple_%s", sig);
 
         Type *ty = type_new(TYPE_STRUCT);
-        ty->name = tuple_name;
+        ty->name = intern(tuple_name);
         return ty;
     }
 
@@ -783,7 +803,7 @@ Type *parse_type_base(ParserContext *ctx, Lexer *l)
         char *fallback = token_strdup(t);
         lexer_next(l);
         Type *ty = type_new(TYPE_STRUCT);
-        ty->name = fallback;
+        ty->name = intern(fallback);
         ty->is_explicit_struct = 0;
         return ty;
     }
@@ -1134,6 +1154,7 @@ ASTNode *parse_embed(ParserContext *ctx, Lexer *l)
     unsigned char *b = xmalloc(len);
     fread(b, 1, len, f);
     fclose(f);
+    build_cache_note_file(fn, (const char *)b, len);
 
     size_t oc = len * 6 + 256;
     char *o = xmalloc(oc);
@@ -1145,7 +1166,7 @@ ASTNode *parse_embed(ParserContext *ctx, Lexer *l)
         register_slice(ctx, "char");
 
         Type *slice_type = type_new(TYPE_STRUCT);
-        slice_type->name = xstrdup("Slice_char");
+        slice_type->name = intern("Slice_char");
         target_type = slice_type;
 
         sprintf(o, "(Slice_char){.data=(char[]){");
@@ -1171,7 +1192,7 @@ ASTNode *parse_embed(ParserContext *ctx, Lexer *l)
                 char slice_name[256];
                 sprintf(slice_name, "Slice_%s", inner_ts);
                 Type *slice_t = type_new(TYPE_STRUCT);
-                slice_t->name = xstrdup(slice_name);
+                slice_t->name = intern(slice_name);
                 target_type = slice_t;
                 sprintf(o, "(%s){.data=(%s[]){", slice_name, inner_ts);
             }
@@ -159,7 +159,7 @@ Token expect(Lexer *l, ZenTokenType type, const char *msg)
     if (t.type != type)
     {
         zpanic_at(t, "Expected %s, but got '%.*s'", msg, t.len, t.start);
-        return (Token){type, t.start, 0, t.line, t.col};
+        return (Token){type, 0, t.start, t.line, t.col, NULL};
     }
     return t;
 }
@@ -360,6 +360,11 @@ char *token_strdup(Token t)
     return s;
 }
 
+InternedStr token_intern(Token t)
+{
+    return t.ident ? t.ident : intern_n(t.start, t.len);
+}
+
 void skip_comments(Lexer *l)
 {
     while (lexer_peek(l).type == TOK_COMMENT)
@@ -438,6 +443,7 @@ void enter_scope(ParserContext *ctx)
     Scope *s = xmalloc(sizeof(Scope));
     s->symbols = 0;
     s->parent = ctx->current_scope;
+    s->depth = s->parent ? s->parent->depth + 1 : 0;
     ctx->current_scope = s;
 }
 
@@ -448,14 +454,12 @@ void exit_scope(ParserContext *ctx)
         return;
     }
 
-    // Check for unused variables
+    // Unbind this scope's symbols, uncovering what they shadowed. Each symbol is
+    // unbound exactly once, so this is constant time per declaration.
     ZenSymbol *sym = ctx->current_scope->symbols;
     while (sym)
     {
-        if (!sym->is_used && strcmp(sym->name, "self") != 0 && sym->name[0] != '_')
-        {
-            // Could emit warning here
-        }
+        intern_map_put(&ctx->scope_index, sym->name, sym->shadowed);
         sym = sym->next;
     }
 
@@ -475,90 +479,51 @@ void add_symbol_with_token(ParserContext *ctx, const char *n, const char *t, Typ
         enter_scope(ctx);
     }
 
+    InternedStr name = intern(n);
+    int depth = ctx->current_scope->depth;
+    ZenSymbol **slot = (ZenSymbol **)intern_map_slot(&ctx->scope_index, name);
+
     if (n[0] != '_' && ctx->current_scope->parent && strcmp(n, "it") != 0 && strcmp(n, "self") != 0)
     {
-        Scope *p = ctx->current_scope->parent;
-        while (p)
+        // Skip redeclarations in this scope; anything left is from a parent.
+        ZenSymbol *sh = *slot;
+        while (sh && sh->depth == depth)
         {
-            ZenSymbol *sh = p->symbols;
-            while (sh)
-            {
-                if (strcmp(sh->name, n) == 0)
-                {
-                    warn_shadowing(tok, n);
-                    break;
-                }
-                sh = sh->next;
-            }
-            if (sh)
-            {
-                break; // found it
-            }
-            p = p->parent;
+            sh = sh->shadowed;
+        }
+        if (sh)
+        {
+            warn_shadowing(tok, n);
         }
     }
     ZenSymbol *s = xmalloc(sizeof(ZenSymbol));
-    s->name = xstrdup(n);
+    s->name = name;
     s->type_name = t ? xstrdup(t) : NULL;
     s->type_info = type_info;
     s->is_used = 0;
     s->decl_token = tok;
     s->is_const_value = 0;
     s->is_moved = 0;
+    s->depth = depth;
+    s->shadowed = *slot;
     s->next = ctx->current_scope->symbols;
     ctx->current_scope->symbols = s;
+    *slot = s;
 
-    // LSP: Also add to flat list (for persistent access after scope exit)
-    ZenSymbol *lsp_copy = xmalloc(sizeof(ZenSymbol));
-    *lsp_copy = *s;
-    lsp_copy->next = ctx->all_symbols;
-    ctx->all_symbols = lsp_copy;
+    // LSP: Also index by name (for persistent access after scope exit)
+    intern_map_put(&ctx->all_symbols, name, s);
 }
 
 Type *find_symbol_type_info(ParserContext *ctx, const char *n)
 {
-    if (!ctx->current_scope)
-    {
-        return NULL;
-    }
-    Scope *s = ctx->current_scope;
-    while (s)
-    {
-        ZenSymbol *sym = s->symbols;
-        while (sym)
-        {
-            if (strcmp(sym->name, n) == 0)
-            {
-                return sym->type_info;
-            }
-            sym = sym->next;
-        }
-        s = s->parent;
-    }
-    return NULL;
+    ZenSymbol *sym = find_symbol_entry(ctx, n);
+    return sym ? sym->type_info : NULL;
 }
 
 char *find_symbol_type(ParserContext *ctx, const char *n)
 {
-    if (!ctx->current_scope)
-    {
-        return NULL;
-    }
-    Scope *s = ctx->current_scope;
-    while (s)
-    {
-        ZenSymbol *sym = s->symbols;
-        while (sym)
-        {
-            if (strcmp(sym->name, n) == 0)
-            {
-                return sym->type_name;
-            }
-            sym = sym->next;
-        }
-        s = s->parent;
-    }
-    return NULL;
+    ZenSymbol *sym = find_symbol_entry(ctx, n);
+    return sym ? sym->type_name : NULL;
 }
 
 ZenSymbol *find_symbol_entry(ParserContext *ctx, const char *n)
@@ -567,36 +532,13 @@ ZenSymbol *find_symbol_entry(ParserContext *ctx, const char *n)
     {
         return NULL;
     }
-    Scope *s = ctx->current_scope;
-    while (s)
-    {
-        ZenSymbol *sym = s->symbols;
-        while (sym)
-        {
-            if (strcmp(sym->name, n) == 0)
-            {
-                return sym;
-            }
-            sym = sym->next;
-        }
-        s = s->parent;
-    }
-    return NULL;
+    return intern_map_get(&ctx->scope_index, n);
 }
 
-// LSP: Search flat symbol list (works after scopes are destroyed).
+// LSP: Search the persistent index (works after scopes are destroyed).
 ZenSymbol *find_symbol_in_all(ParserContext *ctx, const char *n)
 {
-    ZenSymbol *sym = ctx->all_symbols;
-    while (sym)
-    {
-        if (strcmp(sym->name, n) == 0)
-        {
-            return sym;
-        }
-        sym = sym->next;
-    }
-    return NULL;
+    return intern_map_get(&ctx->all_symbols, n);
 }
 
 void init_builtins()
@@ -613,7 +555,7 @@ void register_func(ParserContext *ctx, const char *name, int count, char **defau
                    Type **arg_types, Type *ret_type, int is_varargs, int is_async, Token decl_token)
 {
     FuncSig *f = xmalloc(sizeof(FuncSig));
-    f->name = xstrdup(name);
+    f->name = intern(name);
     f->decl_token = decl_token;
     f->total_args = count;
     f->defaults = defaults;
@@ -624,6 +566,7 @@ void register_func(ParserContext *ctx, const char *name, int count, char **defau
     f->must_use = 0; // Default: can discard result
     f->next = ctx->func_registry;
     ctx->func_registry = f;
+    intern_map_put(&ctx->func_index, f->name, f);
 }
 
 void register_func_template(ParserContext *ctx, const char *name, const char *param, ASTNode *node)
@@ -634,6 +577,7 @@ void register_func_template(ParserContext *ctx, const char *name, const char *pa
     t->func_node = node;
     t->next = ctx->func_templates;
     ctx->func_templates = t;
+    intern_map_put(&ctx->func_template_index, intern(name), t);
 }
 
 void register_deprecated_func(ParserContext *ctx, const char *name, const char *reason)
@@ -661,16 +605,7 @@ DeprecatedFunc *find_deprecated_func(ParserContext *ctx, const char *name)
 
 GenericFuncTemplate *find_func_template(ParserContext *ctx, const char *name)
 {
-    GenericFuncTemplate *t = ctx->func_templates;
-    while (t)
-    {
-        if (strcmp(t->name, name) == 0)
-        {
-            return t;
-        }
-        t = t->next;
-    }
-    return NULL;
+    return intern_map_get(&ctx->func_template_index, name);
 }
 
 void register_generic(ParserContext *ctx, char *name)
@@ -708,10 +643,11 @@ void register_impl_template(ParserContext *ctx, const char *sname, const char *p
 
     // Late binding: Check if any existing instantiations match this new impl
     // template
-    Instantiation *inst = ctx->instantiations;
+    InternedStr key = intern_find(sname);
+    Instantiation *inst = key ? ctx->instantiations : NULL;
     while (inst)
     {
-        if (inst->template_name && strcmp(inst->template_name, sname) == 0)
+        if (inst->template_name == key)
         {
             instantiate_methods(ctx, t, inst->name, inst->concrete_arg, inst->unmangled_arg);
         }
@@ -725,6 +661,7 @@ void add_to_struct_list(ParserContext *ctx, ASTNode *node)
     r->node = node;
     r->next = ctx->parsed_structs_list;
     ctx->parsed_structs_list = r;
+    intern_map_put(&ctx->parsed_struct_index, intern(node->strct.name), node);
 }
 
 void register_type_alias(ParserContext *ctx, const char *alias, const char *original, int is_opaque,
@@ -737,6 +674,7 @@ void register_type_alias(ParserContext *ctx, const char *alias, const char *orig
     ta->defined_in_file = defined_in_file ? xstrdup(defined_in_file) : NULL;
     ta->next = ctx->type_aliases;
     ctx->type_aliases = ta;
+    intern_map_put(&ctx->type_alias_index, intern(alias), ta);
 }
 
 const char *find_type_alias(ParserContext *ctx, const char *alias)
@@ -747,17 +685,7 @@ const char *find_type_alias(ParserContext *ctx, const char *alias)
 
 TypeAlias *find_type_alias_node(ParserContext *ctx, const char *alias)
 {
-    TypeAlias *ta = ctx->type_aliases;
-    while (ta)
-    {
-        if (strcmp(ta->alias, alias) == 0)
-        {
-
-            return ta;
-        }
-        ta = ta->next;
-    }
-    return NULL;
+    return intern_map_get(&ctx->type_alias_index, alias);
 }
 
 void add_to_enum_list(ParserContext *ctx, ASTNode *node)
@@ -766,6 +694,7 @@ void add_to_enum_list(ParserContext *ctx, ASTNode *node)
     r->node = node;
     r->next = ctx->parsed_enums_list;
     ctx->parsed_enums_list = r;
+    intern_map_put(&ctx->parsed_enum_index, intern(node->enm.name), node);
 }
 
 void add_to_func_list(ParserContext *ctx, ASTNode *node)
@@ -850,25 +779,17 @@ void add_instantiated_func(ParserContext *ctx, ASTNode *fn)
 void register_enum_variant(ParserContext *ctx, const char *ename, const char *vname, int tag)
 {
     EnumVariantReg *r = xmalloc(sizeof(EnumVariantReg));
-    r->enum_name = xstrdup(ename);
-    r->variant_name = xstrdup(vname);
+    r->enum_name = intern(ename);
+    r->variant_name = intern(vname);
     r->tag_id = tag;
     r->next = ctx->enum_variants;
     ctx->enum_variants = r;
+    intern_map_put(&ctx->enum_variant_index, r->variant_name, r);
 }
 
 EnumVariantReg *find_enum_variant(ParserContext *ctx, const char *vname)
 {
-    EnumVariantReg *r = ctx->enum_variants;
-    while (r)
-    {
-        if (strcmp(r->variant_name, vname) == 0)
-        {
-            return r;
-        }
-        r = r->next;
-    }
-    return NULL;
+    return intern_map_get(&ctx->enum_variant_index, vname);
 }
 
 void register_lambda(ParserContext *ctx, ASTNode *node)
@@ -882,38 +803,30 @@ void register_lambda(ParserContext *ctx, ASTNode *node)
 void register_extern_symbol(ParserContext *ctx, const char *name)
 {
     // Check for duplicates
-    for (int i = 0; i < ctx->extern_symbol_count; i++)
+    void **slot = intern_map_slot(&ctx->extern_index, intern(name));
+    if (*slot)
     {
-        if (strcmp(ctx->extern_symbols[i], name) == 0)
-        {
-            return;
-        }
+        return;
     }
 
-    // Grow array if needed
-    if (ctx->extern_symbol_count == 0)
+    // Grow array if needed (doubling from 64, so the capacity follows from the count)
+    int count = ctx->extern_symbol_count;
+    if (count == 0)
     {
         ctx->extern_symbols = xmalloc(sizeof(char *) * 64);
     }
-    else if (ctx->extern_symbol_count % 64 == 0)
+    else if (count >= 64 && (count & (count - 1)) == 0)
     {
-        ctx->extern_symbols =
-            xrealloc(ctx->extern_symbols, sizeof(char *) * (ctx->extern_symbol_count + 64));
+        ctx->extern_symbols = xrealloc(ctx->extern_symbols, sizeof(char *) * count * 2);
     }
 
-    ctx->extern_symbols[ctx->extern_symbol_count++] = xstrdup(name);
+    ctx->extern_symbols[ctx->extern_symbol_count] = xstrdup(name);
+    *slot = ctx->extern_symbols[ctx->extern_symbol_count++];
 }
 
 int is_extern_symbol(ParserContext *ctx, const char *name)
 {
-    for (int i = 0; i < ctx->extern_symbol_count; i++)
-    {
-        if (strcmp(ctx->extern_symbols[i], name) == 0)
-        {
-            return 1;
-        }
-    }
-    return 0;
+    return intern_map_get(&ctx->extern_index, name) != NULL;
 }
 
 // Unified check: should we suppress "undefined variable" warning for this name?
@@ -953,19 +866,16 @@ int should_suppress_undef_warning(ParserContext *ctx, const char *name)
 
 void register_slice(ParserContext *ctx, const char *type)
 {
-    SliceType *c = ctx->used_slices;
-    while (c)
+    SliceType **slot = (SliceType **)intern_map_slot(&ctx->slice_index, intern(type));
+    if (*slot)
     {
-        if (strcmp(c->name, type) == 0)
-        {
-            return;
-        }
-        c = c->next;
+        return;
     }
     SliceType *n = xmalloc(sizeof(SliceType));
     n->name = xstrdup(type);
     n->next = ctx->used_slices;
     ctx->used_slices = n;
+    *slot = n;
 
     // Register Struct Def for Reflection
     char slice_name[256];
@@ -1062,91 +972,68 @@ void register_tuple(ParserContext *ctx, const char *sig)
 void register_struct_def(ParserContext *ctx, const char *name, ASTNode *node)
 {
     StructDef *d = xmalloc(sizeof(StructDef));
-    d->name = xstrdup(name);
+    d->name = intern(name);
     d->node = node;
     d->next = ctx->struct_defs;
     ctx->struct_defs = d;
+    intern_map_put(&ctx->struct_def_index, d->name, d);
 }
 
 ASTNode *find_struct_def(ParserContext *ctx, const char *name)
 {
-    Instantiation *i = ctx->instantiations;
-    while (i)
+    InternedStr key = intern_find(name);
+    if (!key)
     {
-        if (strcmp(i->name, name) == 0)
-        {
-            return i->struct_node;
-        }
-        i = i->next;
+        return NULL;
     }
 
-    ASTNode *s = ctx->instantiated_structs;
-    while (s)
+    Instantiation *i = intern_map_get(&ctx->instantiation_index, key);
+    if (i)
     {
-        if (s->type == NODE_STRUCT && strcmp(s->strct.name, name) == 0)
-        {
-            return s;
-        }
-        s = s->next;
+        return i->struct_node;
     }
 
-    StructRef *r = ctx->parsed_structs_list;
-    while (r)
+    ASTNode *s = intern_map_get(&ctx->instantiated_struct_index, key);
+    if (s)
     {
-        if (strcmp(r->node->strct.name, name) == 0)
-        {
-            return r->node;
-        }
-        r = r->next;
+        return s;
     }
 
-    // Check manually registered definitions (e.g. Slices)
-    StructDef *d = ctx->struct_defs;
-    while (d)
+    s = intern_map_get(&ctx->parsed_struct_index, key);
+    if (s)
     {
-        if (strcmp(d->name, name) == 0)
-        {
-            return d->node;
-        }
-        d = d->next;
+        return s;
     }
 
-    // Check enums list (for @derive(Eq) and field type lookups)
-    StructRef *e = ctx->parsed_enums_list;
-    while (e)
+    // Check manually registered definitions (e.g. Slices)
+    StructDef *d = intern_map_get(&ctx->struct_def_index, key);
+    if (d)
     {
-        if (e->node->type == NODE_ENUM && strcmp(e->node->enm.name, name) == 0)
-        {
-            return e->node;
-        }
-        e = e->next;
+        return d->node;
     }
 
-    return NULL;
+    // Check enums list (for @derive(Eq) and field type lookups)
+    return intern_map_get(&ctx->parsed_enum_index, key);
 }
 
 Module *find_module(ParserContext *ctx, const char *alias)
 {
-    Module *m = ctx->modules;
-    while (m)
-    {
-        if (m->alias && strcmp(m->alias, alias) == 0)
-        {
-            return m;
-        }
-        m = m->next;
-    }
-    return NULL;
+    return intern_map_get(&ctx->module_index, alias);
 }
 
-void register_module(ParserContext *ctx, const char *alias, const char *path)
+Module *register_module(ParserContext *ctx, const char *alias, const char *path)
 {
-    Module *m = xmalloc(sizeof(Module));
+    Module *m = xcalloc(1, sizeof(Module));
     m->alias = alias ? xstrdup(alias) : NULL;
     m->path = xstrdup(path);
     m->base_name = extract_module_name(path);
     m->next = ctx->modules;
     ctx->modules = m;
+    if (alias)
+    {
+        intern_map_put(&ctx->module_index, intern(alias), m);
+    }
+    return m;
 }
 
 void register_selective_import(ParserContext *ctx, const char *symbol, const char *alias,
@@ -1296,7 +1183,7 @@ char *replace_in_string(const char *src, const char *old_w, const char *new_w)
             in_string = !in_string;
         }
 
-        if (!in_string && strstr(&src[i], old_w) == &src[i])
+        if (!in_string && strncmp(&src[i], old_w, oldWlen) == 0)
         {
             // Check boundaries
             int valid = 1;
@@ -1334,7 +1221,7 @@ char *replace_in_string(const char *src, const char *old_w, const char *new_w)
         }
 
         int replaced = 0;
-        if (!in_string && strstr(&src[src_idx], old_w) == &src[src_idx])
+        if (!in_string && strncmp(&src[src_idx], old_w, oldWlen) == 0)
         {
             int valid = 1;
             if (src_idx > 0 && is_ident_char(src[src_idx - 1]))
@@ -1364,54 +1251,182 @@ char *replace_in_string(const char *src, const char *old_w, const char *new_w)
     return result;
 }
 
-char *replace_type_str(const char *src, const char *param, const char *concrete,
-                       const char *old_struct, const char *new_struct)
+/**
+ * @brief One template substitution: the type parameter(s) `p` become `c` and
+ * the template name `os` becomes the instantiated name `ns`.
+ *
+ * It is built once per instantiation, so that the strings every copied node
+ * needs (sanitized names, mangled suffixes, parsed concrete types) are not
+ * rebuilt for each node. Parts of the template that mention neither `p` nor
+ * `os` come out of the substitution unchanged and are shared, not copied.
+ */
+typedef struct
 {
-    if (src && param && concrete)
-    {
-    }
-    if (!src)
+    const char *p;         ///< Type parameter(s), comma separated ("T", "K,V").
+    const char *c;         ///< Concrete argument(s), comma separated.
+    const char *os;        ///< Template name (may be NULL).
+    const char *ns;        ///< Instantiated name (may be NULL).
+    int pair_count;        ///< Number of (param, concrete) pairs.
+    char **params;         ///< Parameter of each pair.
+    char **concretes;      ///< Concrete argument of each pair.
+    Type **concrete_types; ///< Parsed concrete of each pair, built on first use.
+    int word_count;        ///< Number of comma-separated words in `p`.
+    char **words;          ///< Every word of `p`, for the mention check.
+    char *clean_c;         ///< sanitize_mangled_name(c).
+    char *p_suffix;        ///< "_T", "_K_V": how `p` ends a mangled name.
+    char *c_suffix;        ///< "_int", "_int_float": what `p_suffix` becomes.
+    char *os_p;            ///< "os_p", the template's own mangled name.
+} Subst;
+
+static char *subst_mangled_suffix(const char *list, int sanitize)
+{
+    char *buf = xmalloc(strlen(list) * 5 + 2);
+    buf[0] = 0;
+    char *tmp = xstrdup(list);
+    char *tok = strtok(tmp, ",");
+    while (tok)
     {
-        return NULL;
+        strcat(buf, "_");
+        if (sanitize)
+        {
+            char *clean = sanitize_mangled_name(tok);
+            strcat(buf, clean);
+            free(clean);
+        }
+        else
+        {
+            strcat(buf, tok);
+        }
+        tok = strtok(NULL, ",");
     }
+    free(tmp);
+    return buf;
+}
 
-    // Handle multi-param match
-    if (param && concrete && strchr(param, ','))
-    {
-        char *p_ptr = (char *)param;
-        char *c_ptr = (char *)concrete;
+static void subst_init(Subst *s, const char *p, const char *c, const char *os, const char *ns)
+{
+    memset(s, 0, sizeof(*s));
+    s->p = p;
+    s->c = c;
+    s->os = os;
+    s->ns = ns;
 
-        while (*p_ptr && *c_ptr)
+    if (p)
+    {
+        int n = 1;
+        for (const char *q = p; *q; q++)
         {
-            char *p_end = strchr(p_ptr, ',');
-            int p_len = p_end ? (int)(p_end - p_ptr) : (int)strlen(p_ptr);
-
-            char *c_end = strchr(c_ptr, ',');
-            int c_len = c_end ? (int)(c_end - c_ptr) : (int)strlen(c_ptr);
-
-            if ((int)strlen(src) == p_len && strncmp(src, p_ptr, p_len) == 0)
-            {
-                char *ret = xmalloc(c_len + 1);
-                strncpy(ret, c_ptr, c_len);
-                ret[c_len] = 0;
-                return ret;
-            }
-
-            if (p_end)
+            if (*q == ',')
             {
-                p_ptr = p_end + 1;
+                n++;
             }
-            else
+        }
+        s->words = xmalloc(sizeof(char *) * n);
+        const char *w = p;
+        while (1)
+        {
+            const char *end = strchr(w, ',');
+            size_t len = end ? (size_t)(end - w) : strlen(w);
+            char *word = xmalloc(len + 1);
+            memcpy(word, w, len);
+            word[len] = 0;
+            s->words[s->word_count++] = word;
+            if (!end)
             {
                 break;
             }
-            if (c_end)
+            w = end + 1;
+        }
+
+        if (c)
+        {
+            s->params = xmalloc(sizeof(char *) * n);
+            s->concretes = xmalloc(sizeof(char *) * n);
+            s->concrete_types = xcalloc(n, sizeof(Type *));
+            if (strchr(p, ','))
             {
-                c_ptr = c_end + 1;
+                // Pair the lists up until either runs out.
+                const char *p_ptr = p;
+                const char *c_ptr = c;
+                while (*p_ptr && *c_ptr)
+                {
+                    const char *p_end = strchr(p_ptr, ',');
+                    size_t p_len = p_end ? (size_t)(p_end - p_ptr) : strlen(p_ptr);
+                    const char *c_end = strchr(c_ptr, ',');
+                    size_t c_len = c_end ? (size_t)(c_end - c_ptr) : strlen(c_ptr);
+
+                    char *pp = xmalloc(p_len + 1);
+                    memcpy(pp, p_ptr, p_len);
+                    pp[p_len] = 0;
+                    char *cc = xmalloc(c_len + 1);
+                    memcpy(cc, c_ptr, c_len);
+                    cc[c_len] = 0;
+                    s->params[s->pair_count] = pp;
+                    s->concretes[s->pair_count] = cc;
+                    s->pair_count++;
+
+                    if (!p_end || !c_end)
+                    {
+                        break;
+                    }
+                    p_ptr = p_end + 1;
+                    c_ptr = c_end + 1;
+                }
             }
             else
             {
-                break;
+                s->params[0] = (char *)p;
+                s->concretes[0] = (char *)c;
+                s->pair_count = 1;
+            }
+
+            s->clean_c = sanitize_mangled_name(c);
+            s->p_suffix = subst_mangled_suffix(p, 0);
+            s->c_suffix = subst_mangled_suffix(c, 1);
+        }
+    }
+
+    if (os && ns && p)
+    {
+        s->os_p = xmalloc(strlen(os) + strlen(p) + 2);
+        sprintf(s->os_p, "%s_%s", os, p);
+    }
+}
+
+// Every rewrite done by a substitution starts from an occurrence of a
+// parameter word or of the template name, so text without one is unchanged.
+static int subst_mentions(const Subst *s, const char *src)
+{
+    for (int i = 0; i < s->word_count; i++)
+    {
+        if (strstr(src, s->words[i]))
+        {
+            return 1;
+        }
+    }
+    return s->os && s->ns && strstr(src, s->os);
+}
+
+// Substitute in a type string. Returns `src` itself when nothing changed.
+static char *subst_type_str(Subst *s, const char *src)
+{
+    if (!src)
+    {
+        return NULL;
+    }
+    if (!subst_mentions(s, src))
+    {
+        return (char *)src;
+    }
+
+    // Handle multi-param match
+    if (s->p && s->c && strchr(s->p, ','))
+    {
+        for (int i = 0; i < s->pair_count; i++)
+        {
+            if (strcmp(src, s->params[i]) == 0)
+            {
+                return xstrdup(s->concretes[i]);
             }
         }
     }
@@ -1444,131 +1459,87 @@ char *replace_type_str(const char *src, const char *param, const char *concrete,
             strncpy(base, src, bracket_idx);
             base[bracket_idx] = 0;
 
-            char *new_base = replace_type_str(base, param, concrete, old_struct, new_struct);
-
-            if (new_base && strcmp(new_base, base) != 0)
+            char *new_base = subst_type_str(s, base);
+            if (new_base != base && strcmp(new_base, base) != 0)
             {
-                char *suffix = (char *)src + bracket_idx;
+                const char *suffix = src + bracket_idx;
                 char *res = xmalloc(strlen(new_base) + strlen(suffix) + 1);
                 sprintf(res, "%s%s", new_base, suffix);
-                free(base);
-                free(new_base);
                 return res;
             }
-            free(base);
-            if (new_base)
-            {
-                free(new_base);
-            }
         }
     }
 
-    if (param && strcmp(src, param) == 0)
+    if (s->p && strcmp(src, s->p) == 0)
     {
-
-        return xstrdup(concrete);
+        return xstrdup(s->c);
     }
 
-    if (old_struct && new_struct && strcmp(src, old_struct) == 0)
+    if (s->os && s->ns && strcmp(src, s->os) == 0)
     {
-        return xstrdup(new_struct);
+        return xstrdup(s->ns);
     }
 
-    if (old_struct && new_struct && param)
+    if (s->os_p && strcmp(src, s->os_p) == 0)
     {
-        char *mangled = xmalloc(strlen(old_struct) + strlen(param) + 2);
-        sprintf(mangled, "%s_%s", old_struct, param);
-        if (strcmp(src, mangled) == 0)
-        {
-            free(mangled);
-            return xstrdup(new_struct);
-        }
-        free(mangled);
+        return xstrdup(s->ns);
     }
 
-    if (param && concrete && src)
+    if (s->p_suffix)
     {
-        // Construct mangled suffix from param ("F,S" -> "_F_S")
-        char p_suffix[1024];
-        p_suffix[0] = 0;
-
-        char *p_temp = xstrdup(param);
-        char *tok = strtok(p_temp, ",");
-        while (tok)
-        {
-            strcat(p_suffix, "_");
-            strcat(p_suffix, tok);
-            tok = strtok(NULL, ",");
-        }
-        free(p_temp);
-
+        // Mangled suffix: "Vec_T" -> "Vec_int", "Pair_K_V" -> "Pair_int_float"
         size_t slen = strlen(src);
-        size_t plen = strlen(p_suffix);
-
-        if (slen >= plen && strcmp(src + slen - plen, p_suffix) == 0)
+        size_t plen = strlen(s->p_suffix);
+        if (slen >= plen && strcmp(src + slen - plen, s->p_suffix) == 0)
         {
-            // Construct replacement suffix from concrete ("int,float" -> "_int_float")
-            char c_suffix[1024];
-            c_suffix[0] = 0;
-
-            char *c_temp = xstrdup(concrete);
-            tok = strtok(c_temp, ",");
-            while (tok)
-            {
-                strcat(c_suffix, "_");
-                char *clean = sanitize_mangled_name(tok);
-                strcat(c_suffix, clean);
-                free(clean);
-                tok = strtok(NULL, ",");
-            }
-            free(c_temp);
-
-            // Perform replacement
-            char *ret = xmalloc(slen - plen + strlen(c_suffix) + 1);
-            strncpy(ret, src, slen - plen);
-            ret[slen - plen] = 0;
-            strcat(ret, c_suffix);
+            char *ret = xmalloc(slen - plen + strlen(s->c_suffix) + 1);
+            memcpy(ret, src, slen - plen);
+            strcpy(ret + slen - plen, s->c_suffix);
             return ret;
         }
     }
 
-    len = strlen(src);
     if (len > 1 && src[len - 1] == '*')
     {
         char *base = xmalloc(len);
         strncpy(base, src, len - 1);
         base[len - 1] = 0;
 
-        char *new_base = replace_type_str(base, param, concrete, old_struct, new_struct);
-        free(base);
-
-        if (strcmp(new_base, base) != 0)
+        char *new_base = subst_type_str(s, base);
+        if (new_base != base && strcmp(new_base, base) != 0)
         {
             char *ret = xmalloc(strlen(new_base) + 2);
             sprintf(ret, "%s*", new_base);
-            free(new_base);
             return ret;
         }
-        free(new_base);
     }
 
     if (strncmp(src, "Slice_", 6) == 0)
     {
-        char *base = xstrdup(src + 6);
-        char *new_base = replace_type_str(base, param, concrete, old_struct, new_struct);
-        free(base);
-
-        if (strcmp(new_base, base) != 0)
+        const char *base = src + 6;
+        char *new_base = subst_type_str(s, base);
+        if (new_base != base && strcmp(new_base, base) != 0)
         {
             char *ret = xmalloc(strlen(new_base) + 7);
             sprintf(ret, "Slice_%s", new_base);
-            free(new_base);
             return ret;
         }
-        free(new_base);
     }
 
-    return xstrdup(src);
+    return (char *)src;
+}
+
+char *replace_type_str(const char *src, const char *param, const char *concrete,
+                       const char *old_struct, const char *new_struct)
+{
+    if (!src)
+    {
+        return NULL;
+    }
+    Subst s;
+    subst_init(&s, param, concrete, old_struct, new_struct);
+    char *res = subst_type_str(&s, src);
+    return res == src ? xstrdup(src) : res;
 }
 
 ASTNode *copy_ast_replacing(ASTNode *n, const char *p, const char *c, const char *os,
@@ -1598,7 +1569,7 @@ Type *type_from_string_helper(const char *c)
     if (strncmp(c, "struct ", 7) == 0)
     {
         Type *n = type_new(TYPE_STRUCT);
-        n->name = sanitize_mangled_name(c + 7);
+        n->name = intern(sanitize_mangled_name(c + 7));
         n->is_explicit_struct = 1;
         return n;
     }
@@ -1698,136 +1669,137 @@ Type *type_from_string_helper(const char *c)
     }
 
     Type *n = type_new(TYPE_STRUCT);
-    n->name = sanitize_mangled_name(c);
+    n->name = intern(sanitize_mangled_name(c));
     return n;
 }
 
-Type *replace_type_formal(Type *t, const char *p, const char *c, const char *os, const char *ns)
+// The concrete type replacing the parameter of pair `i`, parsed once per
+// substitution and shared by every use.
+static Type *subst_concrete_type(Subst *s, int i)
 {
-    if (!t)
+    if (!s->concrete_types[i])
     {
-        return NULL;
+        s->concrete_types[i] = type_from_string_helper(s->concretes[i]);
     }
+    return s->concrete_types[i];
+}
 
-    // Exact Match Logic (with multi-param splitting)
-    if ((t->kind == TYPE_STRUCT || t->kind == TYPE_GENERIC) && t->name)
+// Index of the pair whose parameter is exactly `name`, or -1.
+static int subst_param_index(const Subst *s, const char *name)
+{
+    for (int i = 0; i < s->pair_count; i++)
     {
-
-        if (p && c && strchr(p, ','))
-        {
-            char *p_ptr = (char *)p;
-            char *c_ptr = (char *)c;
-            while (*p_ptr && *c_ptr)
-            {
-                char *p_end = strchr(p_ptr, ',');
-                int p_len = p_end ? (int)(p_end - p_ptr) : (int)strlen(p_ptr);
-                char *c_end = strchr(c_ptr, ',');
-                int c_len = c_end ? (int)(c_end - c_ptr) : (int)strlen(c_ptr);
-
-                if ((int)strlen(t->name) == p_len && strncmp(t->name, p_ptr, p_len) == 0)
-                {
-                    char *c_part = xmalloc(c_len + 1);
-                    strncpy(c_part, c_ptr, c_len);
-                    c_part[c_len] = 0;
-
-                    Type *res = type_from_string_helper(c_part);
-                    free(c_part);
-                    return res;
-                }
-                if (p_end)
-                {
-                    p_ptr = p_end + 1;
-                }
-                else
-                {
-                    break;
-                }
-                if (c_end)
-                {
-                    c_ptr = c_end + 1;
-                }
-                else
-                {
-                    break;
-                }
-            }
-        }
-        else if (strcmp(t->name, p) == 0)
+        if (strcmp(name, s->params[i]) == 0)
         {
-            return type_from_string_helper(c);
+            return i;
         }
     }
+    return -1;
+}
 
-    Type *n = xmalloc(sizeof(Type));
-    *n = *t;
+// 1 if `name` is the template name, or a name mangled from the parameters
+// ("Vec_T"), i.e. something subst_type renames.
+static int subst_renames(const Subst *s, const char *name)
+{
+    if (s->os && s->ns && strcmp(name, s->os) == 0)
+    {
+        return 1;
+    }
+    if (s->p_suffix)
+    {
+        size_t nlen = strlen(name);
+        size_t slen = strlen(s->p_suffix);
+        return nlen >= slen && strcmp(name + nlen - slen, s->p_suffix) == 0;
+    }
+    return 0;
+}
 
+// 1 if substituting `t` would change anything in it.
+static int subst_type_depends(const Subst *s, const Type *t)
+{
+    if (!t)
+    {
+        return 0;
+    }
     if (t->name)
     {
-        if (os && ns && strcmp(t->name, os) == 0)
+        if ((t->kind == TYPE_STRUCT || t->kind == TYPE_GENERIC) &&
+            subst_param_index(s, t->name) >= 0)
         {
-            n->name = xstrdup(ns);
-            n->kind = TYPE_STRUCT;
-            n->arg_count = 0;
-            n->args = NULL;
+            return 1;
         }
-        else if (p && c)
+        if (subst_renames(s, t->name))
         {
-            // Suffix Match Logic (with multi-param splitting)
-            char p_suffix[1024];
-            p_suffix[0] = 0;
-
-            char *p_temp = xstrdup(p);
-            char *tok = strtok(p_temp, ",");
-            while (tok)
+            return 1;
+        }
+    }
+    if ((t->kind == TYPE_POINTER || t->kind == TYPE_ARRAY) && subst_type_depends(s, t->inner))
+    {
+        return 1;
+    }
+    if (t->arg_count > 0 && t->args)
+    {
+        for (int i = 0; i < t->arg_count; i++)
+        {
+            if (subst_type_depends(s, t->args[i]))
             {
-                strcat(p_suffix, "_");
-                strcat(p_suffix, tok);
-                tok = strtok(NULL, ",");
+                return 1;
             }
-            free(p_temp);
+        }
+    }
+    return 0;
+}
 
-            size_t nlen = strlen(t->name);
-            size_t slen = strlen(p_suffix);
+// Substitute in a formal type. Subtrees that do not depend on the parameters
+// are returned as they are (types are not mutated once built), so only the
+// path down to each parameter use is copied.
+static Type *subst_type(Subst *s, Type *t)
+{
+    if (!subst_type_depends(s, t))
+    {
+        if (t)
+        {
+            g_stats.shared_types++;
+        }
+        return t;
+    }
 
-            if (nlen >= slen && strcmp(t->name + nlen - slen, p_suffix) == 0)
-            {
-                char c_suffix[1024];
-                c_suffix[0] = 0;
-                char *c_temp = xstrdup(c);
-                tok = strtok(c_temp, ",");
-                while (tok)
-                {
-                    strcat(c_suffix, "_");
-                    char *clean = sanitize_mangled_name(tok);
-                    strcat(c_suffix, clean);
-                    free(clean);
-                    tok = strtok(NULL, ",");
-                }
-                free(c_temp);
-
-                char *new_name = xmalloc(nlen - slen + strlen(c_suffix) + 1);
-                strncpy(new_name, t->name, nlen - slen);
-                new_name[nlen - slen] = 0;
-                strcat(new_name, c_suffix);
-                n->name = new_name;
-                n->kind = TYPE_STRUCT;
-                n->arg_count = 0;
-                n->args = NULL;
-            }
-            else
-            {
-                n->name = xstrdup(t->name);
-            }
+    if ((t->kind == TYPE_STRUCT || t->kind == TYPE_GENERIC) && t->name)
+    {
+        int i = subst_param_index(s, t->name);
+        if (i >= 0)
+        {
+            return subst_concrete_type(s, i);
+        }
+    }
+
+    Type *n = xmalloc(sizeof(Type));
+    *n = *t;
+    n->id = 0;
+
+    if (t->name && subst_renames(s, t->name))
+    {
+        if (s->os && s->ns && strcmp(t->name, s->os) == 0)
+        {
+            n->name = intern(s->ns);
         }
         else
         {
-            n->name = xstrdup(t->name);
+            size_t nlen = strlen(t->name);
+            size_t slen = strlen(s->p_suffix);
+            char *new_name = xmalloc(nlen - slen + strlen(s->c_suffix) + 1);
+            memcpy(new_name, t->name, nlen - slen);
+            strcpy(new_name + nlen - slen, s->c_suffix);
+            n->name = intern(new_name);
         }
+        n->kind = TYPE_STRUCT;
+        n->arg_count = 0;
+        n->args = NULL;
     }
 
     if (t->kind == TYPE_POINTER || t->kind == TYPE_ARRAY)
     {
-        n->inner = replace_type_formal(t->inner, p, c, os, ns);
+        n->inner = subst_type(s, t->inner);
     }
 
     if (n->arg_count > 0 && t->args)
@@ -1835,28 +1807,41 @@ Type *replace_type_formal(Type *t, const char *p, const char *c, const char *os,
         n->args = xmalloc(sizeof(Type *) * t->arg_count);
         for (int i = 0; i < t->arg_count; i++)
         {
-            n->args[i] = replace_type_formal(t->args[i], p, c, os, ns);
+            n->args[i] = subst_type(s, t->args[i]);
         }
     }
 
     return n;
 }
 
+Type *replace_type_formal(Type *t, const char *p, const char *c, const char *os, const char *ns)
+{
+    Subst s;
+    subst_init(&s, p, c, os, ns);
+    return subst_type(&s, t);
+}
+
 // Helper to replace generic params in mangled names (e.g. Option_V_None ->
 // Option_int_None)
 char *replace_mangled_part(const char *src, const char *param, const char *concrete)
 {
-    if (!src || !param || !concrete)
+    if (!src || !param || !concrete || !*param)
     {
         return src ? xstrdup(src) : NULL;
     }
 
-    char *result = xmalloc(4096); // Basic buffer for simplicity
-    result[0] = 0;
+    size_t slen = strlen(src);
+    size_t plen = strlen(param);
+    size_t clen = strlen(concrete);
+    size_t max_len = slen;
+    if (clen > plen)
+    {
+        max_len += (slen / plen + 1) * (clen - plen);
+    }
+    char *result = xmalloc(max_len + 1);
 
     const char *curr = src;
     char *out = result;
-    int plen = strlen(param);
 
     while (*curr)
     {
@@ -1899,8 +1884,8 @@ char *replace_mangled_part(const char *src, const char *param, const char *concr
 
             if (valid)
             {
-                strcpy(out, concrete);
-                out += strlen(concrete);
+                memcpy(out, concrete, clen);
+                out += clen;
                 curr += plen;
                 continue;
             }
@@ -1908,68 +1893,67 @@ char *replace_mangled_part(const char *src, const char *param, const char *concr
         *out++ = *curr++;
     }
     *out = 0;
-    return xstrdup(result);
+    return result;
 }
 
-ASTNode *copy_ast_replacing(ASTNode *n, const char *p, const char *c, const char *os,
-                            const char *ns)
+// Substitute in free-form source text (argument lists, raw statements).
+// Returns `src` itself when it cannot be affected.
+static char *subst_text(Subst *s, const char *src)
 {
-    if (!n)
+    if (!src || !subst_mentions(s, src))
     {
-        return NULL;
+        return (char *)src;
     }
 
-    ASTNode *new_node = xmalloc(sizeof(ASTNode));
-    *new_node = *n;
-
-    if (n->resolved_type)
+    char *res = replace_in_string(src, s->p, s->c);
+    if (s->os && s->ns)
     {
-        new_node->resolved_type = replace_type_str(n->resolved_type, p, c, os, ns);
+        res = replace_in_string(res, s->os, s->ns);
     }
-    new_node->type_info = replace_type_formal(n->type_info, p, c, os, ns);
+    if (s->p && s->c)
+    {
+        res = replace_mangled_part(res, s->p, s->clean_c);
+    }
+    return res;
+}
 
-    new_node->next = copy_ast_replacing(n->next, p, c, os, ns);
+static ASTNode *subst_ast(Subst *s, ASTNode *n);
+
+// Copy one node (not its `next` chain), substituting in everything it owns.
+// Names and operators are never rewritten in place, so unchanged ones are
+// shared with the template.
+static ASTNode *subst_node(Subst *s, ASTNode *n)
+{
+    ASTNode *new_node = xmalloc(sizeof(ASTNode));
+    *new_node = *n;
+    new_node->next = NULL;
+    g_stats.copied_nodes++;
+
+    new_node->resolved_type = subst_type_str(s, n->resolved_type);
+    new_node->type_info = subst_type(s, n->type_info);
 
     switch (n->type)
     {
     case NODE_FUNCTION:
+        // Renamed in place by instantiate_methods, so keep a private copy.
         new_node->func.name = xstrdup(n->func.name);
-        new_node->func.ret_type = replace_type_str(n->func.ret_type, p, c, os, ns);
-
-        char *tmp_args = replace_in_string(n->func.args, p, c);
-        if (os && ns)
-        {
-            char *tmp2 = replace_in_string(tmp_args, os, ns);
-            free(tmp_args);
-            tmp_args = tmp2;
-        }
-        if (p && c)
-        {
-            char *clean_c = sanitize_mangled_name(c);
-            char *tmp3 = replace_mangled_part(tmp_args, p, clean_c);
-            free(clean_c);
-            free(tmp_args);
-            tmp_args = tmp3;
-        }
-        new_node->func.args = tmp_args;
-
-        new_node->func.ret_type_info = replace_type_formal(n->func.ret_type_info, p, c, os, ns);
+        new_node->func.ret_type = subst_type_str(s, n->func.ret_type);
+        new_node->func.args = subst_text(s, n->func.args);
+        new_node->func.ret_type_info = subst_type(s, n->func.ret_type_info);
 
         // Deep copy default values AST if present
         if (n->func.default_values && n->func.arg_count > 0)
         {
             new_node->func.default_values = xmalloc(sizeof(ASTNode *) * n->func.arg_count);
-            // We also need to regenerate the string defaults array based on the substituted ASTs
-            // This ensures potential generic params in default values (T{}) are updated (i32{})
-            // in the string representation used by codegen.
+            // Regenerate the string defaults from the substituted ASTs, so that generic
+            // params in default values (T{}) are updated (i32{}) for codegen as well.
             char **new_defaults_strs = xmalloc(sizeof(char *) * n->func.arg_count);
 
             for (int i = 0; i < n->func.arg_count; i++)
             {
                 if (n->func.default_values[i])
                 {
-                    new_node->func.default_values[i] =
-                        copy_ast_replacing(n->func.default_values[i], p, c, os, ns);
+                    new_node->func.default_values[i] = subst_ast(s, n->func.default_values[i]);
                     new_defaults_strs[i] = ast_to_string(new_node->func.default_values[i]);
                 }
                 else
@@ -1978,12 +1962,6 @@ ASTNode *copy_ast_replacing(ASTNode *n, const char *p, const char *c, const char
                     new_defaults_strs[i] = NULL;
                 }
             }
-            // Replace the old string-based defaults with our regenerated ones
-            // Note: We leak the old 'tmp_args' calculated above, but that's just a single string
-            // for valid args The 'defaults' array in func struct is what matters for function
-            // definition. Wait, NODE_FUNCTION has char *args (legacy) AND char **defaults (array).
-            // parse_and_convert_args populated both.
-            // We need to update new_node->func.defaults.
             new_node->func.defaults = new_defaults_strs;
         }
 
@@ -1992,112 +1970,75 @@ ASTNode *copy_ast_replacing(ASTNode *n, const char *p, const char *c, const char
             new_node->func.arg_types = xmalloc(sizeof(Type *) * n->func.arg_count);
             for (int i = 0; i < n->func.arg_count; i++)
             {
-                new_node->func.arg_types[i] =
-                    replace_type_formal(n->func.arg_types[i], p, c, os, ns);
+                new_node->func.arg_types[i] = subst_type(s, n->func.arg_types[i]);
             }
         }
 
-        new_node->func.body = copy_ast_replacing(n->func.body, p, c, os, ns);
+        new_node->func.body = subst_ast(s, n->func.body);
         break;
     case NODE_BLOCK:
-        new_node->block.statements = copy_ast_replacing(n->block.statements, p, c, os, ns);
+        new_node->block.statements = subst_ast(s, n->block.statements);
         break;
     case NODE_RAW_STMT:
-    {
-        char *s1 = replace_in_string(n->raw_stmt.content, p, c);
-        if (os && ns)
-        {
-            char *s2 = replace_in_string(s1, os, ns);
-            free(s1);
-            s1 = s2;
-        }
-
-        if (p && c)
-        {
-            char *clean_c = sanitize_mangled_name(c);
-            char *s3 = replace_mangled_part(s1, p, clean_c);
-            free(clean_c);
-            free(s1);
-            s1 = s3;
-        }
-
-        new_node->raw_stmt.content = s1;
-    }
-    break;
+        new_node->raw_stmt.content = subst_text(s, n->raw_stmt.content);
+        break;
     case NODE_VAR_DECL:
-        new_node->var_decl.name = xstrdup(n->var_decl.name);
-        new_node->var_decl.type_str = replace_type_str(n->var_decl.type_str, p, c, os, ns);
-        new_node->var_decl.init_expr = copy_ast_replacing(n->var_decl.init_expr, p, c, os, ns);
+        new_node->var_decl.type_str = subst_type_str(s, n->var_decl.type_str);
+        new_node->var_decl.init_expr = subst_ast(s, n->var_decl.init_expr);
         break;
     case NODE_RETURN:
-        new_node->ret.value = copy_ast_replacing(n->ret.value, p, c, os, ns);
+        new_node->ret.value = subst_ast(s, n->ret.value);
         break;
     case NODE_EXPR_BINARY:
-        new_node->binary.left = copy_ast_replacing(n->binary.left, p, c, os, ns);
-        new_node->binary.right = copy_ast_replacing(n->binary.right, p, c, os, ns);
-        new_node->binary.op = xstrdup(n->binary.op);
+        new_node->binary.left = subst_ast(s, n->binary.left);
+        new_node->binary.right = subst_ast(s, n->binary.right);
         break;
     case NODE_EXPR_UNARY:
-        new_node->unary.op = xstrdup(n->unary.op);
-        new_node->unary.operand = copy_ast_replacing(n->unary.operand, p, c, os, ns);
+        new_node->unary.operand = subst_ast(s, n->unary.operand);
         break;
     case NODE_EXPR_CALL:
-        new_node->call.callee = copy_ast_replacing(n->call.callee, p, c, os, ns);
-        new_node->call.args = copy_ast_replacing(n->call.args, p, c, os, ns);
-        new_node->call.arg_names = n->call.arg_names; // Share pointer (shallow copy)
-        new_node->call.arg_count = n->call.arg_count;
+        new_node->call.callee = subst_ast(s, n->call.callee);
+        new_node->call.args = subst_ast(s, n->call.args);
         break;
     case NODE_EXPR_VAR:
-    {
-        char *n1 = xstrdup(n->var_ref.name);
-        if (p && c)
+        if (subst_mentions(s, n->var_ref.name))
         {
-            char *clean_c = sanitize_mangled_name(c);
-            char *n2 = replace_mangled_part(n1, p, clean_c);
-            free(clean_c);
-            free(n1);
-            n1 = n2;
-        }
-        if (os && ns)
-        {
-            int os_len = strlen(os);
-            if (strncmp(n1, os, os_len) == 0 && n1[os_len] == '_' && n1[os_len + 1] == '_')
+            char *n1 = n->var_ref.name;
+            if (s->p && s->c)
             {
-                char *suffix = n1 + os_len;
-                char *n3 = xmalloc(strlen(ns) + strlen(suffix) + 1);
-                sprintf(n3, "%s%s", ns, suffix);
-                free(n1);
-                n1 = n3;
+                n1 = replace_mangled_part(n1, s->p, s->clean_c);
             }
+            if (s->os && s->ns)
+            {
+                int os_len = strlen(s->os);
+                if (strncmp(n1, s->os, os_len) == 0 && n1[os_len] == '_' && n1[os_len + 1] == '_')
+                {
+                    char *suffix = n1 + os_len;
+                    char *n3 = xmalloc(strlen(s->ns) + strlen(suffix) + 1);
+                    sprintf(n3, "%s%s", s->ns, suffix);
+                    n1 = n3;
+                }
+            }
+            new_node->var_ref.name = n1;
         }
-        new_node->var_ref.name = n1;
-    }
-    break;
-    case NODE_FIELD:
-        new_node->field.name = xstrdup(n->field.name);
-        new_node->field.type = replace_type_str(n->field.type, p, c, os, ns);
         break;
-    case NODE_EXPR_LITERAL:
-        if (n->literal.type_kind == LITERAL_STRING)
-        {
-            new_node->literal.string_val = xstrdup(n->literal.string_val);
-        }
+    case NODE_FIELD:
+        new_node->field.type = subst_type_str(s, n->field.type);
         break;
     case NODE_EXPR_MEMBER:
-        new_node->member.target = copy_ast_replacing(n->member.target, p, c, os, ns);
-        new_node->member.field = xstrdup(n->member.field);
+        new_node->member.target = subst_ast(s, n->member.target);
         break;
     case NODE_EXPR_INDEX:
-        new_node->index.array = copy_ast_replacing(n->index.array, p, c, os, ns);
-        new_node->index.index = copy_ast_replacing(n->index.index, p, c, os, ns);
+        new_node->index.array = subst_ast(s, n->index.array);
+        new_node->index.index = subst_ast(s, n->index.index);
         break;
     case NODE_EXPR_CAST:
-        new_node->cast.target_type = replace_type_str(n->cast.target_type, p, c, os, ns);
-        new_node->cast.expr = copy_ast_replacing(n->cast.expr, p, c, os, ns);
+        new_node->cast.target_type = subst_type_str(s, n->cast.target_type);
+        new_node->cast.expr = subst_ast(s, n->cast.expr);
         break;
     case NODE_EXPR_STRUCT_INIT:
     {
-        char *new_name = replace_type_str(n->struct_init.struct_name, p, c, os, ns);
+        char *new_name = subst_type_str(s, n->struct_init.struct_name);
 
         int is_ptr = 0;
         size_t len = strlen(new_name);
@@ -2113,56 +2054,42 @@ ASTNode *copy_ast_replacing(ASTNode *n, const char *p, const char *c, const char
             new_node->type = NODE_EXPR_LITERAL;
             new_node->literal.type_kind = LITERAL_INT;
             new_node->literal.int_val = 0;
-            free(new_name);
         }
         else
         {
             new_node->struct_init.struct_name = new_name;
-            ASTNode *h = NULL, *t = NULL, *curr = n->struct_init.fields;
-            while (curr)
-            {
-                ASTNode *cp = copy_ast_replacing(curr, p, c, os, ns);
-                cp->next = NULL;
-                if (!h)
-                {
-                    h = cp;
-                }
-                else
-                {
-                    t->next = cp;
-                }
-                t = cp;
-                curr = curr->next;
-            }
-            new_node->struct_init.fields = h;
+            new_node->struct_init.fields = subst_ast(s, n->struct_init.fields);
         }
         break;
     }
     case NODE_IF:
-        new_node->if_stmt.condition = copy_ast_replacing(n->if_stmt.condition, p, c, os, ns);
-        new_node->if_stmt.then_body = copy_ast_replacing(n->if_stmt.then_body, p, c, os, ns);
-        new_node->if_stmt.else_body = copy_ast_replacing(n->if_stmt.else_body, p, c, os, ns);
+        new_node->if_stmt.condition = subst_ast(s, n->if_stmt.condition);
+        new_node->if_stmt.then_body = subst_ast(s, n->if_stmt.then_body);
+        new_node->if_stmt.else_body = subst_ast(s, n->if_stmt.else_body);
         break;
     case NODE_WHILE:
-        new_node->while_stmt.condition = copy_ast_replacing(n->while_stmt.condition, p, c, os, ns);
-        new_node->while_stmt.body = copy_ast_replacing(n->while_stmt.body, p, c, os, ns);
+        new_node->while_stmt.condition = subst_ast(s, n->while_stmt.condition);
+        new_node->while_stmt.body = subst_ast(s, n->while_stmt.body);
         break;
     case NODE_FOR:
-        new_node->for_stmt.init = copy_ast_replacing(n->for_stmt.init, p, c, os, ns);
-        new_node->for_stmt.condition = copy_ast_replacing(n->for_stmt.condition, p, c, os, ns);
-        new_node->for_stmt.step = copy_ast_replacing(n->for_stmt.step, p, c, os, ns);
-        new_node->for_stmt.body = copy_ast_replacing(n->for_stmt.body, p, c, os, ns);
+        new_node->for_stmt.init = subst_ast(s, n->for_stmt.init);
+        new_node->for_stmt.condition = subst_ast(s, n->for_stmt.condition);
+        new_node->for_stmt.step = subst_ast(s, n->for_stmt.step);
+        new_node->for_stmt.body = subst_ast(s, n->for_stmt.body);
         break;
 
     case NODE_MATCH_CASE:
         if (n->match_case.pattern)
         {
-            char *s1 = replace_in_string(n->match_case.pattern, p, c);
-            if (os && ns)
+            char *s1 = n->match_case.pattern;
+            if (subst_mentions(s, s1))
             {
-                char *s2 = replace_in_string(s1, os, ns);
-                free(s1);
-                s1 = s2;
+                s1 = replace_in_string(s1, s->p, s->c);
+            }
+            if (s->os && s->ns)
+            {
+                // Always a fresh copy, as the "::" is rewritten in place.
+                s1 = replace_in_string(s1, s->os, s->ns);
                 char *colons = strstr(s1, "::");
                 if (colons)
                 {
@@ -2172,36 +2099,32 @@ ASTNode *copy_ast_replacing(ASTNode *n, const char *p, const char *c, const char
             }
             new_node->match_case.pattern = s1;
         }
-        new_node->match_case.body = copy_ast_replacing(n->match_case.body, p, c, os, ns);
+        new_node->match_case.body = subst_ast(s, n->match_case.body);
         if (n->match_case.guard)
         {
-            new_node->match_case.guard = copy_ast_replacing(n->match_case.guard, p, c, os, ns);
+            new_node->match_case.guard = subst_ast(s, n->match_case.guard);
         }
         break;
 
     case NODE_IMPL:
-        new_node->impl.struct_name = replace_type_str(n->impl.struct_name, p, c, os, ns);
-        new_node->impl.methods = copy_ast_replacing(n->impl.methods, p, c, os, ns);
+        new_node->impl.struct_name = subst_type_str(s, n->impl.struct_name);
+        new_node->impl.methods = subst_ast(s, n->impl.methods);
         break;
     case NODE_IMPL_TRAIT:
-        new_node->impl_trait.trait_name = xstrdup(n->impl_trait.trait_name);
-        new_node->impl_trait.target_type =
-            replace_type_str(n->impl_trait.target_type, p, c, os, ns);
-        new_node->impl_trait.methods = copy_ast_replacing(n->impl_trait.methods, p, c, os, ns);
+        new_node->impl_trait.target_type = subst_type_str(s, n->impl_trait.target_type);
+        new_node->impl_trait.methods = subst_ast(s, n->impl_trait.methods);
         break;
     case NODE_EXPR_SIZEOF:
         if (n->size_of.target_type)
         {
-            char *replaced = replace_type_str(n->size_of.target_type, p, c, os, ns);
+            char *replaced = subst_type_str(s, n->size_of.target_type);
             if (replaced && strchr(replaced, '<'))
             {
-                char *mangled = sanitize_mangled_name(replaced);
-                free(replaced);
-                replaced = mangled;
+                replaced = sanitize_mangled_name(replaced);
             }
             new_node->size_of.target_type = replaced;
         }
-        new_node->size_of.expr = copy_ast_replacing(n->size_of.expr, p, c, os, ns);
+        new_node->size_of.expr = subst_ast(s, n->size_of.expr);
         break;
     default:
         break;
@@ -2209,6 +2132,27 @@ ASTNode *copy_ast_replacing(ASTNode *n, const char *p, const char *c, const char
     return new_node;
 }
 
+// Copy a node and its `next` chain.
+static ASTNode *subst_ast(Subst *s, ASTNode *n)
+{
+    ASTNode *head = NULL;
+    ASTNode **tail = &head;
+    for (; n; n = n->next)
+    {
+        *tail = subst_node(s, n);
+        tail = &(*tail)->next;
+    }
+    return head;
+}
+
+ASTNode *copy_ast_replacing(ASTNode *n, const char *p, const char *c, const char *os,
+                            const char *ns)
+{
+    Subst s;
+    subst_init(&s, p, c, os, ns);
+    return subst_ast(&s, n);
+}
+
 // Helper to sanitize type names for mangling (e.g. "int*" -> "intPtr")
 char *sanitize_mangled_name(const char *s)
 {
@@ -2289,14 +2233,10 @@ char *unmangle_ptr_suffix(const char *s)
 
 FuncSig *find_func(ParserContext *ctx, const char *name)
 {
-    FuncSig *c = ctx->func_registry;
-    while (c)
+    FuncSig *c = intern_map_get(&ctx->func_index, name);
+    if (c)
     {
-        if (strcmp(c->name, name) == 0)
-        {
-            return c;
-        }
-        c = c->next;
+        return c;
     }
 
     // Fallback: Check current_impl_methods (siblings in the same impl block)
@@ -2309,7 +2249,7 @@ FuncSig *find_func(ParserContext *ctx, const char *name)
             {
                 // Found sibling method. Construct a temporary FuncSig.
                 FuncSig *sig = xmalloc(sizeof(FuncSig));
-                sig->name = n->func.name;
+                sig->name = intern(n->func.name);
                 sig->decl_token = n->token;
                 sig->total_args = n->func.arg_count;
                 sig->defaults = n->func.defaults;
@@ -2368,19 +2308,7 @@ static void trigger_instantiations(ParserContext *ctx, ASTNode *node)
                 char *concrete_arg = underscore + 1;
 
                 // Check if this is a known generic template
-                GenericTemplate *gt = ctx->templates;
-                int found = 0;
-                while (gt)
-                {
-                    if (strcmp(gt->name, template_name) == 0)
-                    {
-                        found = 1;
-                        break;
-                    }
-                    gt = gt->next;
-                }
-
-                if (found)
+                if (find_template(ctx, template_name))
                 {
                     char *unmangled = unmangle_ptr_suffix(concrete_arg);
                     Token dummy_tok = {0};
@@ -2517,8 +2445,10 @@ char *instantiate_function_template(ParserContext *ctx, const char *name, const
 
     if (find_func(ctx, mangled))
     {
+        g_stats.instance_reuses++;
         return mangled;
     }
+    g_stats.function_instances++;
 
     const char *subst_arg = unmangled_type ? unmangled_type : concrete_type;
 
@@ -2553,11 +2483,7 @@ char *instantiate_function_template(ParserContext *ctx, const char *name, const
             struct_base[base_len] = 0;
 
             // Check if it's a known generic template
-            GenericTemplate *gt = ctx->templates;
-            while (gt && strcmp(gt->name, struct_base) != 0)
-            {
-                gt = gt->next;
-            }
+            GenericTemplate *gt = find_template(ctx, struct_base);
             if (gt)
             {
                 // Parse the concrete types from unmangled_type or concrete_type
@@ -2800,27 +2726,34 @@ char *process_fstring(ParserContext *ctx, const char *content, char ***used_syms
     return gen;
 }
 
+// "Trait:Struct", the impl_index key. Only interned when registering, so a
+// lookup for a pair that was never registered allocates nothing.
+static InternedStr impl_key(const char *trait, const char *strct, int insert)
+{
+    size_t tlen = strlen(trait);
+    size_t slen = strlen(strct);
+    char small[256];
+    char *buf = tlen + slen + 2 <= sizeof(small) ? small : xmalloc(tlen + slen + 2);
+    memcpy(buf, trait, tlen);
+    buf[tlen] = ':';
+    memcpy(buf + tlen + 1, strct, slen + 1);
+    return insert ? intern(buf) : intern_find(buf);
+}
+
 void register_impl(ParserContext *ctx, const char *trait, const char *strct)
 {
     ImplReg *r = xmalloc(sizeof(ImplReg));
-    r->trait = xstrdup(trait);
-    r->strct = xstrdup(strct);
+    r->trait = intern(trait);
+    r->strct = intern(strct);
     r->next = ctx->registered_impls;
     ctx->registered_impls = r;
+    intern_map_put(&ctx->impl_index, impl_key(trait, strct, 1), r);
 }
 
 int check_impl(ParserContext *ctx, const char *trait, const char *strct)
 {
-    ImplReg *r = ctx->registered_impls;
-    while (r)
-    {
-        if (strcmp(r->trait, trait) == 0 && strcmp(r->strct, strct) == 0)
-        {
-            return 1;
-        }
-        r = r->next;
-    }
-    return 0;
+    InternedStr key = impl_key(trait, strct, 0);
+    return key && intern_map_get(&ctx->impl_index, key) != NULL;
 }
 
 static int is_unmangle_primitive(const char *base)
@@ -2845,10 +2778,15 @@ void register_template(ParserContext *ctx, const char *name, ASTNode *node)
     t->struct_node = node;
     t->next = ctx->templates;
     ctx->templates = t;
+    intern_map_put(&ctx->template_index, intern(name), t);
 }
 
-ASTNode *copy_fields_replacing(ParserContext *ctx, ASTNode *fields, const char *param,
-                               const char *concrete)
+GenericTemplate *find_template(ParserContext *ctx, const char *name)
+{
+    return intern_map_get(&ctx->template_index, name);
+}
+
+static ASTNode *subst_fields(ParserContext *ctx, Subst *s, ASTNode *fields)
 {
     if (!fields)
     {
@@ -2856,12 +2794,13 @@ ASTNode *copy_fields_replacing(ParserContext *ctx, ASTNode *fields, const char *
     }
     ASTNode *n = ast_create(NODE_FIELD);
     n->field.name = xstrdup(fields->field.name);
+    g_stats.copied_nodes++;
 
     // Replace strings
-    n->field.type = replace_type_str(fields->field.type, param, concrete, NULL, NULL);
+    n->field.type = subst_type_str(s, fields->field.type);
 
-    // Replace formal types (Deep Copy)
-    n->type_info = replace_type_formal(fields->type_info, param, concrete, NULL, NULL);
+    // Replace formal types
+    n->type_info = subst_type(s, fields->type_info);
 
     if (n->field.type && strchr(n->field.type, '_'))
     {
@@ -2886,19 +2825,7 @@ ASTNode *copy_fields_replacing(ParserContext *ctx, ASTNode *fields, const char *
                 char *concrete_arg = underscore + 1;
 
                 // Check if this is actually a known generic template
-                GenericTemplate *gt = ctx->templates;
-                int found = 0;
-                while (gt)
-                {
-                    if (strcmp(gt->name, template_name) == 0)
-                    {
-                        found = 1;
-                        break;
-                    }
-                    gt = gt->next;
-                }
-
-                if (found)
+                if (find_template(ctx, template_name))
                 {
                     char *unmangled = unmangle_ptr_suffix(concrete_arg);
                     instantiate_generic(ctx, template_name, concrete_arg, unmangled, fields->token);
@@ -2946,18 +2873,28 @@ ASTNode *copy_fields_replacing(ParserContext *ctx, ASTNode *fields, const char *
         }
     }
 
-    n->next = copy_fields_replacing(ctx, fields->next, param, concrete);
+    n->next = subst_fields(ctx, s, fields->next);
     return n;
 }
 
+ASTNode *copy_fields_replacing(ParserContext *ctx, ASTNode *fields, const char *param,
+                               const char *concrete)
+{
+    Subst s;
+    subst_init(&s, param, concrete, NULL, NULL);
+    return subst_fields(ctx, &s, fields);
+}
+
 void instantiate_methods(ParserContext *ctx, GenericImplTemplate *it,
                          const char *mangled_struct_name, const char *arg,
                          const char *unmangled_arg)
 {
     if (check_impl(ctx, "Methods", mangled_struct_name))
     {
+        g_stats.instance_reuses++;
         return; // Simple dedupe check
     }
+    g_stats.impl_instances++;
 
     ASTNode *backup_next = it->impl_node->next;
     it->impl_node->next = NULL; // Break link to isolate node
@@ -3080,34 +3017,24 @@ void instantiate_generic(ParserContext *ctx, const char *tpl, const char *arg,
     char m[256];
     sprintf(m, "%s_%s", tpl, clean_arg);
     free(clean_arg);
+    InternedStr name = intern(m);
 
-    Instantiation *c = ctx->instantiations;
-    while (c)
+    if (intern_map_get(&ctx->instantiation_index, name))
     {
-        if (strcmp(c->name, m) == 0)
-        {
-            return; // Already instantiated, DO NOTHING.
-        }
-        c = c->next;
+        g_stats.instance_reuses++;
+        return; // Already instantiated, DO NOTHING.
     }
 
-    GenericTemplate *t = ctx->templates;
-    while (t)
-    {
-        if (strcmp(t->name, tpl) == 0)
-        {
-            break;
-        }
-        t = t->next;
-    }
+    GenericTemplate *t = find_template(ctx, tpl);
     if (!t)
     {
         zpanic_at(token, "Unknown generic: %s", tpl);
     }
 
+    g_stats.generic_instances++;
     Instantiation *ni = xmalloc(sizeof(Instantiation));
-    ni->name = xstrdup(m);
-    ni->template_name = xstrdup(tpl);
+    ni->name = name;
+    ni->template_name = intern(tpl);
     ni->concrete_arg = xstrdup(arg);
     ni->unmangled_arg = unmangled_arg ? xstrdup(unmangled_arg)
                                       : xstrdup(arg); // Fallback to arg if unmangled is generic
@@ -3115,18 +3042,19 @@ void instantiate_generic(ParserContext *ctx, const char *tpl, const char *arg,
     ni->next = ctx->instantiations;
 
     ctx->instantiations = ni;
+    intern_map_put(&ctx->instantiation_index, name, ni);
 
     ASTNode *struct_node_copy = NULL;
 
     if (t->struct_node->type == NODE_STRUCT)
     {
         ASTNode *i = ast_create(NODE_STRUCT);
-        i->strct.name = xstrdup(m);
+        i->strct.name = name;
         i->strct.is_template = 0;
 
         // Copy type attributes (e.g. has_drop)
         i->type_info = type_new(TYPE_STRUCT);
-        i->type_info->name = xstrdup(m);
+        i->type_info->name = name;
         if (t->struct_node->type_info)
         {
             i->type_info->traits = t->struct_node->type_info->traits;
@@ -3162,12 +3090,12 @@ void instantiate_generic(ParserContext *ctx, const char *tpl, const char *arg,
     else if (t->struct_node->type == NODE_ENUM)
     {
         ASTNode *i = ast_create(NODE_ENUM);
-        i->enm.name = xstrdup(m);
+        i->enm.name = name;
         i->enm.is_template = 0;
 
         // Copy type attributes (e.g. has_drop)
         i->type_info = type_new(TYPE_ENUM);
-        i->type_info->name = xstrdup(m);
+        i->type_info->name = name;
         if (t->struct_node->type_info)
         {
             i->type_info->traits = t->struct_node->type_info->traits;
@@ -3207,6 +3135,10 @@ void instantiate_generic(ParserContext *ctx, const char *tpl, const char *arg,
     {
         struct_node_copy->next = ctx->instantiated_structs;
         ctx->instantiated_structs = struct_node_copy;
+        if (struct_node_copy->type == NODE_STRUCT)
+        {
+            intern_map_put(&ctx->instantiated_struct_index, name, struct_node_copy);
+        }
     }
 
     GenericImplTemplate *it = ctx->impl_templates;
@@ -3236,44 +3168,36 @@ void instantiate_generic_multi(ParserContext *ctx, const char *tpl, char **args,
     }
 
     // Check if already instantiated
-    Instantiation *c = ctx->instantiations;
-    while (c)
+    InternedStr name = intern(m);
+    if (intern_map_get(&ctx->instantiation_index, name))
     {
-        if (strcmp(c->name, m) == 0)
-        {
-            return; // Already done
-        }
-        c = c->next;
+        g_stats.instance_reuses++;
+        return; // Already done
     }
 
     // Find the template
-    GenericTemplate *t = ctx->templates;
-    while (t)
-    {
-        if (strcmp(t->name, tpl) == 0)
-        {
-            break;
-        }
-        t = t->next;
-    }
+    GenericTemplate *t = find_template(ctx, tpl);
     if (!t)
     {
         zpanic_at(token, "Unknown generic: %s", tpl);
     }
 
+    g_stats.generic_instances++;
+
     // Register instantiation first (to break cycles)
     Instantiation *ni = xmalloc(sizeof(Instantiation));
-    ni->name = xstrdup(m);
-    ni->template_name = xstrdup(tpl);
+    ni->name = name;
+    ni->template_name = intern(tpl);
     ni->concrete_arg = (arg_count > 0) ? xstrdup(args[0]) : xstrdup("T");
     ni->struct_node = NULL;
     ni->next = ctx->instantiations;
     ctx->instantiations = ni;
+    intern_map_put(&ctx->instantiation_index, name, ni);
 
     if (t->struct_node->type == NODE_STRUCT)
     {
         ASTNode *i = ast_create(NODE_STRUCT);
-        i->strct.name = xstrdup(m);
+        i->strct.name = name;
         i->strct.is_template = 0;
 
         // Copy struct attributes
@@ -3318,21 +3242,13 @@ void instantiate_generic_multi(ParserContext *ctx, const char *tpl, char **args,
 
         i->next = ctx->instantiated_structs;
         ctx->instantiated_structs = i;
+        intern_map_put(&ctx->instantiated_struct_index, name, i);
     }
 }
 
 int is_file_imported(ParserContext *ctx, const char *p)
 {
-    ImportedFile *c = ctx->imported_files;
-    while (c)
-    {
-        if (strcmp(c->path, p) == 0)
-        {
-            return 1;
-        }
-        c = c->next;
-    }
-    return 0;
+    return intern_map_get(&ctx->imported_file_index, p) != NULL;
 }
 
 void mark_file_imported(ParserContext *ctx, const char *p)
@@ -3341,6 +3257,7 @@ void mark_file_imported(ParserContext *ctx, const char *p)
     f->path = xstrdup(p);
     f->next = ctx->imported_files;
     ctx->imported_files = f;
+    intern_map_put(&ctx->imported_file_index, intern(p), f);
 }
 
 char *parse_condition_raw(ParserContext *ctx, Lexer *l)
@@ -4055,7 +3972,7 @@ char *parse_and_convert_args(ParserContext *ctx, Lexer *l, char ***defaults_out,
                     else
                     {
                         st = type_new(TYPE_STRUCT);
-                        st->name = xstrdup(ctx->current_impl_struct);
+                        st->name = intern(ctx->current_impl_struct);
                     }
                     Type *pt = type_new_ptr(st);
 
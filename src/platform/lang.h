@@ -19,4 +19,13 @@ typedef SSIZE_T ssize_t;
 #define strcasecmp _stricmp
 #endif
 
+// Thread-local storage qualifier
+#if defined(_MSC_VER)
+#define ZC_THREAD_LOCAL __declspec(thread)
+#elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+#define ZC_THREAD_LOCAL _Thread_local
+#else
+#define ZC_THREAD_LOCAL __thread
+#endif
+
 #endif // ZC_PLATFORM_LANG_H
@@ -8,10 +8,24 @@
 #ifdef _WIN32
 #include <windows.h>
 #include <io.h>
+#include <direct.h>
 #include <process.h>
+#include <psapi.h>
+#include <sys/stat.h>
 #else
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/file.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
 #include <unistd.h>
 #include <time.h>
+
+extern char **environ;
 #endif
 
 void z_setup_terminal(void)
@@ -124,6 +138,104 @@ int z_get_pid(void)
 #endif
 }
 
+int z_cpu_count(void)
+{
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors > 0 ? (int)info.dwNumberOfProcessors : 1;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+#endif
+}
+
+size_t z_peak_rss(void)
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+    {
+        return pmc.PeakWorkingSetSize;
+    }
+    return 0;
+#else
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) != 0)
+    {
+        return 0;
+    }
+#ifdef __APPLE__
+    return (size_t)ru.ru_maxrss; // bytes
+#else
+    return (size_t)ru.ru_maxrss * 1024; // kilobytes
+#endif
+#endif
+}
+
+int z_mkdir(const char *path)
+{
+#ifdef _WIN32
+    return _mkdir(path);
+#else
+    return mkdir(path, 0755);
+#endif
+}
+
+int z_file_stamp(const char *path, long long *mtime, long long *size)
+{
+#ifdef _WIN32
+    struct _stat64 st;
+    if (_stat64(path, &st) != 0)
+    {
+        *mtime = -1;
+        *size = -1;
+        return -1;
+    }
+    *mtime = (long long)st.st_mtime;
+#else
+    struct stat st;
+    if (stat(path, &st) != 0)
+    {
+        *mtime = -1;
+        *size = -1;
+        return -1;
+    }
+#ifdef __linux__
+    *mtime = (long long)st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+#else
+    *mtime = (long long)st.st_mtime;
+#endif
+#endif
+    *size = (long long)st.st_size;
+    return 0;
+}
+
+int z_lock_file(FILE *f)
+{
+#ifdef _WIN32
+    OVERLAPPED at = {0};
+    HANDLE h = (HANDLE)_get_osfhandle(_fileno(f));
+    return LockFileEx(h, LOCKFILE_EXCLUSIVE_LOCK, 0, 1, 0, &at) ? 0 : -1;
+#else
+    int rc;
+    while ((rc = flock(fileno(f), LOCK_EX)) != 0 && errno == EINTR)
+    {
+    }
+    return rc;
+#endif
+}
+
+void z_unlock_file(FILE *f)
+{
+#ifdef _WIN32
+    OVERLAPPED at = {0};
+    UnlockFileEx((HANDLE)_get_osfhandle(_fileno(f)), 0, 1, 0, &at);
+#else
+    flock(fileno(f), LOCK_UN);
+#endif
+}
+
 void z_get_executable_path(char *buffer, size_t size)
 {
     memset(buffer, 0, size);
@@ -143,6 +255,138 @@ void z_get_executable_path(char *buffer, size_t size)
 #endif
 }
 
+#ifndef _WIN32
+// A pipe whose ends are not inherited by processes other threads start.
+static int cloexec_pipe(int fds[2])
+{
+    if (pipe(fds) != 0)
+    {
+        return -1;
+    }
+    fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+    fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+    return 0;
+}
+
+static void close_fd(int *fd)
+{
+    if (*fd >= 0)
+    {
+        close(*fd);
+        *fd = -1;
+    }
+}
+#endif
+
+int z_spawn(ZProcess *proc, char *const argv[], int pipe_in, int pipe_out)
+{
+#ifdef _WIN32
+    (void)proc;
+    (void)argv;
+    (void)pipe_in;
+    (void)pipe_out;
+    return -1;
+#else
+    int in[2] = {-1, -1};
+    int out[2] = {-1, -1};
+    proc->in = -1;
+    proc->out = -1;
+    if ((pipe_in && cloexec_pipe(in) != 0) || (pipe_out && cloexec_pipe(out) != 0))
+    {
+        close_fd(&in[0]);
+        close_fd(&in[1]);
+        return -1;
+    }
+
+    // The duplicated descriptors lose FD_CLOEXEC; the originals close on exec.
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    if (pipe_in)
+    {
+        posix_spawn_file_actions_adddup2(&actions, in[0], STDIN_FILENO);
+    }
+    if (pipe_out)
+    {
+        posix_spawn_file_actions_adddup2(&actions, out[1], STDOUT_FILENO);
+        posix_spawn_file_actions_adddup2(&actions, out[1], STDERR_FILENO);
+    }
+
+    // Whatever zc's own disposition, the child gets the default SIGPIPE and the
+    // caller's mask without SIGPIPE, so `zc run prog | head` still ends prog.
+    sigset_t pipe_set;
+    sigemptyset(&pipe_set);
+    sigaddset(&pipe_set, SIGPIPE);
+    pthread_sigmask(SIG_SETMASK, NULL, &proc->saved_mask);
+    sigset_t child_mask = proc->saved_mask;
+    sigdelset(&child_mask, SIGPIPE);
+    posix_spawnattr_t attr;
+    posix_spawnattr_init(&attr);
+    posix_spawnattr_setsigdefault(&attr, &pipe_set);
+    posix_spawnattr_setsigmask(&attr, &child_mask);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGDEF | POSIX_SPAWN_SETSIGMASK);
+
+    int err = posix_spawnp(&proc->pid, argv[0], &actions, &attr, argv, environ);
+    posix_spawn_file_actions_destroy(&actions);
+    posix_spawnattr_destroy(&attr);
+
+    close_fd(&in[0]);
+    close_fd(&out[1]);
+    if (err != 0)
+    {
+        close_fd(&in[1]);
+        close_fd(&out[0]);
+        return -1;
+    }
+    if (pipe_in)
+    {
+        // A child that exits early must not kill us with SIGPIPE; the
+        // failed write and its exit status report it instead.
+        pthread_sigmask(SIG_BLOCK, &pipe_set, NULL);
+    }
+    proc->in = in[1];
+    proc->out = out[0];
+    return 0;
+#endif
+}
+
+int z_wait(ZProcess *proc)
+{
+#ifdef _WIN32
+    (void)proc;
+    return -1;
+#else
+    close_fd(&proc->in);
+    close_fd(&proc->out);
+
+    // Consume a SIGPIPE our writes raised while it was blocked, then unblock it.
+    sigset_t pending;
+    sigpending(&pending);
+    if (sigismember(&pending, SIGPIPE) && !sigismember(&proc->saved_mask, SIGPIPE))
+    {
+        sigset_t pipe_set;
+        sigemptyset(&pipe_set);
+        sigaddset(&pipe_set, SIGPIPE);
+        int sig;
+        sigwait(&pipe_set, &sig);
+    }
+    pthread_sigmask(SIG_SETMASK, &proc->saved_mask, NULL);
+
+    int status;
+    while (waitpid(proc->pid, &status, 0) < 0)
+    {
+        if (errno != EINTR)
+        {
+            return -1;
+        }
+    }
+    if (WIFEXITED(status))
+    {
+        return WEXITSTATUS(status);
+    }
+    return WIFSIGNALED(status) ? 128 + WTERMSIG(status) : -1;
+#endif
+}
+
 int z_isatty(int fd)
 {
 #ifdef _WIN32
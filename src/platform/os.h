@@ -31,6 +31,7 @@
 #define getcwd _getcwd
 #else
 #include <unistd.h>
+#include <signal.h>
 #include <sys/types.h>
 #include <limits.h> /* PATH_MAX */
 #endif
@@ -138,6 +139,41 @@ const char *z_get_temp_dir(void);
  */
 int z_get_pid(void);
 
+/**
+ * @brief Number of online CPUs (at least 1).
+ */
+int z_cpu_count(void);
+
+/**
+ * @brief Peak resident set size of this process in bytes (0 if unknown).
+ */
+size_t z_peak_rss(void);
+
+/**
+ * @brief Create a directory (mode 0755 where it applies).
+ * @return 0 on success, -1 otherwise (e.g. it already exists).
+ */
+int z_mkdir(const char *path);
+
+/**
+ * @brief Modification time (nanoseconds where available) and size of a file,
+ * to notice when it changes.
+ * @return 0 on success; -1, with both set to -1, if it cannot be read.
+ */
+int z_file_stamp(const char *path, long long *mtime, long long *size);
+
+/**
+ * @brief Take an exclusive lock on an open file, waiting while another process
+ * holds it. Closing the file releases it too.
+ * @return 0 on success, -1 otherwise.
+ */
+int z_lock_file(FILE *f);
+
+/**
+ * @brief Release a lock taken by z_lock_file.
+ */
+void z_unlock_file(FILE *f);
+
 /**
  * @brief Get the path of the current executable.
  */
@@ -148,6 +184,44 @@ void z_get_executable_path(char *buffer, size_t size);
  */
 int z_isatty(int fd);
 
+/**
+ * @brief A child process started by z_spawn.
+ */
+typedef struct
+{
+#ifdef _WIN32
+    intptr_t handle; ///< Process handle.
+#else
+    pid_t pid;           ///< Process id.
+    sigset_t saved_mask; ///< Signal mask to restore once the writes to `in` are done.
+#endif
+    int in;  ///< Write end of the child's stdin, or -1 if it is inherited.
+    int out; ///< Read end of the child's stdout and stderr, or -1 if inherited.
+} ZProcess;
+
+/**
+ * @brief Start `argv[0]` (searched on PATH) without going through a shell.
+ *
+ * The child starts with SIGPIPE at its default action and unblocked. With
+ * `pipe_in`, SIGPIPE stays blocked in the calling thread until z_wait, so a
+ * child that exits early makes writes fail with EPIPE instead of killing us.
+ * Write to proc->in from the calling thread only.
+ *
+ * @param pipe_in  1 to feed the child's stdin through proc->in.
+ * @param pipe_out 1 to collect the child's stdout and stderr through proc->out.
+ * @return 0 on success, -1 if the process could not be started (always on
+ *         Windows, where callers fall back to system()).
+ */
+int z_spawn(ZProcess *proc, char *const argv[], int pipe_in, int pipe_out);
+
+/**
+ * @brief Close the remaining pipe ends and wait for the process to exit.
+ *
+ * Discards a SIGPIPE raised by writes to proc->in and restores the signal mask.
+ * @return Its exit status, 128 + the signal number if it was killed, or -1.
+ */
+int z_wait(ZProcess *proc);
+
 // Console / REPL
 void repl_enable_raw_mode(void);
 void repl_disable_raw_mode(void);
@@ -1,5 +1,6 @@
 
 #include "plugin_manager.h"
+#include "../utils/build_cache.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -48,6 +49,11 @@ ZPlugin *zptr_load_plugin(const char *path)
     {
         return NULL;
     }
+    build_cache_disable("external plugin");
+    if (z_path_last_sep(path))
+    {
+        build_cache_note_path(path); // Not searched for, so a dependency of the build.
+    }
 
     ZPluginInitFn init_fn = (ZPluginInitFn)z_dlsym(handle, "z_plugin_init");
     if (!init_fn)
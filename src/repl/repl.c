@@ -3,6 +3,7 @@
 #include "parser/parser.h"
 #include "zprep.h"
 #include "../platform/os.h"
+#include "../utils/arena.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -1156,8 +1157,14 @@ void run_repl(const char *self_path)
     int brace_depth = 0;
     int paren_depth = 0;
 
+    // In-process parses (:show, :vars, expression probing) build a throwaway
+    // ParserContext and AST. They live here and are dropped on the next prompt.
+    ZArena *scratch = arena_create("repl-scratch");
+
     while (1)
     {
+        arena_reset(scratch);
+
         char cwd[1024];
         char prompt_text[1280];
         if (getcwd(cwd, sizeof(cwd)))
@@ -1311,6 +1318,7 @@ void run_repl(const char *self_path)
                         strcat(show_code, "\n");
                     }
 
+                    ZArena *prev_arena = arena_use(scratch);
                     ParserContext ctx = {0};
                     ctx.is_repl = 1;
                     ctx.skip_preamble = 1;
@@ -1319,6 +1327,7 @@ void run_repl(const char *self_path)
                     Lexer l;
                     lexer_init(&l, show_code);
                     ASTNode *nodes = parse_program(&ctx, &l);
+                    arena_use(prev_arena);
 
                     ASTNode *search = nodes;
                     if (search && search->type == NODE_ROOT)
@@ -1710,6 +1719,7 @@ void run_repl(const char *self_path)
                     free(global_code);
                     free(main_code);
 
+                    ZArena *prev_arena = arena_use(scratch);
                     ParserContext ctx = {0};
                     ctx.is_repl = 1;
                     ctx.skip_preamble = 1;
@@ -1719,6 +1729,7 @@ void run_repl(const char *self_path)
                     Lexer l;
                     lexer_init(&l, code);
                     ASTNode *nodes = parse_program(&ctx, &l);
+                    arena_use(prev_arena);
 
                     ASTNode *search = nodes;
                     if (search && search->type == NODE_ROOT)
@@ -2366,6 +2377,7 @@ void run_repl(const char *self_path)
                 strcpy(check_buf, last_line);
                 strcat(check_buf, ";");
 
+                ZArena *prev_arena = arena_use(scratch);
                 ParserContext ctx = {0};
                 ctx.is_repl = 1;
                 ctx.skip_preamble = 1;
@@ -2374,6 +2386,7 @@ void run_repl(const char *self_path)
                 Lexer l;
                 lexer_init(&l, check_buf);
                 ASTNode *node = parse_statement(&ctx, &l);
+                arena_use(prev_arena);
                 free(check_buf);
 
                 int is_expr = 0;
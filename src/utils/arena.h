@@ -0,0 +1,91 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+/**
+ * @brief A named allocation region.
+ *
+ * Every `xmalloc`/`xcalloc`/`xrealloc` is served from the calling thread's
+ * current arena. Arenas can be switched with `arena_use`, rolled back to a
+ * mark, or reset/destroyed as a whole to return their blocks to the system.
+ */
+typedef struct ZArena ZArena;
+
+/**
+ * @brief A saved arena position (see arena_push_mark / arena_pop_mark).
+ */
+typedef struct
+{
+    struct ArenaBlock *block; ///< Block that was current when the mark was taken.
+    size_t block_used;        ///< Bytes used in that block.
+    size_t bytes_used;        ///< Arena-wide bytes used at the mark.
+} ArenaMark;
+
+/**
+ * @brief Create a new, empty arena and register it for statistics.
+ * @param name Region name shown by --mem-stats (copied).
+ */
+ZArena *arena_create(const char *name);
+
+/**
+ * @brief Release every block of the arena and unregister it.
+ */
+void arena_destroy(ZArena *a);
+
+/**
+ * @brief Release every block of the arena, keeping it usable and registered.
+ */
+void arena_reset(ZArena *a);
+
+/**
+ * @brief The process-wide default arena (first thread to allocate).
+ */
+ZArena *arena_global(void);
+
+/**
+ * @brief The calling thread's current arena.
+ *
+ * Threads other than the first one lazily get their own arena, so worker
+ * threads never share a block chain.
+ */
+ZArena *arena_current(void);
+
+/**
+ * @brief Make `a` the calling thread's current arena.
+ * @return The previously current arena, to be restored with another arena_use.
+ */
+ZArena *arena_use(ZArena *a);
+
+/**
+ * @brief Record the current position of an arena.
+ */
+ArenaMark arena_push_mark(ZArena *a);
+
+/**
+ * @brief Free everything allocated in `a` since `m` was taken.
+ */
+void arena_pop_mark(ZArena *a, ArenaMark m);
+
+/**
+ * @brief Allocate from a specific arena regardless of the current one.
+ */
+void *arena_alloc(ZArena *a, size_t size);
+
+/**
+ * @brief Bytes handed out by an arena (including allocation headers).
+ */
+size_t arena_bytes_used(ZArena *a);
+
+/**
+ * @brief Bytes handed out by all live arenas.
+ */
+size_t arena_total_bytes(void);
+
+/**
+ * @brief Print a per-region memory report (--mem-stats).
+ */
+void arena_print_stats(FILE *out);
+
+#endif
@@ -0,0 +1,1119 @@
+#include "build_cache.h"
+#include "../zprep.h"
+#include "watch.h"
+#include <dirent.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <sys/stat.h>
+#include <time.h>
+#ifdef _WIN32
+#include <sys/utime.h>
+#else
+#include <utime.h>
+#endif
+
+#define CACHE_FORMAT "zenc-cache 1"
+#define CACHE_PATH_SIZE 1024
+
+// ** Hashing (FNV-1a, 128 bit) **
+
+typedef struct
+{
+    uint64_t hi;
+    uint64_t lo;
+} CacheHash;
+
+static const CacheHash FNV128_OFFSET = {0x6c62272e07bb0142ULL, 0x62b821756295c58dULL};
+
+static void hash_update(CacheHash *h, const void *data, size_t len)
+{
+    const unsigned char *p = data;
+    uint64_t hi = h->hi;
+    uint64_t lo = h->lo;
+    for (size_t i = 0; i < len; i++)
+    {
+        lo ^= p[i];
+        // Multiply by the FNV-128 prime, 2^88 + 0x13b.
+        uint64_t a = (lo & 0xffffffffULL) * 0x13b;
+        uint64_t b = (lo >> 32) * 0x13b;
+        uint64_t new_lo = a + (b << 32);
+        uint64_t carry = (b >> 32) + (new_lo < a);
+        hi = hi * 0x13b + carry + (lo << 24);
+        lo = new_lo;
+    }
+    h->hi = hi;
+    h->lo = lo;
+}
+
+// Strings are hashed with their terminator so that adjacent fields cannot run
+// into each other; NULL hashes differently from "".
+static void hash_str(CacheHash *h, const char *s)
+{
+    if (!s)
+    {
+        hash_update(h, "\x01", 1);
+        return;
+    }
+    hash_update(h, s, strlen(s) + 1);
+}
+
+static void hash_hex(const CacheHash *h, char out[33])
+{
+    snprintf(out, 33, "%016llx%016llx", (unsigned long long)h->hi, (unsigned long long)h->lo);
+}
+
+static int hash_parse(const char *hex, CacheHash *h)
+{
+    unsigned long long hi, lo;
+    if (sscanf(hex, "%16llx%16llx", &hi, &lo) != 2)
+    {
+        return 0;
+    }
+    h->hi = hi;
+    h->lo = lo;
+    return 1;
+}
+
+static int hash_equal(const CacheHash *a, const CacheHash *b)
+{
+    return a->hi == b->hi && a->lo == b->lo;
+}
+
+// Hash of a file's contents; 0 if it cannot be read.
+static int hash_file(const char *path, CacheHash *out)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f)
+    {
+        return 0;
+    }
+    *out = FNV128_OFFSET;
+    char buf[65536];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+    {
+        hash_update(out, buf, n);
+    }
+    fclose(f);
+    return 1;
+}
+
+static void hash_env_value(const char *value, CacheHash *out)
+{
+    *out = FNV128_OFFSET;
+    hash_str(out, value);
+}
+
+// Size and modification time stand in for the contents of large binaries
+// (zc itself, the backend compiler).
+static void hash_file_identity(CacheHash *h, const char *path)
+{
+    struct stat st;
+    if (path && stat(path, &st) == 0)
+    {
+        long long id[2] = {(long long)st.st_size, (long long)st.st_mtime};
+        hash_update(h, id, sizeof(id));
+    }
+}
+
+// Hash the backend compiler: its name and the executable found on PATH.
+static void hash_program(CacheHash *h, const char *command)
+{
+    char prog[256];
+    size_t n = strcspn(command, " ");
+    if (n >= sizeof(prog))
+    {
+        n = sizeof(prog) - 1;
+    }
+    memcpy(prog, command, n);
+    prog[n] = 0;
+    hash_str(h, command);
+
+    if (strchr(prog, '/') || strchr(prog, '\\'))
+    {
+        hash_file_identity(h, prog);
+        return;
+    }
+
+    const char *path = getenv("PATH");
+    const char sep = z_is_windows() ? ';' : ':';
+    while (path && *path)
+    {
+        const char *end = strchr(path, sep);
+        size_t len = end ? (size_t)(end - path) : strlen(path);
+        char candidate[CACHE_PATH_SIZE];
+        struct stat st;
+        snprintf(candidate, sizeof(candidate), "%.*s/%s%s", (int)len, path, prog,
+                 z_get_exe_ext());
+        if (len > 0 && stat(candidate, &st) == 0)
+        {
+            hash_file_identity(h, candidate);
+            return;
+        }
+        path = end ? end + 1 : NULL;
+    }
+}
+
+// ** Recorded inputs **
+
+typedef struct
+{
+    char *name;     ///< File path, or environment variable name.
+    int is_env;     ///< 1 for an environment variable.
+    CacheHash hash; ///< Hash of the contents (or the variable's value).
+} CacheInput;
+
+static struct
+{
+    int active;             ///< Recording inputs for this build.
+    const char *off_reason; ///< Why the build cannot be cached (NULL if it can).
+    CacheInput *inputs;     ///< Inputs in the order they were first read.
+    int count;              ///< Number of inputs.
+    int cap;                ///< Capacity of `inputs`.
+    int have_key;           ///< 1 once `key` was computed.
+    char key[33];           ///< Manifest key (compiler, flags, command line).
+} cache;
+
+static atomic_flag cache_lock = ATOMIC_FLAG_INIT;
+
+static void cache_acquire(void)
+{
+    while (atomic_flag_test_and_set_explicit(&cache_lock, memory_order_acquire))
+    {
+    }
+}
+
+static void cache_release(void)
+{
+    atomic_flag_clear_explicit(&cache_lock, memory_order_release);
+}
+
+static void add_input(const char *name, int is_env, const CacheHash *hash)
+{
+    cache_acquire();
+    for (int i = 0; i < cache.count; i++)
+    {
+        if (cache.inputs[i].is_env == is_env && strcmp(cache.inputs[i].name, name) == 0)
+        {
+            cache_release();
+            return;
+        }
+    }
+    if (cache.count == cache.cap)
+    {
+        cache.cap = cache.cap ? cache.cap * 2 : 64;
+        cache.inputs = xrealloc(cache.inputs, sizeof(CacheInput) * cache.cap);
+    }
+    CacheInput *in = &cache.inputs[cache.count++];
+    in->name = xstrdup(name);
+    in->is_env = is_env;
+    in->hash = *hash;
+    cache_release();
+}
+
+// ** Dependency file (-MD) **
+
+static struct
+{
+    char **paths; ///< Files read, in the order they were first read.
+    int count;    ///< Number of paths.
+    int cap;      ///< Capacity of `paths`.
+} deps;
+
+// Report a file the build read to `zc watch` and the -MD dependency list.
+static void note_input(const char *path)
+{
+    watch_note_input(path);
+    if (!g_config.dep_file)
+    {
+        return;
+    }
+    cache_acquire();
+    for (int i = 0; i < deps.count; i++)
+    {
+        if (strcmp(deps.paths[i], path) == 0)
+        {
+            cache_release();
+            return;
+        }
+    }
+    if (deps.count == deps.cap)
+    {
+        deps.cap = deps.cap ? deps.cap * 2 : 64;
+        deps.paths = xrealloc(deps.paths, sizeof(char *) * deps.cap);
+    }
+    deps.paths[deps.count++] = xstrdup(path);
+    cache_release();
+}
+
+// Write `path` as a make target or prerequisite.
+static void write_make_path(FILE *f, const char *path)
+{
+    for (const char *p = path; *p; p++)
+    {
+        if (*p == ' ' || *p == '\t' || *p == '#')
+        {
+            fputc('\\', f);
+        }
+        else if (*p == '$')
+        {
+            fputc('$', f);
+        }
+        fputc(*p, f);
+    }
+}
+
+int build_cache_write_depfile(const char *target)
+{
+    if (!g_config.dep_file)
+    {
+        return 0;
+    }
+    char path[CACHE_PATH_SIZE];
+    if (g_config.dep_output)
+    {
+        snprintf(path, sizeof(path), "%s", g_config.dep_output);
+    }
+    else
+    {
+        // Like the C compiler: the output with its extension replaced by .d.
+        snprintf(path, sizeof(path), "%s", target);
+        char *dot = strrchr(path, '.');
+        char *sep = z_path_last_sep(path);
+        if (dot && (!sep || dot > sep + 1))
+        {
+            *dot = 0;
+        }
+        strncat(path, ".d", sizeof(path) - strlen(path) - 1);
+    }
+
+    // Write and rename, so a build tool never reads half a file.
+    char tmp[CACHE_PATH_SIZE + 32];
+    snprintf(tmp, sizeof(tmp), "%s.tmp%d", path, z_get_pid());
+    FILE *f = fopen(tmp, "w");
+    if (!f)
+    {
+        fprintf(stderr,
+                COLOR_BOLD COLOR_RED "error" COLOR_RESET ": could not write dependency file '%s'\n",
+                path);
+        return -1;
+    }
+    write_make_path(f, target);
+    fputc(':', f);
+    for (int i = 0; i < deps.count; i++)
+    {
+        fputs(" \\\n ", f);
+        write_make_path(f, deps.paths[i]);
+    }
+    fputc('\n', f);
+    for (int i = 0; g_config.dep_phony && i < deps.count; i++)
+    {
+        fputc('\n', f);
+        write_make_path(f, deps.paths[i]);
+        fputs(":\n", f);
+    }
+    if (fclose(f) != 0 || (remove(path), rename(tmp, path)) != 0)
+    {
+        remove(tmp);
+        fprintf(stderr,
+                COLOR_BOLD COLOR_RED "error" COLOR_RESET ": could not write dependency file '%s'\n",
+                path);
+        return -1;
+    }
+    return 0;
+}
+
+void build_cache_begin(void)
+{
+    cache.active = 1;
+}
+
+int build_cache_active(void)
+{
+    return cache.active && !cache.off_reason;
+}
+
+void build_cache_note_file(const char *path, const char *data, size_t len)
+{
+    note_input(path);
+    if (!build_cache_active())
+    {
+        return;
+    }
+    CacheHash h = FNV128_OFFSET;
+    hash_update(&h, data, len);
+    add_input(path, 0, &h);
+}
+
+void build_cache_note_path(const char *path)
+{
+    note_input(path);
+    if (!build_cache_active())
+    {
+        return;
+    }
+    CacheHash h;
+    if (!hash_file(path, &h))
+    {
+        build_cache_disable("an input file could not be read");
+        return;
+    }
+    add_input(path, 0, &h);
+}
+
+void build_cache_note_env(const char *name, const char *value)
+{
+    if (!build_cache_active())
+    {
+        return;
+    }
+    CacheHash h;
+    hash_env_value(value, &h);
+    add_input(name, 1, &h);
+}
+
+void build_cache_disable(const char *reason)
+{
+    if (cache.active && !cache.off_reason)
+    {
+        cache.off_reason = reason;
+        if (g_config.verbose)
+        {
+            printf(COLOR_BOLD COLOR_BLUE "       Cache" COLOR_RESET " disabled: %s\n", reason);
+        }
+    }
+}
+
+// ** Cache directory **
+
+static const char *cache_dir(void)
+{
+    static char dir[CACHE_PATH_SIZE];
+    if (dir[0])
+    {
+        return dir;
+    }
+
+    const char *xdg = getenv("XDG_CACHE_HOME");
+    const char *home = getenv("HOME");
+#ifdef _WIN32
+    const char *local = getenv("LOCALAPPDATA");
+#else
+    const char *local = NULL;
+#endif
+    if (xdg && *xdg)
+    {
+        snprintf(dir, sizeof(dir), "%s/zenc", xdg);
+    }
+    else if (local && *local)
+    {
+        snprintf(dir, sizeof(dir), "%s/zenc", local);
+    }
+    else if (home && *home)
+    {
+        snprintf(dir, sizeof(dir), "%s/.cache/zenc", home);
+    }
+    else
+    {
+        snprintf(dir, sizeof(dir), "%s/zenc-cache", z_get_temp_dir());
+    }
+    return dir;
+}
+
+// Create `path` and its missing parents.
+static int mkdir_parents(const char *path)
+{
+    char buf[CACHE_PATH_SIZE];
+    snprintf(buf, sizeof(buf), "%s", path);
+    for (char *p = buf + 1; *p; p++)
+    {
+        if (*p == '/' || *p == '\\')
+        {
+            char c = *p;
+            *p = 0;
+            z_mkdir(buf);
+            *p = c;
+        }
+    }
+    z_mkdir(buf);
+    struct stat st;
+    return stat(buf, &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+static void manifest_path(char *out, size_t size, const char *key)
+{
+    snprintf(out, size, "%s/manifests/%.2s/%s", cache_dir(), key, key + 2);
+}
+
+static void object_path(char *out, size_t size, const char *hex)
+{
+    snprintf(out, size, "%s/objects/%.2s/%s", cache_dir(), hex, hex + 2);
+}
+
+// Copy a file, keeping the executable bits. Writes to a temporary name and
+// renames it, so readers never see a partial file.
+static int copy_file(const char *from, const char *to)
+{
+    FILE *in = fopen(from, "rb");
+    if (!in)
+    {
+        return 0;
+    }
+    char tmp[CACHE_PATH_SIZE];
+    snprintf(tmp, sizeof(tmp), "%s.tmp%d", to, z_get_pid());
+    FILE *out = fopen(tmp, "wb");
+    if (!out)
+    {
+        fclose(in);
+        return 0;
+    }
+
+    char buf[65536];
+    size_t n;
+    int ok = 1;
+    while ((n = fread(buf, 1, sizeof(buf), in)) > 0)
+    {
+        if (fwrite(buf, 1, n, out) != n)
+        {
+            ok = 0;
+            break;
+        }
+    }
+    fclose(in);
+    if (fclose(out) != 0)
+    {
+        ok = 0;
+    }
+
+    struct stat st;
+    if (ok && stat(from, &st) == 0)
+    {
+        chmod(tmp, st.st_mode & 0777);
+    }
+    remove(to);
+    if (!ok || rename(tmp, to) != 0)
+    {
+        remove(tmp);
+        return 0;
+    }
+    return 1;
+}
+
+// ** Counters (hits / misses / stores) **
+
+typedef struct
+{
+    long hits;
+    long misses;
+    long stores;
+} CacheCounters;
+
+static void read_counters(CacheCounters *c)
+{
+    memset(c, 0, sizeof(*c));
+    char path[CACHE_PATH_SIZE];
+    snprintf(path, sizeof(path), "%s/stats", cache_dir());
+    FILE *f = fopen(path, "r");
+    if (f)
+    {
+        if (fscanf(f, "hits %ld misses %ld stores %ld", &c->hits, &c->misses, &c->stores) != 3)
+        {
+            memset(c, 0, sizeof(*c));
+        }
+        fclose(f);
+    }
+}
+
+static void add_counters(long hits, long misses, long stores)
+{
+    char path[CACHE_PATH_SIZE];
+    snprintf(path, sizeof(path), "%s/stats.lock", cache_dir());
+    mkdir_parents(cache_dir());
+    // Builds running at the same time update the counters in turn, so none is
+    // lost; the write and rename keep `zc cache stats` from reading half a file.
+    FILE *lock = fopen(path, "a");
+    if (!lock || z_lock_file(lock) != 0)
+    {
+        if (lock)
+        {
+            fclose(lock);
+        }
+        return;
+    }
+
+    CacheCounters c;
+    read_counters(&c);
+    c.hits += hits;
+    c.misses += misses;
+    c.stores += stores;
+
+    snprintf(path, sizeof(path), "%s/stats", cache_dir());
+    char tmp[CACHE_PATH_SIZE + 32];
+    snprintf(tmp, sizeof(tmp), "%s.tmp%d", path, z_get_pid());
+    FILE *f = fopen(tmp, "w");
+    if (f)
+    {
+        fprintf(f, "hits %ld\nmisses %ld\nstores %ld\n", c.hits, c.misses, c.stores);
+        if (fclose(f) != 0 || (remove(path), rename(tmp, path)) != 0)
+        {
+            remove(tmp);
+        }
+    }
+    z_unlock_file(lock);
+    fclose(lock);
+}
+
+// ** Lookup and store **
+
+// Everything that is not an input file but changes the output.
+static void compute_key(void)
+{
+    if (cache.have_key)
+    {
+        return;
+    }
+
+    CacheHash h = FNV128_OFFSET;
+    hash_str(&h, CACHE_FORMAT);
+    hash_str(&h, ZEN_VERSION);
+    char exe[CACHE_PATH_SIZE];
+    z_get_executable_path(exe, sizeof(exe));
+    hash_file_identity(&h, exe);
+    hash_program(&h, g_config.cc);
+
+    hash_str(&h, g_config.gcc_flags);
+    hash_str(&h, g_cflags);
+    hash_str(&h, g_link_flags);
+    int modes[] = {g_config.is_freestanding, g_config.use_cpp, g_config.use_cuda,
+                   g_config.use_objc, g_config.use_typecheck, g_config.split_units,
+                   g_config.release};
+    hash_update(&h, modes, sizeof(modes));
+
+    char cwd[CACHE_PATH_SIZE];
+    hash_str(&h, getcwd(cwd, sizeof(cwd)));
+    hash_str(&h, getenv("ZC_ROOT"));
+    hash_str(&h, g_config.input_file);
+    for (int i = 0; i < g_config.extra_file_count; i++)
+    {
+        hash_str(&h, g_config.extra_files[i]);
+    }
+
+    hash_hex(&h, cache.key);
+    cache.have_key = 1;
+}
+
+// The object name: the key plus every input and the hash of its contents.
+static void object_hash(CacheHash *h, const CacheInput *inputs, int count)
+{
+    *h = FNV128_OFFSET;
+    hash_str(h, cache.key);
+    for (int i = 0; i < count; i++)
+    {
+        hash_update(h, &inputs[i].is_env, sizeof(int));
+        hash_str(h, inputs[i].name);
+        hash_update(h, &inputs[i].hash, sizeof(CacheHash));
+    }
+}
+
+// Read a manifest and check its inputs against the files as they are now.
+// Returns the number of inputs, or -1 if the manifest is missing or stale.
+static int load_manifest(const char *path, CacheInput **out)
+{
+    FILE *f = fopen(path, "r");
+    if (!f)
+    {
+        return -1;
+    }
+
+    char line[CACHE_PATH_SIZE + 64];
+    if (!fgets(line, sizeof(line), f) || strncmp(line, CACHE_FORMAT, strlen(CACHE_FORMAT)) != 0)
+    {
+        fclose(f);
+        return -1;
+    }
+
+    CacheInput *inputs = NULL;
+    int count = 0;
+    int cap = 0;
+    int fresh = 1;
+    while (fresh && fgets(line, sizeof(line), f))
+    {
+        line[strcspn(line, "\r\n")] = 0;
+        // "<hash> f <path>" or "<hash> e <NAME>"
+        CacheInput in;
+        if (strlen(line) < 36 || !hash_parse(line, &in.hash) || line[33] == 0)
+        {
+            fresh = 0;
+            break;
+        }
+        in.is_env = line[33] == 'e';
+        in.name = xstrdup(line + 35);
+
+        CacheHash now;
+        if (in.is_env)
+        {
+            hash_env_value(getenv(in.name), &now);
+        }
+        else if (!hash_file(in.name, &now))
+        {
+            fresh = 0;
+            break;
+        }
+        if (!hash_equal(&now, &in.hash))
+        {
+            fresh = 0;
+            break;
+        }
+
+        if (count == cap)
+        {
+            cap = cap ? cap * 2 : 64;
+            inputs = xrealloc(inputs, sizeof(CacheInput) * cap);
+        }
+        inputs[count++] = in;
+    }
+    fclose(f);
+
+    *out = inputs;
+    return fresh ? count : -1;
+}
+
+int build_cache_lookup(const char *outfile)
+{
+    if (!build_cache_active())
+    {
+        return 0;
+    }
+    compute_key();
+
+    char path[CACHE_PATH_SIZE];
+    manifest_path(path, sizeof(path), cache.key);
+    CacheInput *inputs = NULL;
+    int count = load_manifest(path, &inputs);
+    if (count >= 0)
+    {
+        CacheHash h;
+        char hex[33];
+        object_hash(&h, inputs, count);
+        hash_hex(&h, hex);
+        object_path(path, sizeof(path), hex);
+        if (copy_file(path, outfile))
+        {
+            for (int i = 0; i < count; i++)
+            {
+                if (!inputs[i].is_env)
+                {
+                    note_input(inputs[i].name); // The hit skips reading them.
+                }
+            }
+            utime(path, NULL); // Mark as recently used for prune.
+            add_counters(1, 0, 0);
+            return 1;
+        }
+    }
+    add_counters(0, 1, 0);
+    return 0;
+}
+
+void build_cache_store(const char *outfile)
+{
+    if (!build_cache_active())
+    {
+        return;
+    }
+    compute_key();
+
+    CacheHash h;
+    char hex[33];
+    char path[CACHE_PATH_SIZE];
+    object_hash(&h, cache.inputs, cache.count);
+    hash_hex(&h, hex);
+
+    object_path(path, sizeof(path), hex);
+    *z_path_last_sep(path) = 0;
+    if (!mkdir_parents(path))
+    {
+        return;
+    }
+    object_path(path, sizeof(path), hex);
+    if (!copy_file(outfile, path))
+    {
+        return;
+    }
+
+    // Write the manifest last: it only ever points at a complete object.
+    manifest_path(path, sizeof(path), cache.key);
+    *z_path_last_sep(path) = 0;
+    if (!mkdir_parents(path))
+    {
+        return;
+    }
+    manifest_path(path, sizeof(path), cache.key);
+    char tmp[CACHE_PATH_SIZE + 32];
+    snprintf(tmp, sizeof(tmp), "%s.tmp%d", path, z_get_pid());
+    FILE *f = fopen(tmp, "w");
+    if (!f)
+    {
+        return;
+    }
+    fprintf(f, "%s\n", CACHE_FORMAT);
+    for (int i = 0; i < cache.count; i++)
+    {
+        hash_hex(&cache.inputs[i].hash, hex);
+        fprintf(f, "%s %c %s\n", hex, cache.inputs[i].is_env ? 'e' : 'f', cache.inputs[i].name);
+    }
+    fclose(f);
+    remove(path);
+    if (rename(tmp, path) != 0)
+    {
+        remove(tmp);
+        return;
+    }
+    add_counters(0, 0, 1);
+}
+
+// ** Precompiled headers **
+
+int build_cache_pch(const char *text, const char *command, const char *ext, char *header,
+                    size_t size)
+{
+    CacheHash h = FNV128_OFFSET;
+    char hex[33];
+    hash_str(&h, CACHE_FORMAT);
+    hash_program(&h, g_config.cc);
+    hash_str(&h, command);
+    hash_str(&h, text);
+    hash_hex(&h, hex);
+
+    char dir[CACHE_PATH_SIZE];
+    snprintf(dir, sizeof(dir), "%s/pch/%.2s", cache_dir(), hex);
+    if (!mkdir_parents(dir))
+    {
+        return -1;
+    }
+    snprintf(header, size, "%s/%s.h", dir, hex + 2);
+
+    char pch[CACHE_PATH_SIZE + 64];
+    struct stat st;
+    snprintf(pch, sizeof(pch), "%s%s", header, ext);
+    if (stat(header, &st) == 0 && stat(pch, &st) == 0)
+    {
+        utime(pch, NULL); // Mark as recently used for prune.
+        return 1;
+    }
+
+    char tmp[CACHE_PATH_SIZE + 32];
+    snprintf(tmp, sizeof(tmp), "%s.tmp%d", header, z_get_pid());
+    FILE *f = fopen(tmp, "w");
+    if (!f)
+    {
+        return -1;
+    }
+    fputs(text, f);
+    if (fclose(f) != 0 || (remove(header), rename(tmp, header)) != 0)
+    {
+        remove(tmp);
+        return -1;
+    }
+    return 0;
+}
+
+// ** C header scans **
+
+// Keyed by path as well as contents: the nested includes a scan records are
+// resolved relative to the header.
+static void header_scan_path(char *out, size_t size, const char *path, const char *src)
+{
+    CacheHash h = FNV128_OFFSET;
+    char hex[33];
+    hash_str(&h, CACHE_FORMAT);
+    hash_str(&h, path);
+    hash_str(&h, src);
+    hash_hex(&h, hex);
+    snprintf(out, size, "%s/headers/%.2s/%s", cache_dir(), hex, hex + 2);
+}
+
+char *build_cache_header_scan(const char *path, const char *src, size_t *len)
+{
+    if (g_config.no_cache)
+    {
+        return NULL;
+    }
+    char file[CACHE_PATH_SIZE];
+    header_scan_path(file, sizeof(file), path, src);
+    FILE *f = fopen(file, "rb");
+    if (!f)
+    {
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    rewind(f);
+    char *data = size >= 0 ? xmalloc(size + 1) : NULL;
+    if (!data || fread(data, 1, size, f) != (size_t)size)
+    {
+        fclose(f);
+        return NULL;
+    }
+    fclose(f);
+    data[size] = 0;
+    *len = (size_t)size;
+    utime(file, NULL); // Mark as recently used for prune.
+    return data;
+}
+
+void build_cache_store_header_scan(const char *path, const char *src, const char *data,
+                                   size_t len)
+{
+    if (g_config.no_cache)
+    {
+        return;
+    }
+    char file[CACHE_PATH_SIZE];
+    header_scan_path(file, sizeof(file), path, src);
+    *z_path_last_sep(file) = 0;
+    if (!mkdir_parents(file))
+    {
+        return;
+    }
+    header_scan_path(file, sizeof(file), path, src);
+
+    char tmp[CACHE_PATH_SIZE + 32];
+    snprintf(tmp, sizeof(tmp), "%s.tmp%d", file, z_get_pid());
+    FILE *f = fopen(tmp, "wb");
+    if (!f)
+    {
+        return;
+    }
+    int ok = fwrite(data, 1, len, f) == len;
+    if (fclose(f) != 0 || !ok || (remove(file), rename(tmp, file)) != 0)
+    {
+        remove(tmp);
+    }
+}
+
+// ** Profiles **
+
+int build_cache_profile_dir(const char *outfile, char *dir, size_t size)
+{
+    CacheHash h = FNV128_OFFSET;
+    char hex[33];
+    char cwd[CACHE_PATH_SIZE];
+    hash_str(&h, getcwd(cwd, sizeof(cwd)));
+    hash_str(&h, outfile);
+    hash_hex(&h, hex);
+
+    snprintf(dir, size, "%s/pgo/%s", cache_dir(), hex);
+    return mkdir_parents(dir) ? 0 : -1;
+}
+
+// ** zc cache **
+
+typedef struct
+{
+    char *path;
+    long long size;
+    time_t mtime;
+} CacheFile;
+
+typedef struct
+{
+    CacheFile *files;
+    int count;
+    int cap;
+} CacheListing;
+
+// List the files of <cache>/<sub>/<xx>/.
+static void list_entries(const char *sub, CacheListing *out)
+{
+    char dir[CACHE_PATH_SIZE];
+    snprintf(dir, sizeof(dir), "%s/%s", cache_dir(), sub);
+    DIR *d = opendir(dir);
+    if (!d)
+    {
+        return;
+    }
+    struct dirent *shard;
+    while ((shard = readdir(d)) != NULL)
+    {
+        if (shard->d_name[0] == '.')
+        {
+            continue;
+        }
+        char shard_dir[CACHE_PATH_SIZE + 256];
+        snprintf(shard_dir, sizeof(shard_dir), "%s/%s", dir, shard->d_name);
+        DIR *sd = opendir(shard_dir);
+        if (!sd)
+        {
+            continue;
+        }
+        struct dirent *e;
+        while ((e = readdir(sd)) != NULL)
+        {
+            char path[CACHE_PATH_SIZE + 512];
+            struct stat st;
+            snprintf(path, sizeof(path), "%s/%s", shard_dir, e->d_name);
+            if (e->d_name[0] == '.' || stat(path, &st) != 0 || !S_ISREG(st.st_mode))
+            {
+                continue;
+            }
+            if (out->count == out->cap)
+            {
+                out->cap = out->cap ? out->cap * 2 : 256;
+                out->files = xrealloc(out->files, sizeof(CacheFile) * out->cap);
+            }
+            out->files[out->count++] = (CacheFile){xstrdup(path), st.st_size, st.st_mtime};
+        }
+        closedir(sd);
+    }
+    closedir(d);
+}
+
+static long long listing_size(const CacheListing *l)
+{
+    long long total = 0;
+    for (int i = 0; i < l->count; i++)
+    {
+        total += l->files[i].size;
+    }
+    return total;
+}
+
+static int older_first(const void *a, const void *b)
+{
+    const CacheFile *x = a;
+    const CacheFile *y = b;
+    return (x->mtime > y->mtime) - (x->mtime < y->mtime);
+}
+
+static int cache_stats(void)
+{
+    CacheListing objects = {0};
+    CacheListing manifests = {0};
+    CacheListing headers = {0};
+    CacheListing scans = {0};
+    CacheCounters c;
+    list_entries("objects", &objects);
+    list_entries("manifests", &manifests);
+    list_entries("pch", &headers);
+    list_entries("headers", &scans);
+    read_counters(&c);
+
+    printf(COLOR_BOLD "Build cache:" COLOR_RESET " %s\n", cache_dir());
+    printf("  %-16s %12d\n", "entries", objects.count);
+    printf("  %-16s %12d\n", "manifests", manifests.count);
+    printf("  %-16s %12d\n", "pch files", headers.count);
+    printf("  %-16s %12d\n", "header scans", scans.count);
+    long long size = listing_size(&objects) + listing_size(&manifests) + listing_size(&headers) +
+                     listing_size(&scans);
+    printf("  %-16s %9.1f MB\n", "size", size / 1048576.0);
+    printf("  %-16s %12ld\n", "hits", c.hits);
+    printf("  %-16s %12ld\n", "misses", c.misses);
+    printf("  %-16s %12ld\n", "stores", c.stores);
+    return 0;
+}
+
+// Drop entries unused for `max_age_days`, then the least recently used ones
+// until the cache fits in `max_mb`.
+static int cache_prune(int all, long max_mb, long max_age_days)
+{
+    CacheListing objects = {0};
+    CacheListing manifests = {0};
+    list_entries("objects", &objects);
+    list_entries("pch", &objects); // Precompiled headers and header scans age like objects.
+    list_entries("headers", &objects);
+    list_entries("manifests", &manifests);
+
+    time_t cutoff = time(NULL) - (time_t)max_age_days * 24 * 60 * 60;
+    long long limit = (long long)max_mb * 1048576;
+    long long size = listing_size(&objects) + listing_size(&manifests);
+    long long freed = 0;
+    int removed = 0;
+
+    qsort(objects.files, objects.count, sizeof(CacheFile), older_first);
+    for (int i = 0; i < objects.count; i++)
+    {
+        CacheFile *e = &objects.files[i];
+        if ((all || e->mtime < cutoff || size - freed > limit) && remove(e->path) == 0)
+        {
+            freed += e->size;
+            removed++;
+        }
+    }
+    // A manifest whose object is gone is only a miss; drop old or all ones.
+    for (int i = 0; i < manifests.count; i++)
+    {
+        CacheFile *e = &manifests.files[i];
+        if ((all || e->mtime < cutoff) && remove(e->path) == 0)
+        {
+            freed += e->size;
+        }
+    }
+    if (all)
+    {
+        char path[CACHE_PATH_SIZE];
+        snprintf(path, sizeof(path), "%s/stats", cache_dir());
+        remove(path);
+    }
+
+    printf(COLOR_BOLD COLOR_GREEN "      Pruned" COLOR_RESET " %d entr%s, %.1f MB freed\n", removed,
+           removed == 1 ? "y" : "ies", freed / 1048576.0);
+    return 0;
+}
+
+static void cache_usage(void)
+{
+    printf("Usage: zc cache <stats|prune> [options]\n");
+    printf("  " COLOR_GREEN "stats" COLOR_RESET "        Show cache location, size and hit rate\n");
+    printf("  " COLOR_GREEN "prune" COLOR_RESET "        Remove old entries\n");
+    printf("      " COLOR_CYAN "--max-size" COLOR_RESET
+           " <MB>   Size to shrink to (default: 1024)\n");
+    printf("      " COLOR_CYAN "--max-age" COLOR_RESET
+           " <days>  Drop entries unused this long (default: 30)\n");
+    printf("      " COLOR_CYAN "--all" COLOR_RESET "            Remove everything\n");
+}
+
+int build_cache_main(int argc, char **argv)
+{
+    // argv: zc cache <command> [options]
+    if (argc < 3)
+    {
+        cache_usage();
+        return 1;
+    }
+
+    if (strcmp(argv[2], "stats") == 0)
+    {
+        return cache_stats();
+    }
+    if (strcmp(argv[2], "prune") == 0)
+    {
+        int all = 0;
+        long max_mb = 1024;
+        long max_age = 30;
+        for (int i = 3; i < argc; i++)
+        {
+            if (strcmp(argv[i], "--all") == 0)
+            {
+                all = 1;
+            }
+            else if (strcmp(argv[i], "--max-size") == 0 && i + 1 < argc)
+            {
+                max_mb = atol(argv[++i]);
+            }
+            else if (strcmp(argv[i], "--max-age") == 0 && i + 1 < argc)
+            {
+                max_age = atol(argv[++i]);
+            }
+            else
+            {
+                cache_usage();
+                return 1;
+            }
+        }
+        return cache_prune(all, max_mb, max_age);
+    }
+
+    cache_usage();
+    return 1;
+}
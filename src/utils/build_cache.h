@@ -0,0 +1,121 @@
+#ifndef BUILD_CACHE_H
+#define BUILD_CACHE_H
+
+#include <stddef.h>
+
+/**
+ * @brief Content-addressed cache of built executables (zc build / zc run).
+ *
+ * Entries live under $XDG_CACHE_HOME/zenc (~/.cache/zenc, or %LOCALAPPDATA%\zenc
+ * on Windows). A manifest, keyed by the compiler, backend, flags and command
+ * line, lists every file the compiler read (sources, imports, C headers it
+ * scanned, embedded files) and environment variables expanded in build
+ * directives, each with the hash of its content. The output is stored under
+ * the hash of the manifest key and those contents, so a lookup only re-hashes
+ * the listed inputs and skips both transpilation and the C compile on a hit.
+ *
+ * Builds that depend on state the cache cannot see (comptime blocks, external
+ * plugins, shell:/get:/pkg-config: directives) are never stored.
+ *
+ * The cache also keeps precompiled headers of the generated preamble under
+ * pch/ (see build_cache_pch), the declarations found in local C headers under
+ * headers/ (see build_cache_header_scan) and profile data of --pgo-gen builds
+ * under pgo/.
+ */
+
+/**
+ * @brief Start recording the inputs of this build.
+ */
+void build_cache_begin(void);
+
+/**
+ * @brief 1 between build_cache_begin and the end of a cacheable build.
+ */
+int build_cache_active(void);
+
+/**
+ * @brief Record that the build read `path` with contents `data` (any thread).
+ * Also reports the file to `zc watch` and the -MD dependency file.
+ */
+void build_cache_note_file(const char *path, const char *data, size_t len);
+
+/**
+ * @brief Write the files this build read as a make rule for `target` (-MD).
+ *
+ * The rule goes to the -MF file, or to `target` with its extension replaced
+ * by .d. It lists the files recorded with build_cache_note_file and
+ * build_cache_note_path (or, on a hit, the inputs of the cached build). Does
+ * nothing without -MD.
+ * @return 0 on success, -1 if the file could not be written.
+ */
+int build_cache_write_depfile(const char *target);
+
+/**
+ * @brief Record a file the backend compiler reads (e.g. extra C sources).
+ */
+void build_cache_note_path(const char *path);
+
+/**
+ * @brief Record that the build used environment variable `name` (NULL value if unset).
+ */
+void build_cache_note_env(const char *name, const char *value);
+
+/**
+ * @brief Keep this build out of the cache.
+ * @param reason Shown with --verbose.
+ */
+void build_cache_disable(const char *reason);
+
+/**
+ * @brief Look the build up and, on a hit, copy the cached output to `outfile`.
+ * @return 1 on a hit, 0 otherwise.
+ */
+int build_cache_lookup(const char *outfile);
+
+/**
+ * @brief Store `outfile` as the result of the recorded inputs.
+ */
+void build_cache_store(const char *outfile);
+
+/**
+ * @brief Find the cached precompiled header for `text`, or prepare to build it.
+ *
+ * Entries are keyed by `text`, the backend compiler executable and `command`
+ * (the flags the header is built with, which the compiler checks on use).
+ * @param ext    Extension of the precompiled file (".gch" or ".pch").
+ * @param header Receives the path of the cached header; the precompiled file
+ *               is `header` followed by `ext`.
+ * @return 1 if the precompiled file exists, 0 if the header was written and the
+ *         caller must build it, -1 on error.
+ */
+int build_cache_pch(const char *text, const char *command, const char *ext, char *header,
+                    size_t size);
+
+/**
+ * @brief The stored scan of the C header `path` with contents `src`, or NULL.
+ *
+ * The scan is opaque data produced by scan_c_header_contents. Nothing is
+ * looked up with --no-cache.
+ * @param len Receives the size of the returned data.
+ */
+char *build_cache_header_scan(const char *path, const char *src, size_t *len);
+
+/**
+ * @brief Store the scan of the C header `path` with contents `src`.
+ */
+void build_cache_store_header_scan(const char *path, const char *src, const char *data,
+                                   size_t len);
+
+/**
+ * @brief Directory for the profile data of the program built to `outfile` in
+ * the current directory (--pgo-gen / --pgo-use), created if needed.
+ * @return 0 on success, -1 on error.
+ */
+int build_cache_profile_dir(const char *outfile, char *dir, size_t size);
+
+/**
+ * @brief Entry point of `zc cache stats|prune`.
+ */
+int build_cache_main(int argc, char **argv);
+
+#endif
@@ -38,11 +38,10 @@ void cmd_add(CmdBuilder *cmd, const char *str)
 
     if (cmd->len > 0 && cmd->buf[cmd->len - 1] != ' ')
     {
-        strcat(cmd->buf, " ");
-        cmd->len++;
+        cmd->buf[cmd->len++] = ' ';
     }
 
-    strcat(cmd->buf, str);
+    memcpy(cmd->buf + cmd->len, str, len + 1);
     cmd->len += len;
 }
 
@@ -65,8 +64,7 @@ void cmd_add_fmt(CmdBuilder *cmd, const char *fmt, ...)
 
     if (cmd->len > 0 && cmd->buf[cmd->len - 1] != ' ')
     {
-        strcat(cmd->buf, " ");
-        cmd->len++;
+        cmd->buf[cmd->len++] = ' ';
     }
 
     va_start(args, fmt);
@@ -88,3 +86,81 @@ const char *cmd_to_string(CmdBuilder *cmd)
 {
     return cmd->buf;
 }
+
+char **cmd_split_argv(const char *command)
+{
+    size_t len = strlen(command);
+    char *word = xmalloc(len + 1); // Unquoted words are never longer.
+    char **argv = xmalloc(sizeof(char *) * (len / 2 + 2));
+    int argc = 0;
+    const char *p = command;
+
+    while (1)
+    {
+        while (*p == ' ' || *p == '\t' || *p == '\n')
+        {
+            p++;
+        }
+        if (!*p)
+        {
+            break;
+        }
+        if (*p == '#' || *p == '~')
+        {
+            return NULL; // Comment or home directory expansion.
+        }
+
+        size_t n = 0;
+        while (*p && *p != ' ' && *p != '\t' && *p != '\n')
+        {
+            char c = *p++;
+            if (c == '\'')
+            {
+                while (*p && *p != '\'')
+                {
+                    word[n++] = *p++;
+                }
+                if (!*p++)
+                {
+                    return NULL;
+                }
+            }
+            else if (c == '"')
+            {
+                while (*p && *p != '"')
+                {
+                    if (*p == '$' || *p == '`')
+                    {
+                        return NULL;
+                    }
+                    if (*p == '\\' && p[1] && strchr("\"\\", p[1]))
+                    {
+                        p++;
+                    }
+                    word[n++] = *p++;
+                }
+                if (!*p++)
+                {
+                    return NULL;
+                }
+            }
+            else if (c == '\\' && *p)
+            {
+                word[n++] = *p++;
+            }
+            else if (strchr("|&;<>()$`*?[]{}", c))
+            {
+                return NULL; // Needs the shell.
+            }
+            else
+            {
+                word[n++] = c;
+            }
+        }
+        word[n] = 0;
+        argv[argc++] = xstrdup(word);
+    }
+
+    argv[argc] = NULL;
+    return argc > 0 ? argv : NULL;
+}
@@ -44,4 +44,15 @@ void cmd_free(CmdBuilder *cmd);
  */
 const char *cmd_to_string(CmdBuilder *cmd);
 
+/**
+ * @brief Split a command line into an argument vector, as the shell would.
+ *
+ * Handles whitespace, single and double quotes and backslash escapes. Commands
+ * that need anything else from the shell (expansion, globbing, redirection,
+ * pipes, lists) are refused so the caller can run them through system().
+ * @param command The command line
+ * @return NULL-terminated vector, or NULL if the command needs a shell
+ */
+char **cmd_split_argv(const char *command);
+
 #endif
@@ -1,4 +1,5 @@
 #include "zprep.h"
+#include "build_cache.h"
 #include "cJSON.h"
 #include <stdio.h>
 #include <stdlib.h>
@@ -68,6 +69,9 @@ static int load_config_file(const char *path)
     fread(data, 1, length, f);
     data[length] = '\0';
     fclose(f);
+    // Configs change the output, so they are inputs of the build (and zc watch
+    // rebuilds when one is edited).
+    build_cache_note_file(path, data, length);
 
     cJSON *json = cJSON_Parse(data);
     free(data);
@@ -0,0 +1,89 @@
+#ifndef INTERN_H
+#define INTERN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief A unique, immutable copy of a string.
+ *
+ * Equal strings intern to the same pointer, so two InternedStr compare with
+ * `==`. The bytes live for the whole process (in the "intern" region) and
+ * are NUL-terminated, so an InternedStr can be used wherever a `char *` name
+ * was. It is kept non-const for that reason; it must never be written to.
+ */
+typedef char *InternedStr;
+
+/**
+ * @brief Intern a NUL-terminated string.
+ * @return The canonical copy, or NULL if `s` is NULL.
+ */
+InternedStr intern(const char *s);
+
+/**
+ * @brief Intern the first `len` bytes of `s` (e.g. a token's text).
+ */
+InternedStr intern_n(const char *s, size_t len);
+
+/**
+ * @brief Look a string up without interning it.
+ * @return The canonical copy, or NULL if `s` was never interned. A lookup key
+ *         that is not interned cannot match any interned name.
+ */
+InternedStr intern_find(const char *s);
+
+/**
+ * @brief Hash computed when `s` was interned (FNV-1a).
+ */
+uint32_t intern_hash(InternedStr s);
+
+/**
+ * @brief Length of an interned string, without scanning it.
+ */
+size_t intern_len(InternedStr s);
+
+/**
+ * @brief Number of distinct strings interned so far.
+ */
+size_t intern_count(void);
+
+/**
+ * @brief One key of an InternMap.
+ */
+typedef struct
+{
+    InternedStr key; ///< Interned key; never removed once inserted.
+    void *value;     ///< Stored value (NULL when unset).
+} InternMapSlot;
+
+/**
+ * @brief Open-addressed map from InternedStr to pointer.
+ *
+ * Keys are hashed with their precomputed intern hash and compared by
+ * pointer. Keys stay once inserted (clearing stores NULL), so there are no
+ * tombstones. A zeroed InternMap is empty; storage comes from the current
+ * arena, so the map lives as long as its owner.
+ */
+typedef struct
+{
+    InternMapSlot *slots; ///< Power-of-two sized slot array (NULL until first insert).
+    int cap;              ///< Number of slots.
+    int count;            ///< Number of keys.
+} InternMap;
+
+/**
+ * @brief Value slot for `key`, inserting the key (with a NULL value) if needed.
+ */
+void **intern_map_slot(InternMap *m, InternedStr key);
+
+/**
+ * @brief Value stored under `key`, or NULL. `key` need not be interned.
+ */
+void *intern_map_get(const InternMap *m, const char *key);
+
+/**
+ * @brief Store `value` under `key`, replacing any previous value.
+ */
+void intern_map_put(InternMap *m, InternedStr key, void *value);
+
+#endif
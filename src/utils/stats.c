@@ -0,0 +1,180 @@
+#include "stats.h"
+#include "../zprep.h"
+#include "arena.h"
+#include "ast.h"
+#include "lsp/cJSON.h"
+#include <ctype.h>
+
+CompileStats g_stats = {0};
+
+static const char *phase_names[PHASE_COUNT] = {
+    "lex", "parse", "parse-extra", "validate-types", "move-check", "typecheck", "codegen",
+    "backend-cc"};
+
+static double stats_started = 0;
+
+void stats_phase_begin(CompilePhase p)
+{
+    double now = z_get_monotonic_time();
+    if (stats_started == 0)
+    {
+        stats_started = now;
+    }
+    g_stats.phases[p].started = now;
+}
+
+void stats_phase_end(CompilePhase p)
+{
+    PhaseTime *t = &g_stats.phases[p];
+    if (t->started == 0)
+    {
+        return;
+    }
+    t->seconds += z_get_monotonic_time() - t->started;
+    t->started = 0;
+    t->peak_rss = z_peak_rss();
+    t->arena_bytes = arena_total_bytes();
+    t->runs++;
+}
+
+void stats_add_lex(long tokens, double seconds)
+{
+    atomic_fetch_add_explicit(&g_stats.tokens, tokens, memory_order_relaxed);
+    if (seconds > 0)
+    {
+        atomic_fetch_add_explicit(&g_stats.lex_ns, (long)(seconds * 1e9), memory_order_relaxed);
+    }
+}
+
+// Lexing happens on demand inside the parse phases (or on prefetch workers),
+// so it is reported as its own line but never added to the total.
+static double lex_seconds(void)
+{
+    return atomic_load_explicit(&g_stats.lex_ns, memory_order_relaxed) / 1e9;
+}
+
+typedef struct
+{
+    const char *name;
+    long value;
+} Counter;
+
+static int collect_counters(Counter *c)
+{
+    int n = 0;
+    c[n++] = (Counter){"tokens scanned", atomic_load(&g_stats.tokens)};
+    c[n++] = (Counter){"AST nodes created", g_stats.ast_nodes};
+    c[n++] = (Counter){"modules imported", g_stats.modules};
+    c[n++] = (Counter){"lambdas", g_stats.lambdas};
+    c[n++] = (Counter){"generic types instantiated", g_stats.generic_instances};
+    c[n++] = (Counter){"generic functions instantiated", g_stats.function_instances};
+    c[n++] = (Counter){"generic impls instantiated", g_stats.impl_instances};
+    c[n++] = (Counter){"instantiations reused", g_stats.instance_reuses};
+    c[n++] = (Counter){"template nodes copied", g_stats.copied_nodes};
+    c[n++] = (Counter){"template types shared", g_stats.shared_types};
+    c[n++] = (Counter){"interned strings", (long)intern_count()};
+    c[n++] = (Counter){"canonical types", type_intern_count()};
+    c[n++] = (Counter){"arena bytes", (long)arena_total_bytes()};
+    c[n++] = (Counter){"peak RSS bytes", (long)z_peak_rss()};
+    c[n++] = (Counter){"output C bytes", g_stats.output_bytes};
+    return n;
+}
+
+// "tokens scanned" -> "tokens_scanned", for JSON keys.
+static void counter_key(const char *name, char *key, size_t size)
+{
+    size_t i = 0;
+    for (; name[i] && i + 1 < size; i++)
+    {
+        key[i] = name[i] == ' ' ? '_' : (char)tolower((unsigned char)name[i]);
+    }
+    key[i] = 0;
+}
+
+static void report_json(FILE *out, double total)
+{
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddStringToObject(root, "file", g_config.input_file ? g_config.input_file : "unknown");
+    cJSON_AddStringToObject(root, "level", "stats");
+
+    if (g_config.time_passes)
+    {
+        cJSON *phases = cJSON_AddObjectToObject(root, "phases");
+        for (int p = 0; p < PHASE_COUNT; p++)
+        {
+            PhaseTime *t = &g_stats.phases[p];
+            if (p == PHASE_LEX)
+            {
+                cJSON *lex = cJSON_AddObjectToObject(phases, phase_names[p]);
+                cJSON_AddNumberToObject(lex, "seconds", lex_seconds());
+                continue;
+            }
+            if (t->runs == 0)
+            {
+                continue;
+            }
+            cJSON *phase = cJSON_AddObjectToObject(phases, phase_names[p]);
+            cJSON_AddNumberToObject(phase, "seconds", t->seconds);
+            cJSON_AddNumberToObject(phase, "peak_rss", (double)t->peak_rss);
+            cJSON_AddNumberToObject(phase, "arena_bytes", (double)t->arena_bytes);
+        }
+        cJSON_AddNumberToObject(root, "total_seconds", total);
+    }
+
+    if (g_config.stats)
+    {
+        Counter c[32];
+        int n = collect_counters(c);
+        cJSON *counters = cJSON_AddObjectToObject(root, "counters");
+        for (int i = 0; i < n; i++)
+        {
+            char key[64];
+            counter_key(c[i].name, key, sizeof(key));
+            cJSON_AddNumberToObject(counters, key, (double)c[i].value);
+        }
+    }
+
+    char *json = cJSON_PrintUnformatted(root);
+    fprintf(out, "%s\n", json);
+    free(json);
+    cJSON_Delete(root);
+}
+
+void stats_report(FILE *out)
+{
+    double total = stats_started ? z_get_monotonic_time() - stats_started : 0;
+
+    if (g_config.json_output)
+    {
+        report_json(out, total);
+        return;
+    }
+
+    if (g_config.time_passes)
+    {
+        fprintf(out, COLOR_BOLD "Time per phase:" COLOR_RESET "\n");
+        fprintf(out, "  %-24s %10s %14s %14s\n", "phase", "seconds", "peak RSS", "arena bytes");
+        fprintf(out, "  %-24s %10.4f %14s %14s\n", "lex (within parse)", lex_seconds(), "-", "-");
+        for (int p = PHASE_LEX + 1; p < PHASE_COUNT; p++)
+        {
+            PhaseTime *t = &g_stats.phases[p];
+            if (t->runs > 0)
+            {
+                fprintf(out, "  %-24s %10.4f %14zu %14zu\n", phase_names[p], t->seconds,
+                        t->peak_rss, t->arena_bytes);
+            }
+        }
+        fprintf(out, "  %-24s %10.4f\n", "total", total);
+    }
+
+    if (g_config.stats)
+    {
+        Counter c[32];
+        int n = collect_counters(c);
+        fprintf(out, COLOR_BOLD "Compiler statistics:" COLOR_RESET "\n");
+        for (int i = 0; i < n; i++)
+        {
+            fprintf(out, "  %-32s %12ld\n", c[i].name, c[i].value);
+        }
+    }
+}
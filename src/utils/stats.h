@@ -0,0 +1,78 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdio.h>
+
+/**
+ * @brief Compiler phases timed by --time-passes.
+ */
+typedef enum
+{
+    PHASE_LEX,         ///< Tokenizing (summed over threads; overlaps the parse phases).
+    PHASE_PARSE,       ///< parse_program on the main input and its imports.
+    PHASE_PARSE_EXTRA, ///< Extra input files given on the command line.
+    PHASE_VALIDATE,    ///< validate_types.
+    PHASE_MOVE_CHECK,  ///< check_moves_only.
+    PHASE_TYPECHECK,   ///< check_program.
+    PHASE_CODEGEN,     ///< codegen_node.
+    PHASE_BACKEND,     ///< The C compiler invocation.
+    PHASE_COUNT
+} CompilePhase;
+
+/**
+ * @brief Wall time and memory of one phase.
+ */
+typedef struct
+{
+    double seconds;     ///< Accumulated wall time.
+    double started;     ///< Start time of the running interval (0 if not running).
+    size_t peak_rss;    ///< Process peak RSS when the phase last ended.
+    size_t arena_bytes; ///< Bytes held by all arenas when the phase last ended.
+    int runs;           ///< Number of completed intervals.
+} PhaseTime;
+
+/**
+ * @brief Work counters reported by --stats.
+ */
+typedef struct CompileStats
+{
+    long generic_instances;        ///< Generic structs/enums instantiated.
+    long function_instances;       ///< Generic functions instantiated.
+    long impl_instances;           ///< Generic impl blocks instantiated.
+    long instance_reuses;          ///< Instantiation requests answered by an existing instance.
+    long copied_nodes;             ///< AST nodes copied out of templates.
+    long shared_types;             ///< Template types reused as-is instead of copied.
+    long ast_nodes;                ///< AST nodes created.
+    long lambdas;                  ///< Lambdas parsed.
+    long modules;                  ///< Imported modules parsed (each file once).
+    long output_bytes;             ///< Size of the generated C source.
+    atomic_long tokens;            ///< Tokens scanned (by any thread).
+    atomic_long lex_ns;            ///< Time spent scanning tokens, in ns (with --time-passes).
+    PhaseTime phases[PHASE_COUNT]; ///< Per-phase timings (see stats_phase_begin).
+} CompileStats;
+
+extern CompileStats g_stats;
+
+/**
+ * @brief Start timing a phase.
+ */
+void stats_phase_begin(CompilePhase p);
+
+/**
+ * @brief Stop timing a phase and record the memory in use.
+ */
+void stats_phase_end(CompilePhase p);
+
+/**
+ * @brief Account `tokens` scanned in `seconds` (callable from any thread).
+ */
+void stats_add_lex(long tokens, double seconds);
+
+/**
+ * @brief Print --time-passes and/or --stats output, as JSON with --json.
+ */
+void stats_report(FILE *out);
+
+#endif
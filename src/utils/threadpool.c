@@ -0,0 +1,213 @@
+#include "threadpool.h"
+#include "../platform/os.h"
+#include "../zprep.h"
+
+#ifndef _MSC_VER
+#include <pthread.h>
+
+typedef struct Job
+{
+    ZJobFn fn;
+    void *arg;
+    struct Job *next;
+} Job;
+
+struct ZThreadPool
+{
+    pthread_mutex_t lock;
+    pthread_cond_t has_work; ///< Signalled when a job is queued or on shutdown.
+    pthread_cond_t job_done; ///< Broadcast whenever a job finishes.
+    Job *head;               ///< Next job to run.
+    Job *tail;               ///< Last queued job.
+    Job *free_jobs;          ///< Recycled queue entries.
+    int queued;              ///< Jobs in the queue.
+    int running;             ///< Jobs currently executing.
+    int waiting;             ///< Workers blocked waiting for a job.
+    int stopping;            ///< 1 once thread_pool_destroy was called.
+    int max_threads;         ///< Upper bound on started workers.
+    int nthreads;            ///< Number of started workers.
+    pthread_t *threads;      ///< Worker handles.
+};
+
+static void *worker_main(void *data)
+{
+    ZThreadPool *p = data;
+
+    pthread_mutex_lock(&p->lock);
+    while (1)
+    {
+        while (!p->head && !p->stopping)
+        {
+            p->waiting++;
+            pthread_cond_wait(&p->has_work, &p->lock);
+            p->waiting--;
+        }
+        if (!p->head)
+        {
+            break;
+        }
+
+        Job *j = p->head;
+        p->head = j->next;
+        if (!p->head)
+        {
+            p->tail = NULL;
+        }
+        p->queued--;
+        ZJobFn fn = j->fn;
+        void *arg = j->arg;
+        j->next = p->free_jobs;
+        p->free_jobs = j;
+        p->running++;
+        pthread_mutex_unlock(&p->lock);
+
+        fn(arg);
+
+        pthread_mutex_lock(&p->lock);
+        p->running--;
+        pthread_cond_broadcast(&p->job_done);
+    }
+    pthread_mutex_unlock(&p->lock);
+    return NULL;
+}
+
+ZThreadPool *thread_pool_create(int threads)
+{
+    if (threads < 1)
+    {
+        return NULL;
+    }
+
+    ZThreadPool *p = xcalloc(1, sizeof(ZThreadPool));
+    pthread_mutex_init(&p->lock, NULL);
+    pthread_cond_init(&p->has_work, NULL);
+    pthread_cond_init(&p->job_done, NULL);
+    p->max_threads = threads;
+    p->threads = xmalloc(sizeof(pthread_t) * threads);
+    return p;
+}
+
+void thread_pool_submit(ZThreadPool *p, ZJobFn fn, void *arg)
+{
+    pthread_mutex_lock(&p->lock);
+    if (p->queued >= p->waiting && p->nthreads < p->max_threads)
+    {
+        if (pthread_create(&p->threads[p->nthreads], NULL, worker_main, p) == 0)
+        {
+            p->nthreads++;
+        }
+        else if (p->nthreads == 0)
+        {
+            // No worker could be started: run the job here.
+            pthread_mutex_unlock(&p->lock);
+            fn(arg);
+            return;
+        }
+    }
+
+    Job *j = p->free_jobs;
+    if (j)
+    {
+        p->free_jobs = j->next;
+    }
+    else
+    {
+        j = xmalloc(sizeof(Job));
+    }
+    j->fn = fn;
+    j->arg = arg;
+    j->next = NULL;
+    if (p->tail)
+    {
+        p->tail->next = j;
+    }
+    else
+    {
+        p->head = j;
+    }
+    p->tail = j;
+    p->queued++;
+    pthread_cond_signal(&p->has_work);
+    pthread_mutex_unlock(&p->lock);
+}
+
+void thread_pool_wait(ZThreadPool *p)
+{
+    pthread_mutex_lock(&p->lock);
+    while (p->head || p->running)
+    {
+        pthread_cond_wait(&p->job_done, &p->lock);
+    }
+    pthread_mutex_unlock(&p->lock);
+}
+
+void thread_pool_wait_flag(ZThreadPool *p, atomic_int *done)
+{
+    if (atomic_load_explicit(done, memory_order_acquire))
+    {
+        return;
+    }
+    pthread_mutex_lock(&p->lock);
+    while (!atomic_load_explicit(done, memory_order_acquire))
+    {
+        pthread_cond_wait(&p->job_done, &p->lock);
+    }
+    pthread_mutex_unlock(&p->lock);
+}
+
+void thread_pool_destroy(ZThreadPool *p)
+{
+    if (!p)
+    {
+        return;
+    }
+    pthread_mutex_lock(&p->lock);
+    p->stopping = 1;
+    pthread_cond_broadcast(&p->has_work);
+    pthread_mutex_unlock(&p->lock);
+
+    for (int i = 0; i < p->nthreads; i++)
+    {
+        pthread_join(p->threads[i], NULL);
+    }
+    pthread_cond_destroy(&p->job_done);
+    pthread_cond_destroy(&p->has_work);
+    pthread_mutex_destroy(&p->lock);
+}
+
+#else
+// No pthreads with MSVC: report no pool, so callers run their work inline.
+
+ZThreadPool *thread_pool_create(int threads)
+{
+    (void)threads;
+    return NULL;
+}
+
+void thread_pool_submit(ZThreadPool *p, ZJobFn fn, void *arg)
+{
+    (void)p;
+    fn(arg);
+}
+
+void thread_pool_wait(ZThreadPool *p)
+{
+    (void)p;
+}
+
+void thread_pool_wait_flag(ZThreadPool *p, atomic_int *done)
+{
+    (void)p;
+    (void)done;
+}
+
+void thread_pool_destroy(ZThreadPool *p)
+{
+    (void)p;
+}
+#endif
+
+int thread_pool_default_size(void)
+{
+    return z_cpu_count();
+}
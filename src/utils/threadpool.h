@@ -0,0 +1,56 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <stdatomic.h>
+
+/**
+ * @brief Work item run on a pool worker.
+ */
+typedef void (*ZJobFn)(void *arg);
+
+/**
+ * @brief Worker threads draining a FIFO job queue.
+ *
+ * Workers are started on demand, when a job is queued and none is idle, up
+ * to the size given at creation. Each allocates from its own per-thread
+ * arena (see arena_current), which outlives the worker, so whatever a job
+ * builds stays valid for the main thread. Jobs may submit further jobs.
+ */
+typedef struct ZThreadPool ZThreadPool;
+
+/**
+ * @brief Number of worker threads to use when none is requested (online CPUs).
+ */
+int thread_pool_default_size(void);
+
+/**
+ * @brief Create a pool of at most `threads` workers.
+ * @return The pool, or NULL when threads are unavailable (or `threads` < 1);
+ *         callers then do the work inline.
+ */
+ZThreadPool *thread_pool_create(int threads);
+
+/**
+ * @brief Queue `fn(arg)` to run on a worker.
+ */
+void thread_pool_submit(ZThreadPool *p, ZJobFn fn, void *arg);
+
+/**
+ * @brief Block until the queue is empty and every worker is idle.
+ */
+void thread_pool_wait(ZThreadPool *p);
+
+/**
+ * @brief Block until a job of this pool has set `*done` to nonzero.
+ *
+ * The job stores the flag last, with release ordering, so everything it
+ * wrote before is visible to the caller afterwards.
+ */
+void thread_pool_wait_flag(ZThreadPool *p, atomic_int *done);
+
+/**
+ * @brief Finish queued jobs, then stop and join the workers.
+ */
+void thread_pool_destroy(ZThreadPool *p);
+
+#endif
@@ -6,6 +6,9 @@ char *g_current_filename = "unknown";
 ParserContext *g_parser_ctx = NULL;
 
 // ** Arena Implementation **
+#include "arena.h"
+#include <stdatomic.h>
+
 #define ARENA_BLOCK_SIZE (1024 * 1024)
 
 typedef struct ArenaBlock
@@ -16,17 +19,174 @@ typedef struct ArenaBlock
     char data[];
 } ArenaBlock;
 
-static ArenaBlock *current_block = NULL;
+struct ZArena
+{
+    char name[64];
+    ArenaBlock *head;  ///< Current (most recent) block.
+    void *last_alloc;  ///< Most recent allocation, for in-place xrealloc.
+    size_t used;       ///< Bytes handed out, including headers.
+    size_t reserved;   ///< Bytes held in blocks.
+    size_t peak;       ///< High-water mark of `used`.
+    size_t blocks;     ///< Number of live blocks.
+    size_t allocs;     ///< Number of allocations served.
+    size_t grown;      ///< Number of reallocs grown in place.
+    struct ZArena *next_region;
+};
+
+// The arena itself must reach the real allocator.
+#undef malloc
+#undef free
+
+static ZArena global_arena = {.name = "global"};
+static atomic_flag global_claimed = ATOMIC_FLAG_INIT;
+static ZC_THREAD_LOCAL ZArena *current_arena = NULL;
+
+static ZArena *regions = NULL;
+static atomic_flag regions_lock = ATOMIC_FLAG_INIT;
+
+static void regions_acquire(void)
+{
+    while (atomic_flag_test_and_set_explicit(&regions_lock, memory_order_acquire))
+    {
+    }
+}
+
+static void regions_release(void)
+{
+    atomic_flag_clear_explicit(&regions_lock, memory_order_release);
+}
+
+static void register_region(ZArena *a)
+{
+    regions_acquire();
+    a->next_region = regions;
+    regions = a;
+    regions_release();
+}
+
+static void unregister_region(ZArena *a)
+{
+    regions_acquire();
+    ZArena **pp = &regions;
+    while (*pp)
+    {
+        if (*pp == a)
+        {
+            *pp = a->next_region;
+            break;
+        }
+        pp = &(*pp)->next_region;
+    }
+    regions_release();
+}
+
+ZArena *arena_create(const char *name)
+{
+    ZArena *a = malloc(sizeof(ZArena));
+    if (!a)
+    {
+        zfatal("Out of memory");
+    }
+    memset(a, 0, sizeof(ZArena));
+    snprintf(a->name, sizeof(a->name), "%s", name ? name : "unnamed");
+    register_region(a);
+    return a;
+}
+
+static void release_blocks(ZArena *a, ArenaBlock *stop)
+{
+    while (a->head && a->head != stop)
+    {
+        ArenaBlock *next = a->head->next;
+        a->reserved -= a->head->cap;
+        a->blocks--;
+        free(a->head);
+        a->head = next;
+    }
+}
+
+void arena_reset(ZArena *a)
+{
+    release_blocks(a, NULL);
+    a->used = 0;
+    a->last_alloc = NULL;
+}
+
+void arena_destroy(ZArena *a)
+{
+    if (!a)
+    {
+        return;
+    }
+    if (current_arena == a)
+    {
+        current_arena = arena_global();
+    }
+    arena_reset(a);
+    unregister_region(a);
+    if (a != &global_arena)
+    {
+        free(a);
+    }
+}
+
+ZArena *arena_global(void)
+{
+    return &global_arena;
+}
+
+ZArena *arena_current(void)
+{
+    if (!current_arena)
+    {
+        if (!atomic_flag_test_and_set(&global_claimed))
+        {
+            register_region(&global_arena);
+            current_arena = &global_arena;
+        }
+        else
+        {
+            current_arena = arena_create("thread");
+        }
+    }
+    return current_arena;
+}
+
+ZArena *arena_use(ZArena *a)
+{
+    ZArena *prev = arena_current();
+    current_arena = a ? a : prev;
+    return prev;
+}
+
+ArenaMark arena_push_mark(ZArena *a)
+{
+    ArenaMark m;
+    m.block = a->head;
+    m.block_used = a->head ? a->head->used : 0;
+    m.bytes_used = a->used;
+    return m;
+}
+
+void arena_pop_mark(ZArena *a, ArenaMark m)
+{
+    release_blocks(a, m.block);
+    if (a->head)
+    {
+        a->head->used = m.block_used;
+    }
+    a->used = m.bytes_used;
+    a->last_alloc = NULL;
+}
 
-static void *arena_alloc_raw(size_t size)
+void *arena_alloc(ZArena *a, size_t size)
 {
     size_t actual_size = size + sizeof(size_t);
     actual_size = (actual_size + 7) & ~7;
 
-    if (!current_block || (current_block->used + actual_size > current_block->cap))
+    if (!a->head || (a->head->used + actual_size > a->head->cap))
     {
         size_t block_size = actual_size > ARENA_BLOCK_SIZE ? actual_size : ARENA_BLOCK_SIZE;
-#undef malloc
         ArenaBlock *new_block = malloc(sizeof(ArenaBlock) + block_size);
         if (!new_block)
         {
@@ -35,14 +195,277 @@ static void *arena_alloc_raw(size_t size)
 
         new_block->cap = block_size;
         new_block->used = 0;
-        new_block->next = current_block;
-        current_block = new_block;
+        new_block->next = a->head;
+        a->head = new_block;
+        a->reserved += block_size;
+        a->blocks++;
     }
 
-    void *ptr = current_block->data + current_block->used;
-    current_block->used += actual_size;
+    void *ptr = a->head->data + a->head->used;
+    a->head->used += actual_size;
+    a->used += actual_size;
+    a->allocs++;
+    if (a->used > a->peak)
+    {
+        a->peak = a->used;
+    }
     *(size_t *)ptr = size;
-    return (char *)ptr + sizeof(size_t);
+    a->last_alloc = (char *)ptr + sizeof(size_t);
+    return a->last_alloc;
+}
+
+size_t arena_bytes_used(ZArena *a)
+{
+    return a->used;
+}
+
+size_t arena_total_bytes(void)
+{
+    size_t total = 0;
+    regions_acquire();
+    for (ZArena *a = regions; a; a = a->next_region)
+    {
+        total += a->used;
+    }
+    regions_release();
+    return total;
+}
+
+void arena_print_stats(FILE *out)
+{
+    size_t total_used = 0;
+    size_t total_reserved = 0;
+    fprintf(out, COLOR_BOLD "Memory by region:" COLOR_RESET "\n");
+    fprintf(out, "  %-24s %12s %12s %12s %8s %10s %8s\n", "region", "used", "peak", "reserved",
+            "blocks", "allocs", "grown");
+    regions_acquire();
+    for (ZArena *a = regions; a; a = a->next_region)
+    {
+        fprintf(out, "  %-24s %12zu %12zu %12zu %8zu %10zu %8zu\n", a->name, a->used, a->peak,
+                a->reserved, a->blocks, a->allocs, a->grown);
+        total_used += a->used;
+        total_reserved += a->reserved;
+    }
+    regions_release();
+    fprintf(out, "  %-24s %12zu %12s %12zu\n", "total", total_used, "", total_reserved);
+}
+
+// ** String Interning **
+#include "intern.h"
+
+typedef struct
+{
+    uint32_t hash; ///< FNV-1a hash of the text.
+    uint32_t len;  ///< Length of the text.
+    char str[];    ///< NUL-terminated text; this is what an InternedStr points at.
+} InternEntry;
+
+// Open-addressed table of entries, kept at most half full. The table and the
+// "intern" region are shared by all threads and only touched under the lock;
+// entries never move, so the returned pointers stay valid without it.
+static InternEntry **intern_slots = NULL;
+static size_t intern_cap = 0;
+static size_t intern_used = 0;
+static ZArena *intern_arena = NULL;
+static atomic_flag intern_lock = ATOMIC_FLAG_INIT;
+
+static void intern_acquire(void)
+{
+    while (atomic_flag_test_and_set_explicit(&intern_lock, memory_order_acquire))
+    {
+    }
+}
+
+static void intern_release(void)
+{
+    atomic_flag_clear_explicit(&intern_lock, memory_order_release);
+}
+
+static uint32_t intern_hash_bytes(const char *s, size_t len)
+{
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++)
+    {
+        h ^= (unsigned char)s[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static InternEntry *intern_entry(InternedStr s)
+{
+    return (InternEntry *)(s - offsetof(InternEntry, str));
+}
+
+// Slot holding `s`, or the empty slot where it belongs.
+static InternEntry **intern_slot(const char *s, size_t len, uint32_t hash)
+{
+    size_t mask = intern_cap - 1;
+    size_t i = hash & mask;
+    while (intern_slots[i])
+    {
+        InternEntry *e = intern_slots[i];
+        if (e->hash == hash && e->len == len && memcmp(e->str, s, len) == 0)
+        {
+            break;
+        }
+        i = (i + 1) & mask;
+    }
+    return &intern_slots[i];
+}
+
+static void intern_grow(void)
+{
+    size_t old_cap = intern_cap;
+    InternEntry **old = intern_slots;
+
+    intern_cap = old_cap ? old_cap * 2 : 4096;
+    intern_slots = malloc(sizeof(InternEntry *) * intern_cap);
+    if (!intern_slots)
+    {
+        zfatal("Out of memory");
+    }
+    memset(intern_slots, 0, sizeof(InternEntry *) * intern_cap);
+
+    for (size_t i = 0; i < old_cap; i++)
+    {
+        if (old[i])
+        {
+            size_t j = old[i]->hash & (intern_cap - 1);
+            while (intern_slots[j])
+            {
+                j = (j + 1) & (intern_cap - 1);
+            }
+            intern_slots[j] = old[i];
+        }
+    }
+    free(old);
+}
+
+InternedStr intern_n(const char *s, size_t len)
+{
+    if (!s)
+    {
+        return NULL;
+    }
+    uint32_t hash = intern_hash_bytes(s, len);
+
+    intern_acquire();
+    if ((intern_used + 1) * 2 > intern_cap)
+    {
+        intern_grow();
+    }
+    InternEntry **slot = intern_slot(s, len, hash);
+    if (!*slot)
+    {
+        if (!intern_arena)
+        {
+            intern_arena = arena_create("intern");
+        }
+        InternEntry *e = arena_alloc(intern_arena, sizeof(InternEntry) + len + 1);
+        e->hash = hash;
+        e->len = (uint32_t)len;
+        memcpy(e->str, s, len);
+        e->str[len] = 0;
+        *slot = e;
+        intern_used++;
+    }
+    InternedStr result = (*slot)->str;
+    intern_release();
+    return result;
+}
+
+InternedStr intern(const char *s)
+{
+    return s ? intern_n(s, strlen(s)) : NULL;
+}
+
+InternedStr intern_find(const char *s)
+{
+    if (!s)
+    {
+        return NULL;
+    }
+    size_t len = strlen(s);
+    uint32_t hash = intern_hash_bytes(s, len);
+
+    InternedStr result = NULL;
+    intern_acquire();
+    if (intern_cap)
+    {
+        InternEntry *e = *intern_slot(s, len, hash);
+        result = e ? e->str : NULL;
+    }
+    intern_release();
+    return result;
+}
+
+uint32_t intern_hash(InternedStr s)
+{
+    return intern_entry(s)->hash;
+}
+
+size_t intern_len(InternedStr s)
+{
+    return intern_entry(s)->len;
+}
+
+size_t intern_count(void)
+{
+    return intern_used;
+}
+
+static InternMapSlot *intern_map_probe(const InternMap *m, InternedStr key)
+{
+    int mask = m->cap - 1;
+    int i = intern_entry(key)->hash & mask;
+    while (m->slots[i].key && m->slots[i].key != key)
+    {
+        i = (i + 1) & mask;
+    }
+    return &m->slots[i];
+}
+
+void **intern_map_slot(InternMap *m, InternedStr key)
+{
+    if ((m->count + 1) * 2 > m->cap)
+    {
+        InternMap grown = {0};
+        grown.cap = m->cap ? m->cap * 2 : 64;
+        grown.slots = xcalloc(grown.cap, sizeof(InternMapSlot));
+        for (int i = 0; i < m->cap; i++)
+        {
+            if (m->slots[i].key)
+            {
+                *intern_map_probe(&grown, m->slots[i].key) = m->slots[i];
+            }
+        }
+        grown.count = m->count;
+        *m = grown;
+    }
+
+    InternMapSlot *slot = intern_map_probe(m, key);
+    if (!slot->key)
+    {
+        slot->key = key;
+        m->count++;
+    }
+    return &slot->value;
+}
+
+void *intern_map_get(const InternMap *m, const char *key)
+{
+    if (!m->cap)
+    {
+        return NULL;
+    }
+    InternedStr k = intern_find(key);
+    return k ? intern_map_probe(m, k)->value : NULL;
+}
+
+void intern_map_put(InternMap *m, InternedStr key, void *value)
+{
+    *intern_map_slot(m, key) = value;
 }
 
 #include <time.h>
@@ -50,13 +473,13 @@ static void *arena_alloc_raw(size_t size)
 
 void *xmalloc(size_t size)
 {
-    return arena_alloc_raw(size);
+    return arena_alloc(arena_current(), size);
 }
 
 void *xcalloc(size_t n, size_t size)
 {
     size_t total = n * size;
-    void *p = arena_alloc_raw(total);
+    void *p = arena_alloc(arena_current(), total);
     memset(p, 0, total);
     return p;
 }
@@ -73,6 +496,28 @@ void *xrealloc(void *ptr, size_t new_size)
     {
         return ptr;
     }
+
+    // Grow in place when `ptr` is the newest allocation of the current arena.
+    ZArena *a = arena_current();
+    if (ptr == a->last_alloc)
+    {
+        size_t old_actual = (old_size + sizeof(size_t) + 7) & ~(size_t)7;
+        size_t new_actual = (new_size + sizeof(size_t) + 7) & ~(size_t)7;
+        size_t extra = new_actual - old_actual;
+        if (a->head->used + extra <= a->head->cap)
+        {
+            a->head->used += extra;
+            a->used += extra;
+            if (a->used > a->peak)
+            {
+                a->peak = a->used;
+            }
+            a->grown++;
+            *header = new_size;
+            return ptr;
+        }
+    }
+
     void *new_ptr = xmalloc(new_size);
     memcpy(new_ptr, ptr, old_size);
     return new_ptr;
@@ -91,30 +536,33 @@ char *xstrdup(const char *s)
     return d;
 }
 
-char *load_file(const char *fn)
+// Read `fn`, or the file of that name under ZC_ROOT or the install prefixes.
+// `*opened` is set to the path read (`fn` or `path`), `*len` to its length.
+static char *read_source(const char *fn, char path[1024], const char **opened, long *len)
 {
+    *opened = fn;
     FILE *f = fopen(fn, "rb");
     if (!f)
     {
         char *root = getenv("ZC_ROOT");
         if (root)
         {
-            char path[1024];
-            snprintf(path, sizeof(path), "%s/%s", root, fn);
+            snprintf(path, 1024, "%s/%s", root, fn);
             f = fopen(path, "rb");
+            *opened = path;
         }
     }
     if (!f)
     {
-        char path[1024];
-        snprintf(path, sizeof(path), "/usr/local/share/zenc/%s", fn);
+        snprintf(path, 1024, "/usr/local/share/zenc/%s", fn);
         f = fopen(path, "rb");
+        *opened = path;
     }
     if (!f)
     {
-        char path[1024];
-        snprintf(path, sizeof(path), "/usr/share/zenc/%s", fn);
+        snprintf(path, 1024, "/usr/share/zenc/%s", fn);
         f = fopen(path, "rb");
+        *opened = path;
     }
 
     if (!f)
@@ -128,6 +576,33 @@ char *load_file(const char *fn)
     fread(b, 1, l, f);
     b[l] = 0;
     fclose(f);
+    *len = l;
+    return b;
+}
+
+char *load_file(const char *fn)
+{
+    char path[1024];
+    const char *opened;
+    long l;
+    char *b = read_source(fn, path, &opened, &l);
+    if (b)
+    {
+        build_cache_note_file(opened, b, l);
+    }
+    return b;
+}
+
+char *load_file_untracked(const char *fn, size_t *len)
+{
+    char path[1024];
+    const char *opened;
+    long l;
+    char *b = read_source(fn, path, &opened, &l);
+    if (b && len)
+    {
+        *len = (size_t)l;
+    }
     return b;
 }
 
@@ -158,6 +633,7 @@ static void expand_env_vars(char *dest, size_t dest_size, const char *src)
                     strncpy(var_name, s + 2, len);
                     var_name[len] = 0;
                     char *val = getenv(var_name);
+                    build_cache_note_env(var_name, val);
                     if (val)
                     {
                         size_t val_len = strlen(val);
@@ -325,6 +801,7 @@ void scan_build_directives(ParserContext *ctx, const char *src)
             }
             else if (0 == strncmp(directive, "shell:", 6))
             {
+                build_cache_disable("shell: directive");
                 if (system(directive + 6) != 0)
                 {
                     zwarn("Shell directive failed: %s", directive + 6);
@@ -332,6 +809,7 @@ void scan_build_directives(ParserContext *ctx, const char *src)
             }
             else if (strncmp(directive, "get:", 4) == 0)
             {
+                build_cache_disable("get: directive");
                 char *url = directive + 4;
                 while (*url == ' ')
                 {
@@ -371,6 +849,7 @@ void scan_build_directives(ParserContext *ctx, const char *src)
             }
             else if (strncmp(directive, "pkg-config:", 11) == 0)
             {
+                build_cache_disable("pkg-config: directive");
                 char *libs = directive + 11;
                 char cmd[4096];
                 sprintf(cmd, "pkg-config --cflags %s", libs);
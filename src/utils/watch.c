@@ -0,0 +1,426 @@
+#include "watch.h"
+#include "../platform/os.h"
+#include "../zprep.h"
+
+#ifndef _WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/wait.h>
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+
+#define WATCH_POLL_MS 250 ///< Poll interval where inotify is not available.
+#define WATCH_SETTLE_MS 50 ///< Quiet time that ends a burst of change events.
+
+static int report_fd = -1;      ///< Write end of the pipe to the watcher (build child only).
+static double build_started = 0; ///< When the current build child was forked.
+
+/**
+ * @brief A file the last builds read, and a watched directory.
+ */
+typedef struct
+{
+    char *path;      ///< Absolute path.
+    long long mtime; ///< Modification time when last checked (polling).
+    long long size;  ///< Size when last checked (polling).
+} WatchedFile;
+
+typedef struct
+{
+    WatchedFile *files;
+    int count;
+    int cap;
+    int inotify_fd; ///< -1 when polling.
+    int *dir_wds;   ///< inotify watch descriptor of each entry in `dirs`.
+    char **dirs;    ///< Directories holding watched files.
+    int dir_count;
+} WatchSet;
+
+static void watch_dir(WatchSet *set, const char *dir)
+{
+    for (int i = 0; i < set->dir_count; i++)
+    {
+        if (strcmp(set->dirs[i], dir) == 0)
+        {
+            return;
+        }
+    }
+    int wd = -1;
+#ifdef __linux__
+    // Editors often save by writing a new file and renaming it over the old
+    // one, so watch the directory rather than the file.
+    wd = inotify_add_watch(set->inotify_fd, dir,
+                           IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_DELETE);
+#endif
+    set->dirs = xrealloc(set->dirs, sizeof(char *) * (set->dir_count + 1));
+    set->dir_wds = xrealloc(set->dir_wds, sizeof(int) * (set->dir_count + 1));
+    set->dirs[set->dir_count] = xstrdup(dir);
+    set->dir_wds[set->dir_count++] = wd;
+}
+
+static void watch_add(WatchSet *set, const char *path)
+{
+    char *full = realpath(path, NULL);
+    if (!full)
+    {
+        return;
+    }
+    for (int i = 0; i < set->count; i++)
+    {
+        if (strcmp(set->files[i].path, full) == 0)
+        {
+            free(full);
+            return;
+        }
+    }
+    if (set->count == set->cap)
+    {
+        set->cap = set->cap ? set->cap * 2 : 64;
+        set->files = xrealloc(set->files, sizeof(WatchedFile) * set->cap);
+    }
+    WatchedFile *f = &set->files[set->count++];
+    f->path = xstrdup(full);
+    z_file_stamp(full, &f->mtime, &f->size);
+    free(full);
+
+    if (set->inotify_fd >= 0)
+    {
+        char dir[PATH_MAX];
+        snprintf(dir, sizeof(dir), "%s", f->path);
+        char *sep = z_path_last_sep(dir);
+        if (sep)
+        {
+            *(sep == dir ? sep + 1 : sep) = 0;
+            watch_dir(set, dir);
+        }
+    }
+}
+
+static int find_file(WatchSet *set, const char *path)
+{
+    for (int i = 0; i < set->count; i++)
+    {
+        if (strcmp(set->files[i].path, path) == 0)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Index of a watched file named by pending inotify events, or -1.
+static int read_events(WatchSet *set)
+{
+    int changed = -1;
+#ifdef __linux__
+    char buf[8192] __attribute__((aligned(__alignof__(struct inotify_event))));
+    ssize_t n;
+    while ((n = read(set->inotify_fd, buf, sizeof(buf))) > 0)
+    {
+        for (char *p = buf; p < buf + n;)
+        {
+            struct inotify_event *ev = (struct inotify_event *)p;
+            p += sizeof(struct inotify_event) + ev->len;
+            for (int d = 0; d < set->dir_count && ev->len > 0; d++)
+            {
+                if (set->dir_wds[d] != ev->wd)
+                {
+                    continue;
+                }
+                char path[PATH_MAX * 2];
+                const char *dir = set->dirs[d];
+                snprintf(path, sizeof(path), "%s%s%s", dir,
+                         dir[strlen(dir) - 1] == '/' ? "" : "/", ev->name);
+                int i = find_file(set, path);
+                if (i >= 0)
+                {
+                    changed = i;
+                }
+            }
+        }
+    }
+#else
+    (void)set;
+#endif
+    return changed;
+}
+
+// Index of a watched file whose size or modification time changed, or -1.
+static int poll_stamps(WatchSet *set)
+{
+    int changed = -1;
+    for (int i = 0; i < set->count; i++)
+    {
+        WatchedFile *f = &set->files[i];
+        long long mtime;
+        long long size;
+        z_file_stamp(f->path, &mtime, &size);
+        if (mtime != f->mtime || size != f->size)
+        {
+            f->mtime = mtime;
+            f->size = size;
+            changed = i;
+        }
+    }
+    return changed;
+}
+
+// Read "f <path>" and "b" lines from a build child. Returns 0 at end of file.
+static int read_reports(WatchSet *set, int fd, char *line, size_t *len, size_t cap, int *built)
+{
+    char chunk[4096];
+    ssize_t n = read(fd, chunk, sizeof(chunk));
+    if (n <= 0)
+    {
+        return n < 0 && errno == EINTR;
+    }
+    for (ssize_t i = 0; i < n; i++)
+    {
+        if (chunk[i] != '\n')
+        {
+            if (*len + 1 < cap)
+            {
+                line[(*len)++] = chunk[i];
+            }
+            continue;
+        }
+        line[*len] = 0;
+        if (line[0] == 'f' && line[1] == ' ')
+        {
+            watch_add(set, line + 2);
+        }
+        else if (line[0] == 'b')
+        {
+            *built = 1;
+        }
+        *len = 0;
+    }
+    return 1;
+}
+
+static double elapsed_ms(double since)
+{
+    return (z_get_monotonic_time() - since) * 1000.0;
+}
+
+// Run one build child and wait until a watched file changes. Returns the
+// index of the changed file, or -1 in the child.
+static int build_and_wait(WatchSet *set, void (*prepare)(void))
+{
+    int fds[2];
+    if (pipe(fds) != 0)
+    {
+        zpanic("zc watch: cannot create a pipe");
+    }
+    build_started = z_get_monotonic_time();
+    if (prepare)
+    {
+        prepare();
+    }
+    fflush(stdout);
+    fflush(stderr);
+    pid_t pid = fork();
+    if (pid < 0)
+    {
+        zpanic("zc watch: cannot fork");
+    }
+    if (pid == 0)
+    {
+        close(fds[0]);
+        if (set->inotify_fd >= 0)
+        {
+            close(set->inotify_fd);
+        }
+        fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+        report_fd = fds[1];
+        return -1;
+    }
+    close(fds[1]);
+
+    int pipe_fd = fds[0];
+    int alive = 1;
+    int status = 0;
+    int built = 0;
+    int reported = 0;
+    char line[PIPE_BUF]; // Children write lines of at most PIPE_BUF bytes.
+    size_t len = 0;
+    int changed = -1;
+    while (changed < 0)
+    {
+        struct pollfd pfd[2];
+        int n = 0;
+        if (pipe_fd >= 0)
+        {
+            pfd[n++] = (struct pollfd){pipe_fd, POLLIN, 0};
+        }
+        if (set->inotify_fd >= 0)
+        {
+            pfd[n++] = (struct pollfd){set->inotify_fd, POLLIN, 0};
+        }
+        poll(pfd, n, alive || set->inotify_fd < 0 ? WATCH_POLL_MS : -1);
+
+        if (pipe_fd >= 0 && pfd[0].revents &&
+            !read_reports(set, pipe_fd, line, &len, sizeof(line), &built))
+        {
+            close(pipe_fd);
+            pipe_fd = -1;
+            // Without a build report the child cannot have started the
+            // program, so it is exiting: reap it now, not on the next poll.
+            if (alive && !built && waitpid(pid, &status, 0) == pid)
+            {
+                alive = 0;
+            }
+        }
+
+        if (alive && waitpid(pid, &status, WNOHANG) == pid)
+        {
+            alive = 0;
+        }
+        // A successful build reports itself (watch_note_built), ahead of the
+        // output of the program it runs.
+        if (!reported && !built && !alive && pipe_fd < 0)
+        {
+            double ms = elapsed_ms(build_started);
+            if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+            {
+                printf(COLOR_BOLD COLOR_RED "      Failed" COLOR_RESET " after %.0f ms\n", ms);
+            }
+            else
+            {
+                // `zc watch check` has no executable to report.
+                printf(COLOR_BOLD COLOR_GREEN "     Checked" COLOR_RESET " in %.0f ms\n", ms);
+            }
+            reported = 1;
+        }
+        fflush(stdout);
+
+        changed = set->inotify_fd >= 0 ? read_events(set) : poll_stamps(set);
+    }
+
+    // Let a burst of writes (or a save through a temporary file) settle.
+    do
+    {
+        struct pollfd pfd = {set->inotify_fd, POLLIN, 0};
+        poll(&pfd, set->inotify_fd >= 0 ? 1 : 0, WATCH_SETTLE_MS);
+    } while ((set->inotify_fd >= 0 ? read_events(set) : poll_stamps(set)) >= 0);
+    poll_stamps(set);
+
+    if (alive)
+    {
+        kill(pid, SIGTERM);
+        waitpid(pid, NULL, 0);
+    }
+    if (pipe_fd >= 0)
+    {
+        close(pipe_fd);
+    }
+    return changed;
+}
+
+int watch_main(void (*prepare)(void))
+{
+    WatchSet set = {0};
+    set.inotify_fd = -1;
+#ifdef __linux__
+    set.inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+    watch_add(&set, g_config.input_file);
+    for (int i = 0; i < g_config.extra_file_count; i++)
+    {
+        watch_add(&set, g_config.extra_files[i]);
+    }
+
+    while (1)
+    {
+        int changed = build_and_wait(&set, prepare);
+        if (changed < 0)
+        {
+            return -1;
+        }
+        if (!g_config.quiet)
+        {
+            printf(COLOR_BOLD COLOR_CYAN "     Changed" COLOR_RESET " %s\n",
+                   set.files[changed].path);
+        }
+    }
+}
+
+int watch_is_child(void)
+{
+    return report_fd >= 0;
+}
+
+void watch_note_input(const char *path)
+{
+    if (report_fd < 0 || !path)
+    {
+        return;
+    }
+    // One write per line, capped at PIPE_BUF bytes: only writes that small are
+    // atomic, so lines from different threads do not mix. A path too long for
+    // that is not reported, and so not watched.
+    char line[PIPE_BUF];
+    int n = snprintf(line, sizeof(line), "f %s\n", path);
+    if (n > 0 && n < (int)sizeof(line))
+    {
+        ssize_t ignored = write(report_fd, line, n);
+        (void)ignored;
+    }
+}
+
+void watch_note_built(void)
+{
+    if (report_fd >= 0)
+    {
+        ssize_t ignored = write(report_fd, "b\n", 2);
+        (void)ignored;
+        printf(COLOR_BOLD COLOR_GREEN "     Rebuilt" COLOR_RESET " in %.0f ms\n",
+               elapsed_ms(build_started));
+        fflush(stdout);
+    }
+}
+
+void watch_exec(char *const argv[])
+{
+    if (report_fd < 0)
+    {
+        return;
+    }
+    fflush(stdout);
+    fflush(stderr);
+    execv(argv[0], argv);
+}
+
+#else
+
+int watch_main(void (*prepare)(void))
+{
+    (void)prepare;
+    fprintf(stderr, COLOR_BOLD COLOR_RED "error" COLOR_RESET
+                    ": zc watch is not supported on Windows\n");
+    return 1;
+}
+
+int watch_is_child(void)
+{
+    return 0;
+}
+
+void watch_note_input(const char *path)
+{
+    (void)path;
+}
+
+void watch_note_built(void)
+{
+}
+
+void watch_exec(char *const argv[])
+{
+    (void)argv;
+}
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef WATCH_H
+#define WATCH_H
+
+/**
+ * @brief `zc watch`: rebuild, re-check or re-run a program whenever one of
+ * the files it was built from changes.
+ *
+ * The watcher forks a child for every build, so the child starts from the
+ * state the watcher keeps warm (see watch_main). The child carries on through
+ * the normal build in main() and reports each file it reads (sources,
+ * imports, C headers, embedded files) through a pipe. The watcher then waits
+ * for one of those files to change (inotify on Linux, polling elsewhere),
+ * stops a program still running from the previous build and starts the next
+ * one. Not available on Windows.
+ */
+
+/**
+ * @brief Run the watch loop.
+ * @param prepare Called in the watcher before each build child is forked (may
+ *        be NULL). State it sets up is inherited by the child.
+ * @return -1 in a build child, which continues with the build; otherwise the
+ *         exit status of the watcher.
+ */
+int watch_main(void (*prepare)(void));
+
+/**
+ * @brief 1 in a build child started by watch_main.
+ */
+int watch_is_child(void);
+
+/**
+ * @brief Report a file the build read to the watcher (any thread; no-op
+ * outside a build child).
+ */
+void watch_note_input(const char *path);
+
+/**
+ * @brief Report that the build finished, so the watcher can show its latency.
+ */
+void watch_note_built(void);
+
+/**
+ * @brief In a build child, replace the process with the built program so the
+ * watcher can stop it on the next change. Returns if it cannot.
+ */
+void watch_exec(char *const argv[]);
+
+#endif
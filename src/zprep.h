@@ -13,6 +13,15 @@
 // ** ANSI COLORS **
 #include "utils/colors.h"
 
+// ** STRING INTERNING **
+#include "utils/intern.h"
+
+// ** COMPILER STATISTICS **
+#include "utils/stats.h"
+
+// ** BUILD CACHE **
+#include "utils/build_cache.h"
+
 // ** MEMORY OVERRIDES (Arena) **
 #define free(ptr) ((void)0)          ///< Free memory.
 #define malloc(sz) xmalloc(sz)       ///< Allocate memory.
@@ -90,10 +99,11 @@ typedef enum
 typedef struct
 {
     ZenTokenType type; ///< Type of the token.
-    const char *start; ///< Pointer to start of token in source buffer.
     int len;           ///< Length of the token text.
+    const char *start; ///< Pointer to start of token in source buffer.
     int line;          ///< Line number (1-based).
     int col;           ///< Column number (1-based).
+    InternedStr ident; ///< Interned text of a TOK_IDENT (NULL for other tokens).
 } Token;
 
 /**
@@ -101,11 +111,14 @@ typedef struct
  */
 typedef struct
 {
-    const char *src;   ///< Source code buffer.
-    int pos;           ///< Current position index.
-    int line;          ///< Current line number.
-    int col;           ///< Current column number.
-    int emit_comments; ///< 1 if comments should be emitted as tokens.
+    const char *src;         ///< Source code buffer.
+    int pos;                 ///< Current position index.
+    int line;                ///< Current line number.
+    int col;                 ///< Current column number.
+    int emit_comments;       ///< 1 if comments should be emitted as tokens.
+    struct TokenBuffer *buf; ///< Pre-lexed tokens, shared by copies of this lexer.
+    int cursor;              ///< Index in `buf` of the token after the current state.
+    int split;               ///< 1 after lexer_split_rangle (inside a '>>').
 } Lexer;
 
 /**
@@ -128,6 +141,29 @@ Token lexer_peek(Lexer *l);
  */
 Token lexer_peek2(Lexer *l);
 
+/**
+ * @brief Save the lexer position as a single integer (see lexer_rewind).
+ */
+int lexer_mark(Lexer *l);
+
+/**
+ * @brief Restore a position saved by lexer_mark on this lexer or a copy of it.
+ */
+void lexer_rewind(Lexer *l, int mark);
+
+/**
+ * @brief Consume the first '>' of a peeked '>>' (closing nested generics).
+ */
+void lexer_split_rangle(Lexer *l);
+
+/**
+ * @brief Scan the rest of the source into the token buffer up front.
+ *
+ * The lexer keeps its position. Afterwards it and its copies only read the
+ * buffer, so the scan can run on another thread than the parser.
+ */
+void lexer_prelex(Lexer *l);
+
 /**
  * @brief Register a trait.
  */
@@ -163,6 +199,12 @@ char *xstrdup(const char *s);
  */
 char *load_file(const char *filename);
 
+/**
+ * @brief Load a file like load_file, without recording it as an input of the build.
+ * @param len Receives the length of the file (may be NULL).
+ */
+char *load_file_untracked(const char *filename, size_t *len);
+
 // ** Buffer Size Constants **
 #define MAX_FLAGS_SIZE 1024
 #define MAX_PATH_SIZE 1024
@@ -210,6 +252,7 @@ typedef struct
     int repl_mode;       ///< 1 if --repl (internal flag for REPL usage).
     int is_freestanding; ///< 1 if --freestanding (no stdlib).
     int mode_transpile;  ///< 1 if 'transpile' command (to C).
+    int mode_watch;      ///< 1 if 'watch' command (rebuild when inputs change).
     int use_cpp;         ///< 1 if --cpp (emit C++ compatible code).
     int use_cuda;        ///< 1 if --cuda (emit CUDA-compatible code).
     int use_objc;        ///< 1 if --objc (emit Objective-C compatible code).
@@ -218,6 +261,20 @@ typedef struct
     int use_typecheck;   ///< 1 if --typecheck (enable manual semantic analysis).
 
     int keep_comments; ///< 1 if --keep-comments (preserve comments in output).
+    int mem_stats;     ///< 1 if --mem-stats (print per-region memory usage on exit).
+    int stats;         ///< 1 if --stats (print compiler work counters on exit).
+    int time_passes;   ///< 1 if --time-passes (print per-phase time and memory on exit).
+    int jobs;          ///< Worker threads from -j/--jobs (0 = one per CPU).
+    int no_cache;      ///< 1 if --no-cache (bypass the build cache).
+    int split_units;   ///< Units from --split-units (0 = one file, -1 = one per job).
+    int release;       ///< 1 if --release, 2 if --release=native (adds -march=native).
+    int pgo_gen;       ///< 1 if --pgo-gen (instrumented build writing profiles to pgo_dir).
+    int pgo_use;       ///< 1 if --pgo-use (optimize with the profiles in pgo_dir).
+    char *pgo_dir;     ///< Profile directory (NULL = the output's directory in the cache).
+    char *pgo_train;   ///< Training command of --pgo-train.
+    int dep_file;      ///< 1 if -MD (write the files the build read as a make rule).
+    char *dep_output;  ///< Dependency file from -MF (NULL = the output with a .d extension).
+    int dep_phony;     ///< 1 if -MP (add an empty rule for each dependency).
 
     // GCC Flags accumulator.
     char gcc_flags[4096]; ///< Flags passed to the backend compiler.
@@ -0,0 +1,194 @@
+#!/bin/bash
+
+# Driver Test Runner: how zc builds and runs programs (processes, caching, outputs).
+ZC="$(pwd)/zc"
+PASSED=0
+FAILED=0
+
+if [ ! -f "$ZC" ]; then
+    echo "Error: zc binary not found."
+    exit 1
+fi
+
+# Every test builds in a scratch directory with its own build cache.
+WORK=$(mktemp -d)
+export XDG_CACHE_HOME="$WORK/cache"
+trap 'rm -rf "$WORK"' EXIT
+
+pass() {
+    echo "PASS"
+    ((PASSED++))
+}
+
+fail() {
+    echo "FAIL ($1)"
+    ((FAILED++))
+}
+
+echo "** Running Driver Tests **"
+
+# Test 1: zc run ends when the reader of its output goes away
+echo -n "Testing zc run | head (SIGPIPE reaches the program)... "
+cat > "$WORK/forever.zc" <<'EOF'
+fn main() {
+    let i = 0;
+    while true {
+        println "line {i}";
+        i = i + 1;
+    }
+}
+EOF
+LINES=$(timeout 60 "$ZC" run -q "$WORK/forever.zc" 2>/dev/null | head -2)
+STATUS=${PIPESTATUS[0]}
+if [ "$STATUS" -eq 124 ]; then
+    fail "still running after the pipe closed"
+elif [ "$LINES" != $'line 0\nline 1' ]; then
+    fail "unexpected output: $LINES"
+else
+    pass
+fi
+
+# Test 2: the build cache reuses a build and notices source and flag changes
+echo -n "Testing build cache hits and misses... "
+printf 'fn main() {\n    println "one";\n}\n' > "$WORK/cached.zc"
+build_status() {
+    "$ZC" build "$WORK/cached.zc" -o "$WORK/cached" "$@" 2>&1 | grep -oE "Cached|Compiling"
+}
+FIRST=$(build_status)
+SECOND=$(build_status)
+printf 'fn main() {\n    println "two";\n}\n' > "$WORK/cached.zc"
+EDITED=$(build_status)
+EDITED_OUT=$("$WORK/cached")
+FLAGGED=$(build_status -O2)
+FLAGGED_AGAIN=$(build_status -O2)
+if [ "$FIRST" != "Compiling" ] || [ "$SECOND" != "Cached" ]; then
+    fail "second build was '$SECOND', expected Cached"
+elif [ "$EDITED" != "Compiling" ] || [ "$EDITED_OUT" != "two" ]; then
+    fail "source change was '$EDITED' and printed '$EDITED_OUT'"
+elif [ "$FLAGGED" != "Compiling" ] || [ "$FLAGGED_AGAIN" != "Cached" ]; then
+    fail "flag change was '$FLAGGED', then '$FLAGGED_AGAIN'"
+else
+    pass
+fi
+
+# Test 3: a program split into several C units links and runs
+echo -n "Testing --split-units build... "
+cat > "$WORK/split.zc" <<'EOF'
+import "std/vec.zc"
+
+struct Point {
+    x: int;
+    y: int;
+}
+
+fn add(a: Point, b: Point) -> Point {
+    return Point { x: a.x + b.x, y: a.y + b.y };
+}
+
+fn sum(v: Vec<int>) -> int {
+    let total = 0;
+    for i in 0..v.len {
+        total = total + v.get(i);
+    }
+    return total;
+}
+
+fn main() {
+    let v = Vec<int>::new();
+    for i in 1..5 {
+        v.push(i);
+    }
+    let p = add(Point { x: 1, y: 2 }, Point { x: 3, y: 4 });
+    println "{sum(v)} {p.x} {p.y}";
+}
+EOF
+LINK=$("$ZC" build --no-cache --split-units=3 -v "$WORK/split.zc" -o "$WORK/split" 2>&1 |
+       grep "Link")
+if ! echo "$LINK" | grep -qE "_0\.o .*_1\.o .*_2\.o"; then
+    fail "did not link three units: $LINK"
+elif [ "$("$WORK/split")" != "10 4 6" ]; then
+    fail "split binary printed '$("$WORK/split")'"
+else
+    pass
+fi
+
+# Test 4: zc watch rebuilds when an imported module or a config file changes
+echo -n "Testing zc watch rebuild on change... "
+mkdir -p "$WORK/watch"
+printf 'import "part.zc"\n\nfn main() {\n    println "v{part()}";\n}\n' > "$WORK/watch/main.zc"
+printf 'fn part() -> int {\n    return 1;\n}\n' > "$WORK/watch/part.zc"
+echo '{"c_functions": []}' > "$WORK/watch/zenc.json"
+# Configs are read from the working directory.
+(cd "$WORK/watch" && exec timeout 60 "$ZC" watch build main.zc -o watched > watch.log 2>&1) &
+WATCH_PID=$!
+# Wait (up to 30s) until the watched program prints $1.
+wait_for_output() {
+    for _ in $(seq 300); do
+        if [ -x "$WORK/watch/watched" ] && [ "$("$WORK/watch/watched" 2>/dev/null)" = "$1" ]; then
+            return 0
+        fi
+        sleep 0.1
+    done
+    return 1
+}
+# Wait (up to 30s) until the watcher reports a change to $1.
+wait_for_change() {
+    for _ in $(seq 300); do
+        if grep -q "Changed.*$1" "$WORK/watch/watch.log"; then
+            return 0
+        fi
+        sleep 0.1
+    done
+    return 1
+}
+if ! wait_for_output v1; then
+    fail "first build did not finish: $(cat "$WORK/watch/watch.log")"
+else
+    printf 'fn part() -> int {\n    return 2;\n}\n' > "$WORK/watch/part.zc"
+    if ! wait_for_output v2; then
+        fail "no rebuild after an import changed: $(cat "$WORK/watch/watch.log")"
+    else
+        echo '{"c_functions": ["puts"]}' > "$WORK/watch/zenc.json"
+        if ! wait_for_change zenc.json; then
+            fail "no rebuild after the config changed: $(cat "$WORK/watch/watch.log")"
+        else
+            pass
+        fi
+    fi
+fi
+kill "$WATCH_PID" 2>/dev/null
+wait "$WATCH_PID" 2>/dev/null
+
+# Test 5: -MD writes a make depfile with the imported std modules
+echo -n "Testing -MD/-MF/-MP depfile... "
+STD_DIR="$(pwd)/std"
+"$ZC" build "$WORK/split.zc" -o "$WORK/deps" -MD -MP -MF "$WORK/custom.d" > /dev/null 2>&1
+rm -f "$WORK/deps.d"
+"$ZC" build "$WORK/split.zc" -o "$WORK/deps" -MD > /dev/null 2>&1
+if [ ! -f "$WORK/custom.d" ]; then
+    fail "-MF did not write $WORK/custom.d"
+elif [ "$(head -1 "$WORK/custom.d")" != "$WORK/deps: \\" ]; then
+    fail "unexpected target line: $(head -1 "$WORK/custom.d")"
+elif ! grep -q "^ $STD_DIR/vec.zc" "$WORK/custom.d" ||
+     ! grep -q "^ $STD_DIR/mem.zc" "$WORK/custom.d"; then
+    fail "imported std modules missing: $(cat "$WORK/custom.d")"
+elif ! grep -qx "$STD_DIR/vec.zc:" "$WORK/custom.d" ||
+     ! grep -qx "$WORK/split.zc:" "$WORK/custom.d"; then
+    fail "-MP phony targets missing: $(cat "$WORK/custom.d")"
+elif ! grep -q "$STD_DIR/vec.zc" "$WORK/deps.d" 2>/dev/null; then
+    fail "cached build did not write $WORK/deps.d"
+else
+    pass
+fi
+
+echo "----------------------------------------"
+echo "Summary:"
+echo "-> Passed: $PASSED"
+echo "-> Failed: $FAILED"
+echo "----------------------------------------"
+
+if [ $FAILED -ne 0 ]; then
+    exit 1
+else
+    exit 0
+fi